@@ -1,5 +1,5 @@
 QT       += core gui
-QT        +=core gui widgets
+QT        +=core gui widgets concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -18,29 +18,21 @@ DEFINES += QT_DEPRECATED_WARNINGS
 
 SOURCES += \
     addbookdialog.cpp \
-    book.cpp \
-    comment.cpp \
+    booktablemodel.cpp \
     creditdialog.cpp \
-    database.cpp \
-    library.cpp \
     login.cpp \
     main.cpp \
     mainwindow.cpp \
-    user.cpp \
     usermanagerdialog.cpp
 
 HEADERS += \
     addbookdialog.h \
-    book.h \
-    comment.h \
+    booktablemodel.h \
     creditdialog.h \
-    database.h \
-    library.h \
     login.h \
     mainwindows.h \
-    user.h \
     usermanagerdialog.h
-QT      += sql
+include(core.pri)
 
 FORMS += \
     addbookdialog.ui \
@@ -12,44 +12,34 @@ Book::Book(const QString &isbn, const QString &title, const QString &author,
 {
 }
 
-bool Book::borrow()
+Book::RatingStats::RatingStats() : count(0), sum(0)
 {
-    if(m_availableCopies <= 0) return false;
-
-    m_availableCopies--;
-
-    // 更新数据库
-    Database::instance()->execute(
-        QString("UPDATE Books SET AvailableCopies = %1 WHERE ISBN = '%2'")
-        .arg(m_availableCopies).arg(m_isbn)
-    );
-
-    return true;
+    for(int i = 0; i < 5; ++i) histogram[i] = 0;
 }
 
-bool Book::returnBook()
+double Book::RatingStats::average() const
 {
-    if(m_availableCopies >= m_totalCopies) return false;
-
-    m_availableCopies++;
+    return count > 0 ? static_cast<double>(sum) / count : 0.0;
+}
 
-    // 更新数据库
-    Database::instance()->execute(
-        QString("UPDATE Books SET AvailableCopies = %1 WHERE ISBN = '%2'")
-        .arg(m_availableCopies).arg(m_isbn)
-    );
+Book::RatingStats Book::ratingStats() const
+{
+    return m_ratingStats;
+}
 
-    return true;
+void Book::setRatingStats(const RatingStats &stats)
+{
+    m_ratingStats = stats;
 }
 
 double Book::calculateAverageRating(const QString &isbn)
 {
-    QSqlQuery q = Database::instance()->executeQuery(
-        QString("SELECT AVG(Rating) FROM Comments WHERE ISBN = '%1'").arg(isbn)
-    );
+    // 读汇总表，不再对 Comments 做 AVG 扫描
+    QSqlRecord stats = Database::instance()->executePreparedRow("ratingStats.average",
+        "SELECT RatingSum, RatingCount FROM BookRatingStats WHERE ISBN = ?", {isbn});
 
-    if(q.next()) {
-        return q.value(0).toDouble();
+    if(!stats.isEmpty() && stats.value(1).toInt() > 0) {
+        return stats.value(0).toDouble() / stats.value(1).toInt();
     }
     return 0.0;
 }
@@ -28,11 +28,20 @@ public:
     int totalCopies() const;
     int availableCopies() const;
 
-    bool borrow();
-    bool returnBook();
     bool reserve();
     void cancelReservation();
 
+    // 评分汇总（来自 BookRatingStats 表），随查询结果一起返回
+    struct RatingStats {
+        int count;
+        int sum;
+        int histogram[5]; // 1~5 星各自的数量
+        RatingStats();
+        double average() const;
+    };
+    RatingStats ratingStats() const;
+    void setRatingStats(const RatingStats &stats);
+
     static double calculateAverageRating(const QString &isbn);
 
 private:
@@ -45,6 +54,7 @@ private:
     QString m_introduction;
     int m_totalCopies;
     int m_availableCopies;
+    RatingStats m_ratingStats;
 };
 
 #endif // BOOK_H
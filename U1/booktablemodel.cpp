@@ -0,0 +1,313 @@
+// src/booktablemodel.cpp
+#include "booktablemodel.h"
+#include "database.h"
+#include "entityloader.h"
+#include "catalogindex.h"
+#include "futurecontinuation.h"
+#include "startuptimer.h"
+#include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
+#include <QtConcurrent>
+#include <QDebug>
+
+// 各列排序使用的表达式；评分取平均分，四舍五入保证翻页时游标比较稳定
+static QString sortExpression(int column)
+{
+    switch(column) {
+    case BookTableModel::TitleColumn:
+        return "b.Title";
+    case BookTableModel::AuthorColumn:
+        return "b.Author";
+    case BookTableModel::AvailableColumn:
+        return "b.AvailableCopies";
+    case BookTableModel::RatingColumn:
+        return "ROUND(IFNULL(s.RatingSum * 1.0 / NULLIF(s.RatingCount, 0), 0), 4)";
+    default:
+        return "b.ISBN";
+    }
+}
+
+static BookTableModel::Row rowFromRecord(const QSqlRecord &record)
+{
+    BookTableModel::Row row;
+    row.isbn = record.value("ISBN").toString();
+    row.title = record.value("Title").toString();
+    row.author = record.value("Author").toString();
+    row.availableCopies = record.value("AvailableCopies").toInt();
+    row.ratingCount = record.value("RatingCount").toInt(); // 没有评论时为 NULL
+    row.ratingSum = record.value("RatingSum").toInt();
+    return row;
+}
+
+BookTableModel::BookTableModel(QThreadPool *workers, QObject *parent)
+    : QAbstractTableModel(parent), m_workers(workers), m_ranked(false), m_rankedOffset(0),
+      m_sortColumn(TitleColumn), m_sortOrder(Qt::AscendingOrder),
+      m_atEnd(true), m_loading(false), m_generation(0)
+{
+}
+
+void BookTableModel::search(const QString &keyword)
+{
+    m_keyword = keyword.trimmed();
+
+    // 与 Library::searchBooks 一致：索引就绪且有命中时按相关度，否则退回 LIKE
+    CatalogIndex *index = CatalogIndex::instance();
+    if(!m_keyword.isEmpty() && index->isReady()) {
+        QStringList isbns;
+        foreach (const CatalogIndex::Hit &hit, index->search(m_keyword, RankedLimit)) {
+            isbns << hit.isbn;
+        }
+        if(!isbns.isEmpty()) {
+            reset(true, isbns);
+            return;
+        }
+    }
+    reset(false, QStringList());
+}
+
+void BookTableModel::browse(int column, Qt::SortOrder order)
+{
+    m_keyword.clear();
+    m_sortColumn = column;
+    m_sortOrder = order;
+    reset(false, QStringList());
+}
+
+void BookTableModel::refresh()
+{
+    reset(m_ranked, m_rankedIsbns);
+}
+
+void BookTableModel::sort(int column, Qt::SortOrder order)
+{
+    if(column < 0 || column >= ColumnCount) return;
+
+    // 相关度结果要换排序时，改为按关键词过滤由数据库排序
+    m_sortColumn = column;
+    m_sortOrder = order;
+    reset(false, QStringList());
+}
+
+QString BookTableModel::isbnAt(int row) const
+{
+    if(row < 0 || row >= m_rows.size()) return QString();
+    return m_rows.at(row).isbn;
+}
+
+bool BookTableModel::isLoading() const
+{
+    return m_loading;
+}
+
+void BookTableModel::reset(bool ranked, const QStringList &rankedIsbns)
+{
+    beginResetModel();
+    ++m_generation;
+    m_rows.clear();
+    m_ranked = ranked;
+    m_rankedIsbns = rankedIsbns;
+    m_rankedOffset = 0;
+    m_atEnd = ranked && rankedIsbns.isEmpty();
+    setLoading(false); // 正在加载的旧页回来后会被丢弃
+    endResetModel();
+    emit sortChanged(ranked ? -1 : m_sortColumn, m_sortOrder);
+
+    // 视图只在滚动或布局变化时询问 canFetchMore，第一页主动加载
+    fetchMore(QModelIndex());
+}
+
+void BookTableModel::setLoading(bool loading)
+{
+    if(m_loading == loading) return;
+    m_loading = loading;
+    emit loadingChanged(loading);
+}
+
+int BookTableModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int BookTableModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant BookTableModel::data(const QModelIndex &index, int role) const
+{
+    if(!index.isValid() || index.row() >= m_rows.size()) return QVariant();
+
+    const Row &row = m_rows.at(index.row());
+    if(role == Qt::DisplayRole) {
+        switch(index.column()) {
+        case IsbnColumn:
+            return row.isbn;
+        case TitleColumn:
+            return row.title;
+        case AuthorColumn:
+            return row.author;
+        case AvailableColumn:
+            return row.availableCopies;
+        case RatingColumn: {
+            double rating = row.ratingCount > 0 ? double(row.ratingSum) / row.ratingCount : 0.0;
+            return QString::number(rating, 'f', 1);
+        }
+        default:
+            break;
+        }
+    } else if(role == Qt::TextAlignmentRole) {
+        if(index.column() == AvailableColumn || index.column() == RatingColumn) {
+            return int(Qt::AlignRight | Qt::AlignVCenter);
+        }
+    }
+    return QVariant();
+}
+
+QVariant BookTableModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if(orientation != Qt::Horizontal || role != Qt::DisplayRole) {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch(section) {
+    case IsbnColumn:
+        return "ISBN";
+    case TitleColumn:
+        return "书名";
+    case AuthorColumn:
+        return "作者";
+    case AvailableColumn:
+        return "可借数量";
+    case RatingColumn:
+        return "评分";
+    default:
+        return QVariant();
+    }
+}
+
+bool BookTableModel::canFetchMore(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_atEnd;
+}
+
+void BookTableModel::fetchMore(const QModelIndex &parent)
+{
+    if(parent.isValid() || m_atEnd || m_loading) return;
+
+    PageRequest request;
+    request.ranked = m_ranked;
+    request.keyword = m_keyword;
+    request.sortColumn = m_sortColumn;
+    request.sortOrder = m_sortOrder;
+    request.hasCursor = !m_rows.isEmpty();
+    if(request.hasCursor) {
+        request.cursorKey = m_rows.last().sortKey;
+        request.cursorIsbn = m_rows.last().isbn;
+    }
+    if(m_ranked) {
+        request.isbns = m_rankedIsbns.mid(m_rankedOffset, PageSize);
+    }
+
+    setLoading(true);
+    int generation = m_generation;
+    QFuture<Page> future = QtConcurrent::run(m_workers, &BookTableModel::loadPage, request);
+    whenFinished(future, this, [this, generation, request](const Page &page) {
+        if(generation != m_generation) return; // 模型已重置
+
+        setLoading(false);
+        StartupTimer::mark("first query");
+        if(!page.ok) {
+            m_atEnd = true;
+            return;
+        }
+
+        if(request.ranked) {
+            m_rankedOffset += request.isbns.size();
+            m_atEnd = m_rankedOffset >= m_rankedIsbns.size();
+        } else {
+            m_atEnd = page.rows.size() < PageSize;
+        }
+
+        if(!page.rows.isEmpty()) {
+            beginInsertRows(QModelIndex(), m_rows.size(), m_rows.size() + page.rows.size() - 1);
+            m_rows += page.rows;
+            endInsertRows();
+        }
+    });
+}
+
+// 在工作线程中执行，使用该线程自己的数据库连接
+BookTableModel::Page BookTableModel::loadPage(const PageRequest &request)
+{
+    if(request.ranked) return loadRankedPage(request);
+
+    Page page;
+    QString key = sortExpression(request.sortColumn);
+    bool ascending = request.sortOrder == Qt::AscendingOrder;
+    QString direction = ascending ? "ASC" : "DESC";
+    QString compare = ascending ? ">" : "<";
+    bool filtered = !request.keyword.isEmpty();
+
+    QStringList conditions;
+    QVariantList params;
+    if(filtered) {
+        QString pattern = QString("%%1%").arg(request.keyword);
+        conditions << "(b.Title LIKE ? OR b.Author LIKE ? OR b.ISBN LIKE ?)";
+        params << pattern << pattern << pattern;
+    }
+    if(request.hasCursor) {
+        // 键集分页：从上一页最后一行之后继续，ISBN 作为并列时的次序
+        if(request.sortColumn == IsbnColumn) {
+            conditions << QString("b.ISBN %1 ?").arg(compare);
+            params << request.cursorIsbn;
+        } else {
+            conditions << QString("(%1 %2 ? OR (%1 = ? AND b.ISBN %2 ?))").arg(key, compare);
+            params << request.cursorKey << request.cursorKey << request.cursorIsbn;
+        }
+    }
+    params << PageSize;
+
+    QString sql = QString("SELECT b.ISBN, b.Title, b.Author, b.AvailableCopies, s.RatingCount, s.RatingSum, "
+                          "%1 AS SortKey FROM Books b LEFT JOIN BookRatingStats s ON s.ISBN = b.ISBN ")
+            .arg(key);
+    if(!conditions.isEmpty()) {
+        sql += "WHERE " + conditions.join(" AND ") + " ";
+    }
+    sql += QString("ORDER BY %1 %2, b.ISBN %2 LIMIT ?").arg(key, direction);
+
+    // 每种排序/过滤/游标组合是一条独立的预处理语句
+    QString name = QString("books.page.%1.%2%3%4")
+            .arg(request.sortColumn)
+            .arg(ascending ? "asc" : "desc")
+            .arg(filtered ? ".filter" : "")
+            .arg(request.hasCursor ? ".next" : "");
+    QSqlQuery q = Database::instance()->executePreparedQuery(name, sql, params);
+    if(!q.isActive()) {
+        qDebug() << "Book page load error:" << q.lastError().text();
+        return page;
+    }
+
+    page.rows.reserve(PageSize);
+    while(q.next()) {
+        QSqlRecord record = q.record();
+        Row row = rowFromRecord(record);
+        row.sortKey = record.value("SortKey");
+        page.rows.append(row);
+    }
+    page.ok = true;
+    return page;
+}
+
+BookTableModel::Page BookTableModel::loadRankedPage(const PageRequest &request)
+{
+    Page page;
+    QHash<QString, QSqlRecord> records = EntityLoader::fetchBooks(request.isbns);
+    page.rows.reserve(request.isbns.size());
+    foreach (const QString &isbn, request.isbns) {
+        if(!records.contains(isbn)) continue; // 索引里有但已被删除
+        page.rows.append(rowFromRecord(records.value(isbn)));
+    }
+    page.ok = true;
+    return page;
+}
@@ -0,0 +1,105 @@
+// include/booktablemodel.h
+#ifndef BOOKTABLEMODEL_H
+#define BOOKTABLEMODEL_H
+
+#include <QAbstractTableModel>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+class QThreadPool;
+
+// 图书列表的惰性表格模型
+// 行在视图滚动到底部时按页异步加载（canFetchMore/fetchMore），单元格在 data() 中按需生成。
+// 浏览和关键词过滤走数据库键集分页，按书名/可借数量/评分排序由数据库完成；
+// 目录索引可用时，检索结果按相关度排列，分页按 ISBN 批量取行。
+class BookTableModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        IsbnColumn = 0,
+        TitleColumn,
+        AuthorColumn,
+        AvailableColumn,
+        RatingColumn,
+        ColumnCount
+    };
+
+    static const int PageSize = 200;
+    static const int RankedLimit = 5000; // 相关度检索最多保留的结果数
+
+    // 分页在 workers 上加载，传 Library::workerPool()
+    explicit BookTableModel(QThreadPool *workers, QObject *parent = nullptr);
+
+    // 关键词为空时浏览全部图书
+    void search(const QString &keyword);
+    // 浏览全部图书，按指定列排序
+    void browse(int column, Qt::SortOrder order);
+    // 保持当前检索条件重新加载（借还之后刷新可借数量）
+    void refresh();
+
+    QString isbnAt(int row) const;
+    bool isLoading() const;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    struct Row {
+        QString isbn;
+        QString title;
+        QString author;
+        int availableCopies;
+        int ratingCount;
+        int ratingSum;
+        QVariant sortKey; // 键集分页的游标值
+    };
+
+    struct Page {
+        QVector<Row> rows;
+        bool ok;
+        Page() : ok(false) {}
+    };
+
+    struct PageRequest {
+        bool ranked;
+        QString keyword;
+        int sortColumn;
+        Qt::SortOrder sortOrder;
+        bool hasCursor;
+        QVariant cursorKey;
+        QString cursorIsbn;
+        QStringList isbns; // 相关度模式下本页要取的 ISBN
+    };
+
+signals:
+    void loadingChanged(bool loading);
+    // column 为 -1 表示按相关度排列
+    void sortChanged(int column, Qt::SortOrder order);
+
+private:
+    void reset(bool ranked, const QStringList &rankedIsbns);
+    void setLoading(bool loading);
+    static Page loadPage(const PageRequest &request);
+    static Page loadRankedPage(const PageRequest &request);
+
+    QThreadPool *m_workers;
+    QVector<Row> m_rows;
+    bool m_ranked;
+    QStringList m_rankedIsbns;
+    int m_rankedOffset;
+    QString m_keyword;
+    int m_sortColumn;
+    Qt::SortOrder m_sortOrder;
+    bool m_atEnd;
+    bool m_loading;
+    int m_generation; // 每次重置加一，丢弃过期的页
+};
+
+#endif // BOOKTABLEMODEL_H
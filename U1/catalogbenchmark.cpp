@@ -0,0 +1,257 @@
+// src/catalogbenchmark.cpp
+#include "catalogbenchmark.h"
+#include "database.h"
+#include "storagebackend.h"
+#include "overdueengine.h"
+#include <QElapsedTimer>
+#include <QSqlRecord>
+#include <QStringList>
+#include <QDebug>
+
+// 测试数据：图书 ISBN 以 BENCH-CAT-/BENCH-ADD- 开头，读者 ID 以 Z1 开头
+static const char *BorrowerId = "Z10000";
+static const char *OverdueHolderId = "Z10001";
+static const int SeedBatchRows = 1000;
+// 借还热路径上的语句应当几乎都从缓存复用
+static const double MinCirculationHitRate = 0.9;
+
+// 书名由固定词表组合，搜索词在各规模下命中比例一致
+static const char *const TitleWords[] = {
+    "quantum", "history", "garden", "river", "machine", "poetry", "ocean", "empire",
+    "algebra", "winter", "shadow", "harvest", "signal", "orbit", "lantern", "compass"
+};
+static const int TitleWordCount = 16;
+
+CatalogBenchmark::Options::Options()
+    : minDurationMs(1000), keepData(false)
+{
+    catalogSizes << 10000 << 100000 << 1000000;
+}
+
+CatalogBenchmark::CatalogBenchmark(Library *library)
+    : m_library(library), m_added(0)
+{
+}
+
+QString CatalogBenchmark::borrowerId()
+{
+    return BorrowerId;
+}
+
+QString CatalogBenchmark::catalogIsbn(int n)
+{
+    return QString("BENCH-CAT-%1").arg(n, 7, 10, QChar('0'));
+}
+
+QString CatalogBenchmark::searchKeyword(int n)
+{
+    return TitleWords[n % TitleWordCount];
+}
+
+bool CatalogBenchmark::setUp()
+{
+    Database *db = Database::instance();
+    db->executePrepared("catbench.clearLoans",
+        "DELETE FROM BorrowRecords WHERE UserID IN (?, ?)",
+        {QString(BorrowerId), QString(OverdueHolderId)});
+    db->executePrepared("catbench.deleteUsers",
+        "DELETE FROM Users WHERE UserID IN (?, ?)",
+        {QString(BorrowerId), QString(OverdueHolderId)});
+
+    return db->executePrepared("catbench.insertUser",
+               "INSERT INTO Users (UserID, Email, Password, Name, Type, CreditScore) "
+               "VALUES (?, ?, 'bench', ?, 'Normal', 100)",
+               {QString(BorrowerId), QString("%1@bench.invalid").arg(BorrowerId), QString(BorrowerId)})
+        && db->executePrepared("catbench.insertUser",
+               "INSERT INTO Users (UserID, Email, Password, Name, Type, CreditScore) "
+               "VALUES (?, ?, 'bench', ?, 'Normal', 100)",
+               {QString(OverdueHolderId), QString("%1@bench.invalid").arg(OverdueHolderId), QString(OverdueHolderId)});
+}
+
+// 只补齐缺少的部分，多行 INSERT 每批 SeedBatchRows 行
+bool CatalogBenchmark::seedCatalog(int size, QTextStream &out)
+{
+    Database *db = Database::instance();
+    int existing = 0;
+    QSqlRecord count = db->executePreparedRow("catbench.count",
+        "SELECT COUNT(*) FROM Books WHERE ISBN LIKE 'BENCH-CAT-%'");
+    if(!count.isEmpty()) existing = count.value(0).toInt();
+
+    QElapsedTimer timer;
+    timer.start();
+    for(int start = existing; start < size; start += SeedBatchRows) {
+        int rows = qMin(SeedBatchRows, size - start);
+        QStringList values;
+        values.reserve(rows);
+        for(int i = start; i < start + rows; ++i) {
+            values << QString("('BENCH-CAT-%1', '%2 %3 %4', 'Bench Author %5', 5, 5)")
+                      .arg(i, 7, 10, QChar('0'))
+                      .arg(TitleWords[i % TitleWordCount])
+                      .arg(TitleWords[(i / TitleWordCount) % TitleWordCount])
+                      .arg(i)
+                      .arg(i % 1000);
+        }
+        if(!db->execute("INSERT INTO Books (ISBN, Title, Author, TotalCopies, AvailableCopies) VALUES "
+                        + values.join(','))) {
+            return false;
+        }
+    }
+
+    out << "phase=seed catalog=" << size << " inserted=" << qMax(0, size - existing)
+        << " ms=" << timer.elapsed() << '\n';
+    return true;
+}
+
+// 5% 的馆藏处于在借逾期状态，其中一半超过30天，全部记在同一个测试读者名下
+bool CatalogBenchmark::seedOverdueLoans(int count)
+{
+    Database *db = Database::instance();
+    QDate today = QDate::currentDate();
+    return db->executePrepared("catbench.clearOverdue",
+               "DELETE FROM BorrowRecords WHERE UserID = ?", {QString(OverdueHolderId)})
+        && db->executePrepared("catbench.seedOverdue",
+               "INSERT INTO BorrowRecords (UserID, ISBN, BorrowDate, DueDate) "
+               "SELECT ?, ISBN, ?, CASE WHEN SUBSTR(ISBN, 11) % 2 = 0 THEN ? ELSE ? END "
+               "FROM Books WHERE ISBN LIKE 'BENCH-CAT-%' ORDER BY ISBN LIMIT ?",
+               {QString(OverdueHolderId), today.addDays(-60), today.addDays(-45), today.addDays(-3), count});
+}
+
+void CatalogBenchmark::tearDown()
+{
+    Database *db = Database::instance();
+    db->executePrepared("catbench.clearLoans",
+        "DELETE FROM BorrowRecords WHERE UserID IN (?, ?)",
+        {QString(BorrowerId), QString(OverdueHolderId)});
+    db->executePrepared("catbench.deleteUsers",
+        "DELETE FROM Users WHERE UserID IN (?, ?)",
+        {QString(BorrowerId), QString(OverdueHolderId)});
+    db->executePrepared("catbench.deleteAdded",
+        "DELETE FROM Books WHERE ISBN LIKE 'BENCH-ADD-%'");
+}
+
+void CatalogBenchmark::deleteCatalog()
+{
+    Database::instance()->executePrepared("catbench.deleteCatalog",
+        "DELETE FROM Books WHERE ISBN LIKE 'BENCH-CAT-%'");
+}
+
+void CatalogBenchmark::report(const QString &name, int catalogSize, qint64 iterations,
+                              qint64 nanoseconds, int failures, QTextStream &out)
+{
+    double msPerOp = iterations > 0 ? nanoseconds / 1e6 / iterations : 0.0;
+    double opsPerSecond = nanoseconds > 0 ? iterations * 1e9 / nanoseconds : 0.0;
+    out << "benchmark=" << name
+        << " catalog=" << catalogSize
+        << " iterations=" << iterations
+        << " ms_per_op=" << QString::number(msPerOp, 'f', 3)
+        << " ops_per_s=" << QString::number(opsPerSecond, 'f', 1)
+        << " failures=" << failures << '\n';
+    out.flush();
+}
+
+void CatalogBenchmark::measure(const QString &name, int catalogSize, int minDurationMs,
+                               const std::function<bool()> &operation, QTextStream &out)
+{
+    // 先执行一次预热（准备语句、填充缓存），不计入结果
+    operation();
+
+    qint64 iterations = 0;
+    qint64 nanoseconds = 0;
+    int failures = 0;
+    for(int batch = 1; nanoseconds < qint64(minDurationMs) * 1000000; batch *= 2) {
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < batch; ++i) {
+            if(!operation()) failures++;
+        }
+        nanoseconds += timer.nsecsElapsed();
+        iterations += batch;
+    }
+    report(name, catalogSize, iterations, nanoseconds, failures, out);
+}
+
+// 借和还交替执行，分别计时；每次借的是不同的书，避免只命中一行
+// 同时统计这段时间预编译语句缓存的命中率，低于 MinCirculationHitRate 判为失败
+bool CatalogBenchmark::measureCirculation(int catalogSize, int minDurationMs, QTextStream &out)
+{
+    Database::StatementCacheStats before = Database::instance()->statementCacheStats();
+    qint64 iterations = 0;
+    qint64 borrowNs = 0;
+    qint64 returnNs = 0;
+    int borrowFailures = 0;
+    int returnFailures = 0;
+    QElapsedTimer total;
+    total.start();
+    while(total.elapsed() < minDurationMs) {
+        QString isbn = catalogIsbn(int(iterations % catalogSize));
+        QElapsedTimer timer;
+        timer.start();
+        if(!m_library->borrowBook(BorrowerId, isbn)) borrowFailures++;
+        borrowNs += timer.nsecsElapsed();
+        timer.restart();
+        if(!m_library->returnBook(BorrowerId, isbn)) returnFailures++;
+        returnNs += timer.nsecsElapsed();
+        iterations++;
+    }
+    report("borrowBook", catalogSize, iterations, borrowNs, borrowFailures, out);
+    report("returnBook", catalogSize, iterations, returnNs, returnFailures, out);
+
+    // 不缓存语句的后端（SQLite）没有命中数，跳过校验
+    Database::StatementCacheStats after = Database::instance()->statementCacheStats();
+    quint64 hits = after.hits - before.hits;
+    quint64 lookups = hits + after.misses - before.misses;
+    double hitRate = lookups ? double(hits) / lookups : 0.0;
+    bool ok = lookups == 0 || hitRate >= MinCirculationHitRate;
+    out << "benchmark=circulationStatementCache catalog=" << catalogSize
+        << " lookups=" << lookups
+        << " hit_rate=" << QString::number(hitRate, 'f', 4)
+        << " check=" << (lookups == 0 ? "SKIP" : ok ? "PASS" : "FAIL") << '\n';
+    out.flush();
+    return ok;
+}
+
+bool CatalogBenchmark::run(const Options &options, QTextStream &out)
+{
+    out << "backend=" << Database::instance()->backend()->name() << '\n';
+    if(!setUp()) {
+        out << "error=setup_failed" << '\n';
+        tearDown();
+        return false;
+    }
+
+    bool ok = true;
+    foreach (int size, options.catalogSizes) {
+        if(!seedCatalog(size, out) || !seedOverdueLoans(size / 20)) {
+            out << "catalog=" << size << " error=seed_failed" << '\n';
+            ok = false;
+            break;
+        }
+
+        int query = 0;
+        measure("searchBooks", size, options.minDurationMs, [this, &query]() {
+            m_library->searchBooks(searchKeyword(query++));
+            return true;
+        }, out);
+        measure("getTopRatedBooks", size, options.minDurationMs, [this]() {
+            m_library->getTopRatedBooks(10);
+            return true;
+        }, out);
+        if(!measureCirculation(size, options.minDurationMs, out)) ok = false;
+        measure("addBook", size, options.minDurationMs, [this]() {
+            QString isbn = QString("BENCH-ADD-%1").arg(m_added++, 7, 10, QChar('0'));
+            return m_library->addBook(isbn, "Added Benchmark Book", "Bench Author", 1);
+        }, out);
+        // checkOverdueBooks 的工作全部在 OverdueEngine 中；演练模式执行完整批处理后回滚
+        measure("checkOverdueBooks", size, options.minDurationMs, []() {
+            return OverdueEngine::run(QDate::currentDate(), true).ok;
+        }, out);
+    }
+
+    tearDown();
+    if(!options.keepData) {
+        deleteCatalog();
+    }
+    out << "result=" << (ok ? "DONE" : "FAIL") << '\n';
+    out.flush();
+    return ok;
+}
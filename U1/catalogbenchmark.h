@@ -0,0 +1,55 @@
+// include/catalogbenchmark.h
+#ifndef CATALOGBENCHMARK_H
+#define CATALOGBENCHMARK_H
+
+#include <QList>
+#include <QString>
+#include <QTextStream>
+#include <functional>
+#include "library.h"
+
+// 馆藏规模压测（命令行工具 corebench，只链接无界面的核心库）
+// 按 1万/10万/100万 册逐级补齐测试图书，每档测量 searchBooks、getTopRatedBooks、
+// borrowBook、returnBook、addBook 和逾期批处理的单次耗时。
+// 与 QBENCHMARK 相同的做法：批量重复执行、批次翻倍直到总时长达到下限。
+// 每行输出一条 key=value 结果，便于脚本解析。结束后清理测试数据。
+// 借还期间预编译语句缓存命中率低于 0.9 时 run() 返回 false。
+// 准备测试数据的几步也供 tests/ 下的 QtTest 程序使用。
+class CatalogBenchmark
+{
+public:
+    struct Options {
+        QList<int> catalogSizes;
+        int minDurationMs;   // 每项测量的最短总时长
+        bool keepData;       // 保留测试图书，下次运行免去补齐
+        Options();
+    };
+
+    explicit CatalogBenchmark(Library *library);
+
+    bool run(const Options &options, QTextStream &out);
+
+    // 测试读者和测试图书
+    bool setUp();
+    bool seedCatalog(int size, QTextStream &out);
+    bool seedOverdueLoans(int count);
+    void tearDown();
+    // 删除 seedCatalog 补齐的测试图书
+    void deleteCatalog();
+    static QString borrowerId();
+    static QString catalogIsbn(int n);      // 第 n 本测试图书
+    static QString searchKeyword(int n);    // 轮流取书名词表里的词
+
+private:
+
+    void measure(const QString &name, int catalogSize, int minDurationMs,
+                 const std::function<bool()> &operation, QTextStream &out);
+    bool measureCirculation(int catalogSize, int minDurationMs, QTextStream &out);
+    static void report(const QString &name, int catalogSize, qint64 iterations,
+                       qint64 nanoseconds, int failures, QTextStream &out);
+
+    Library *m_library;
+    int m_added;
+};
+
+#endif // CATALOGBENCHMARK_H
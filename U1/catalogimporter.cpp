@@ -0,0 +1,724 @@
+// src/catalogimporter.cpp
+#include "catalogimporter.h"
+#include "database.h"
+#include "storagebackend.h"
+#include "entitycache.h"
+#include "copyinventory.h"
+#include "reservationqueue.h"
+#include "catalogindex.h"
+#include "completiontrie.h"
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QSqlQuery>
+#include <QTextStream>
+#include <QElapsedTimer>
+#include <QtConcurrent>
+#include <QDebug>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CATALOG_IMPORT_SSE2
+#include <emmintrin.h>
+#endif
+
+// ISO 2709 结构字符
+static const char RecordTerminator = 0x1D;
+static const char FieldTerminator = 0x1E;
+static const char SubfieldDelimiter = 0x1F;
+
+static const int MaxRowsPerStatement = 500;
+static const int BookColumns = 9;
+static const int CopyColumns = 2;
+static const int MaxCopiesPerTitle = 1000;
+
+// 返回 [p, end) 中第一个等于 c 的位置，没有时返回 end
+static const char *scanByte(const char *p, const char *end, char c)
+{
+#ifdef CATALOG_IMPORT_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+    while(end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(block, needle));
+        if(mask) return p + qCountTrailingZeroBits(quint32(mask));
+        p += 16;
+    }
+#endif
+    while(p < end && *p != c) ++p;
+    return p;
+}
+
+// 非引号字段的结束位置：逗号、回车或换行
+static const char *scanFieldEnd(const char *p, const char *end)
+{
+#ifdef CATALOG_IMPORT_SSE2
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+    while(end - p >= 16) {
+        __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(block, comma),
+                                    _mm_or_si128(_mm_cmpeq_epi8(block, cr),
+                                                 _mm_cmpeq_epi8(block, lf)));
+        int mask = _mm_movemask_epi8(hits);
+        if(mask) return p + qCountTrailingZeroBits(quint32(mask));
+        p += 16;
+    }
+#endif
+    while(p < end && *p != ',' && *p != '\r' && *p != '\n') ++p;
+    return p;
+}
+
+// 支持完整日期、年月或只有年份
+static QDate parseDate(const QString &text)
+{
+    static const char *formats[] = { "yyyy-MM-dd", "yyyy/MM/dd", "yyyy.MM.dd", "yyyy-MM", "yyyy" };
+    for(const char *format : formats) {
+        QDate date = QDate::fromString(text, format);
+        if(date.isValid()) return date;
+    }
+    return QDate();
+}
+
+// 从 "CNY35.00"、"¥35" 之类的文本中取出数字部分
+static QString extractNumber(const QString &text)
+{
+    int start = 0;
+    while(start < text.size() && !text[start].isDigit()) ++start;
+    int end = start;
+    while(end < text.size() && (text[end].isDigit() || text[end] == '.')) ++end;
+    return text.mid(start, end - start);
+}
+
+CatalogImporter::Options::Options()
+    : format(AutoDetect), transactionTitles(10000)
+{
+}
+
+CatalogImporter::Report::Report()
+    : ok(false), parsed(0), imported(0), merged(0), copies(0), held(0), rejected(0),
+      parseMs(0), validateMs(0), writeMs(0), totalMs(0), titlesPerMinute(0.0)
+{
+}
+
+CatalogImporter::CatalogImporter(const Options &options)
+    : m_options(options)
+{
+    if(m_options.transactionTitles < 1) m_options.transactionTitles = 1;
+}
+
+void CatalogImporter::setProgressCallback(const ProgressCallback &callback)
+{
+    m_progress = callback;
+}
+
+CatalogImporter::Report CatalogImporter::importFile(const QString &path)
+{
+    QFile file(path);
+    if(!file.open(QIODevice::ReadOnly)) {
+        qDebug() << "Cannot open catalog file:" << path << file.errorString();
+        return Report();
+    }
+
+    // 优先内存映射，避免把整个文件再复制一份
+    QByteArray data;
+    uchar *mapped = file.size() > 0 ? file.map(0, file.size()) : nullptr;
+    if(mapped) {
+        data = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), int(file.size()));
+    } else {
+        data = file.readAll();
+    }
+
+    Format format = m_options.format;
+    if(format == AutoDetect) {
+        QString suffix = QFileInfo(path).suffix().toLower();
+        if(suffix == "mrc" || suffix == "marc" || suffix == "iso") {
+            format = Marc;
+        } else if(suffix == "csv" || suffix == "txt") {
+            format = Csv;
+        }
+    }
+
+    if(m_options.rejectReportPath.isEmpty()) {
+        m_options.rejectReportPath = path + ".rejects.csv";
+    }
+    return importData(data, format);
+}
+
+CatalogImporter::Report CatalogImporter::importData(const QByteArray &data, Format format)
+{
+    Report report;
+    QElapsedTimer total;
+    total.start();
+
+    // 未指定格式时看记录头：前5字节是记录长度且含记录结束符的按 MARC 处理
+    if(format == AutoDetect) {
+        bool lengthPrefix = data.size() >= 24;
+        for(int i = 0; lengthPrefix && i < 5; ++i) {
+            lengthPrefix = data[i] >= '0' && data[i] <= '9';
+        }
+        format = lengthPrefix && data.contains(RecordTerminator) ? Marc : Csv;
+    }
+
+    QElapsedTimer phase;
+    phase.start();
+    QVector<Row> rows = format == Marc ? parseMarc(data) : parseCsv(data);
+    report.parsed = rows.size();
+    report.parseMs = phase.restart();
+
+    QVector<Row> accepted = validate(rows, report);
+    rows.clear();
+    if(!matchStoredIsbns(accepted)) {
+        report.validateMs = phase.elapsed();
+        report.totalMs = total.elapsed();
+        return report;
+    }
+    report.validateMs = phase.restart();
+
+    report.ok = write(accepted, report);
+    report.writeMs = phase.elapsed();
+
+    report.rejected = report.rejects.size();
+    report.totalMs = total.elapsed();
+    if(report.totalMs > 0) {
+        report.titlesPerMinute = report.imported * 60000.0 / report.totalMs;
+    }
+
+    if(report.imported > 0) {
+        EntityCache::instance()->invalidateAllBooks();
+        CopyInventory::instance()->invalidateAll();
+        // 索引已构建时在导入线程上重建（复用本线程的连接）；命令行导入时索引尚未构建，跳过
+        if(CatalogIndex::instance()->isReady()) CatalogIndex::instance()->rebuild();
+        if(CompletionTrie::instance()->isReady()) CompletionTrie::instance()->rebuild();
+    }
+
+    if(!report.rejects.isEmpty() && !m_options.rejectReportPath.isEmpty()) {
+        if(writeRejectReport(report)) report.rejectReportPath = m_options.rejectReportPath;
+    }
+    return report;
+}
+
+QString CatalogImporter::normalizeIsbn(const QString &raw)
+{
+    // 取第一段数字，允许 "ISBN " 前缀、连字符和空格，遇到 "(pbk.)" 之类的后缀停止
+    QString digits;
+    for(QChar c : raw) {
+        if(c.isDigit()) {
+            digits.append(c);
+        } else if((c == 'X' || c == 'x') && digits.size() == 9) {
+            digits.append('X');
+        } else if(c == '-' || c == ' ') {
+            continue;
+        } else if(!digits.isEmpty()) {
+            break;
+        }
+    }
+
+    if(digits.size() == 10) {
+        int sum = 0;
+        for(int i = 0; i < 10; ++i) {
+            int value = digits[i] == 'X' ? 10 : digits[i].digitValue();
+            if(value == 10 && i != 9) return QString();
+            sum += value * (10 - i);
+        }
+        return sum % 11 == 0 ? digits : QString();
+    }
+    if(digits.size() == 13) {
+        int sum = 0;
+        for(int i = 0; i < 13; ++i) {
+            sum += digits[i].digitValue() * (i % 2 == 0 ? 1 : 3);
+        }
+        return sum % 10 == 0 ? digits : QString();
+    }
+    return QString();
+}
+
+// CSV：逐字段扫描，引号字段中的 "" 还原为 "，字段可以跨行
+QVector<CatalogImporter::Row> CatalogImporter::parseCsv(const QByteArray &data)
+{
+    enum Column { IsbnColumn, TitleColumn, AuthorColumn, PublisherColumn, DateColumn,
+                  PriceColumn, CopiesColumn, IntroColumn, ColumnCount };
+    static const char *const aliases[ColumnCount][5] = {
+        { "isbn", nullptr },
+        { "title", "书名", nullptr },
+        { "author", "作者", nullptr },
+        { "publisher", "出版社", nullptr },
+        { "publishdate", "publish_date", "date", "出版日期", nullptr },
+        { "price", "价格", nullptr },
+        { "copies", "totalcopies", "册数", nullptr },
+        { "introduction", "description", "简介", nullptr }
+    };
+
+    QVector<Row> rows;
+    rows.reserve(data.size() / 100);
+
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    if(end - p >= 3 && uchar(p[0]) == 0xEF && uchar(p[1]) == 0xBB && uchar(p[2]) == 0xBF) {
+        p += 3; // UTF-8 BOM
+    }
+
+    // 没有列名行时按 ISBN,书名,作者,出版社,出版日期,价格,册数,简介 的顺序
+    int columns[ColumnCount];
+    for(int i = 0; i < ColumnCount; ++i) columns[i] = i;
+
+    bool firstRecord = true;
+    int rowNumber = 0;
+    QStringList fields;
+    QByteArray quoted;
+    while(p < end) {
+        fields.clear();
+        bool unterminated = false;
+        while(true) {
+            if(p < end && *p == '"') {
+                quoted.clear();
+                ++p;
+                while(true) {
+                    const char *q = scanByte(p, end, '"');
+                    quoted.append(p, int(q - p));
+                    if(q >= end) {
+                        unterminated = true;
+                        p = end;
+                        break;
+                    }
+                    if(q + 1 < end && q[1] == '"') {
+                        quoted.append('"');
+                        p = q + 2;
+                        continue;
+                    }
+                    p = q + 1;
+                    break;
+                }
+                // 闭合引号和分隔符之间的多余字符原样保留
+                const char *s = scanFieldEnd(p, end);
+                quoted.append(p, int(s - p));
+                p = s;
+                fields << QString::fromUtf8(quoted).trimmed();
+            } else {
+                const char *s = scanFieldEnd(p, end);
+                fields << QString::fromUtf8(p, int(s - p)).trimmed();
+                p = s;
+            }
+            if(p < end && *p == ',') {
+                ++p;
+                continue;
+            }
+            break;
+        }
+        if(p < end && *p == '\r') ++p;
+        if(p < end && *p == '\n') ++p;
+        ++rowNumber;
+
+        if(fields.size() == 1 && fields[0].isEmpty()) continue; // 空行
+
+        if(firstRecord) {
+            firstRecord = false;
+            int mapped[ColumnCount];
+            bool isHeader = false;
+            for(int c = 0; c < ColumnCount; ++c) {
+                mapped[c] = -1;
+                for(int i = 0; i < fields.size() && mapped[c] < 0; ++i) {
+                    QString name = fields[i].toLower().remove(' ');
+                    for(int a = 0; aliases[c][a]; ++a) {
+                        if(name == QString::fromUtf8(aliases[c][a])) {
+                            mapped[c] = i;
+                            break;
+                        }
+                    }
+                }
+            }
+            isHeader = mapped[IsbnColumn] >= 0 && mapped[TitleColumn] >= 0;
+            if(isHeader) {
+                for(int c = 0; c < ColumnCount; ++c) columns[c] = mapped[c];
+                continue;
+            }
+        }
+
+        auto field = [&](int column) {
+            return columns[column] >= 0 ? fields.value(columns[column]) : QString();
+        };
+        Row row;
+        row.row = rowNumber;
+        row.isbn = field(IsbnColumn);
+        row.title = field(TitleColumn);
+        row.author = field(AuthorColumn);
+        row.publisher = field(PublisherColumn);
+        QString date = field(DateColumn);
+        row.publishDate = parseDate(date);
+        row.price = field(PriceColumn);
+        row.introduction = field(IntroColumn);
+        QString copies = field(CopiesColumn);
+        bool copiesOk = true;
+        row.copies = copies.isEmpty() ? 1 : copies.toInt(&copiesOk);
+        if(!copiesOk) row.copies = -1;
+        if(unterminated) {
+            row.error = "unterminated quoted field";
+        } else if(!date.isEmpty() && !row.publishDate.isValid()) {
+            row.error = "invalid publish date";
+        }
+        rows.append(row);
+    }
+    return rows;
+}
+
+// MARC：按记录结束符切分后并行解析，每条记录互不依赖
+QVector<CatalogImporter::Row> CatalogImporter::parseMarc(const QByteArray &data)
+{
+    QVector<QByteArray> records;
+    records.reserve(data.size() / 800);
+    const char *p = data.constData();
+    const char *end = p + data.size();
+    while(p < end) {
+        const char *q = scanByte(p, end, RecordTerminator);
+        // 跳过记录之间的换行
+        const char *start = p;
+        while(start < q && (*start == '\r' || *start == '\n')) ++start;
+        if(q > start) records.append(QByteArray::fromRawData(start, int(q - start)));
+        p = q + 1;
+    }
+
+    QVector<Row> rows(records.size());
+    QVector<int> indexes(records.size());
+    for(int i = 0; i < indexes.size(); ++i) indexes[i] = i;
+    Row *out = rows.data();
+    QtConcurrent::blockingMap(indexes, [&records, out](int i) {
+        out[i] = parseMarcRecord(records.at(i), i + 1);
+    });
+    return rows;
+}
+
+// 取数据字段中第一个指定代码的子字段
+static QString subfield(const QByteArray &field, char code)
+{
+    int pos = field.indexOf(SubfieldDelimiter);
+    while(pos >= 0 && pos + 1 < field.size()) {
+        int next = field.indexOf(SubfieldDelimiter, pos + 1);
+        if(field[pos + 1] == code) {
+            int length = (next < 0 ? field.size() : next) - pos - 2;
+            return QString::fromUtf8(field.constData() + pos + 2, length).trimmed();
+        }
+        pos = next;
+    }
+    return QString();
+}
+
+// 去掉 ISBD 著录用的结尾标点，例如 "书名 /"、"出版社,"
+static QString stripIsbd(QString text)
+{
+    while(!text.isEmpty() && QString(" /:;,.=").contains(text.at(text.size() - 1))) {
+        text.chop(1);
+    }
+    return text;
+}
+
+CatalogImporter::Row CatalogImporter::parseMarcRecord(const QByteArray &record, int index)
+{
+    Row row;
+    row.row = index;
+    row.copies = 0;
+
+    // 记录头24字节，12-16为数据起始地址；目录每项12字节：标签3 + 长度4 + 起始位置5
+    if(record.size() < 25) {
+        row.error = "truncated MARC record";
+        return row;
+    }
+    bool ok = false;
+    int base = record.mid(12, 5).toInt(&ok);
+    if(!ok || base <= 24 || base > record.size()) {
+        row.error = "invalid MARC base address";
+        return row;
+    }
+
+    QString price;
+    for(int entry = 24; entry + 12 <= base - 1; entry += 12) {
+        QByteArray tag = record.mid(entry, 3);
+        bool lengthOk = false, startOk = false;
+        int length = record.mid(entry + 3, 4).toInt(&lengthOk);
+        int start = record.mid(entry + 7, 5).toInt(&startOk);
+        if(!lengthOk || !startOk || base + start + length > record.size()) {
+            row.error = "malformed MARC directory";
+            return row;
+        }
+        QByteArray field = QByteArray::fromRawData(record.constData() + base + start, length);
+        if(field.endsWith(FieldTerminator)) field.chop(1);
+
+        if(tag == "020") {
+            if(row.isbn.isEmpty()) row.isbn = subfield(field, 'a');
+            if(price.isEmpty()) price = extractNumber(subfield(field, 'c'));
+        } else if(tag == "245") {
+            QString title = stripIsbd(subfield(field, 'a'));
+            QString remainder = stripIsbd(subfield(field, 'b'));
+            row.title = remainder.isEmpty() ? title : title + " : " + remainder;
+        } else if(tag == "100" || tag == "110" || tag == "700") {
+            if(row.author.isEmpty()) row.author = stripIsbd(subfield(field, 'a'));
+        } else if(tag == "260" || tag == "264") {
+            if(row.publisher.isEmpty()) row.publisher = stripIsbd(subfield(field, 'b'));
+            if(!row.publishDate.isValid()) {
+                QString year = extractNumber(subfield(field, 'c')).left(4);
+                row.publishDate = parseDate(year);
+            }
+        } else if(tag == "520") {
+            if(row.introduction.isEmpty()) row.introduction = subfield(field, 'a');
+        } else if(tag == "852") {
+            // 每个馆藏字段对应一册
+            row.copies++;
+        }
+    }
+    row.price = price;
+    if(row.copies == 0) row.copies = 1;
+    return row;
+}
+
+void CatalogImporter::validateRow(Row &row)
+{
+    if(!row.error.isEmpty()) return;
+
+    QString isbn = normalizeIsbn(row.isbn);
+    if(isbn.isEmpty()) {
+        row.error = row.isbn.isEmpty() ? "missing ISBN" : "invalid ISBN checksum";
+        return;
+    }
+    row.isbn = isbn;
+
+    if(row.title.isEmpty()) {
+        row.error = "missing title";
+    } else if(row.title.size() > 255) {
+        row.error = "title longer than 255 characters";
+    } else if(row.author.isEmpty()) {
+        row.error = "missing author";
+    } else if(row.author.size() > 100) {
+        row.error = "author longer than 100 characters";
+    } else if(row.publisher.size() > 100) {
+        row.error = "publisher longer than 100 characters";
+    } else if(row.copies < 1 || row.copies > MaxCopiesPerTitle) {
+        row.error = "copies must be between 1 and 1000";
+    } else if(!row.price.isEmpty()) {
+        bool ok = false;
+        double price = row.price.toDouble(&ok);
+        if(!ok || price < 0) row.error = "invalid price";
+    }
+}
+
+QVector<CatalogImporter::Row> CatalogImporter::validate(QVector<Row> &rows, Report &report)
+{
+    QtConcurrent::blockingMap(rows, &CatalogImporter::validateRow);
+
+    // 同一 ISBN 出现多次时合并为一行，册数相加
+    QVector<Row> accepted;
+    accepted.reserve(rows.size());
+    QHash<QString, int> positions;
+    positions.reserve(rows.size());
+    for(const Row &row : rows) {
+        if(!row.error.isEmpty()) {
+            report.rejects.append({row.row, row.isbn, row.error});
+            continue;
+        }
+        auto it = positions.constFind(row.isbn);
+        if(it == positions.constEnd()) {
+            positions.insert(row.isbn, accepted.size());
+            accepted.append(row);
+        } else {
+            Row &existing = accepted[it.value()];
+            if(existing.copies + row.copies > MaxCopiesPerTitle) {
+                report.rejects.append({row.row, row.isbn, "copies must be between 1 and 1000"});
+                continue;
+            }
+            existing.copies += row.copies;
+            report.merged++;
+        }
+    }
+    return accepted;
+}
+
+// 导入的 ISBN 已去掉连字符和空格，而 addBook 按输入原样保存。库里带连字符或空格的 ISBN
+// 规范化后与导入行相同时，导入行改用库里的写法，写库时命中已有的图书
+bool CatalogImporter::matchStoredIsbns(QVector<Row> &rows)
+{
+    QSqlQuery q(Database::instance()->connection());
+    q.setForwardOnly(true);
+    if(!q.exec("SELECT ISBN FROM Books WHERE ISBN LIKE '%-%' OR ISBN LIKE '% %'")) {
+        qDebug() << "Import: load stored ISBNs failed" << q.lastError().text();
+        return false;
+    }
+    QHash<QString, QString> stored;     // 规范化的 ISBN -> 库里的写法
+    while(q.next()) {
+        QString isbn = q.value(0).toString();
+        QString normalized = normalizeIsbn(isbn);
+        if(!normalized.isEmpty() && !stored.contains(normalized)) stored.insert(normalized, isbn);
+    }
+    if(stored.isEmpty()) return true;
+
+    for(Row &row : rows) {
+        auto it = stored.constFind(row.isbn);
+        if(it != stored.constEnd()) row.isbn = it.value();
+    }
+    return true;
+}
+
+bool CatalogImporter::write(const QVector<Row> &rows, Report &report)
+{
+    bool ok = true;
+    const int total = rows.size();
+    for(int start = 0; start < total; start += m_options.transactionTitles) {
+        int count = qMin(m_options.transactionTitles, total - start);
+        if(!writeChunk(rows.constData() + start, count, report)) {
+            // 整个事务已回滚，这一批全部计为拒绝
+            ok = false;
+            for(int i = start; i < start + count; ++i) {
+                report.rejects.append({rows[i].row, rows[i].isbn, "database write failed"});
+            }
+        }
+        if(m_progress) m_progress(start + count, total);
+    }
+    return ok;
+}
+
+// "(?, ?, ...), (?, ?, ...)"
+static QString valueTuples(int rows, int columns, const QString &suffix = QString())
+{
+    QStringList marks;
+    for(int c = 0; c < columns; ++c) marks << "?";
+    QString tuple = "(" + marks.join(", ") + suffix + ")";
+    QStringList tuples;
+    tuples.reserve(rows);
+    for(int r = 0; r < rows; ++r) tuples << tuple;
+    return tuples.join(", ");
+}
+
+bool CatalogImporter::writeChunk(const Row *rows, int count, Report &report)
+{
+    Database *db = Database::instance();
+    StorageBackend *backend = db->backend();
+    const int maxBind = backend->maxBindValues();
+    if(!db->transaction()) return false;
+
+    // 1. 图书：已存在的 ISBN 累加总册数和可借册数
+    const QString upsert = backend->upsertAdding("ISBN", {"TotalCopies", "AvailableCopies"});
+    int perStatement = qMax(1, qMin(MaxRowsPerStatement, maxBind / BookColumns));
+    for(int i = 0; i < count; i += perStatement) {
+        int n = qMin(perStatement, count - i);
+        QVariantList params;
+        params.reserve(n * BookColumns);
+        for(int r = i; r < i + n; ++r) {
+            const Row &row = rows[r];
+            params << row.isbn << row.title << row.author
+                   << (row.publisher.isEmpty() ? QVariant(QVariant::String) : QVariant(row.publisher))
+                   << (row.publishDate.isValid() ? QVariant(row.publishDate) : QVariant(QVariant::Date))
+                   << (row.price.isEmpty() ? QVariant(QVariant::Double) : QVariant(row.price.toDouble()))
+                   << row.introduction << row.copies << row.copies;
+        }
+        QString sql = QString("INSERT INTO Books (ISBN, Title, Author, Publisher, PublishDate, Price, "
+                              "Introduction, TotalCopies, AvailableCopies) VALUES %1 %2")
+                          .arg(valueTuples(n, BookColumns), upsert);
+        if(!db->executePrepared(QString("import.books.%1").arg(n), sql, params)) {
+            db->rollback();
+            return false;
+        }
+    }
+
+    // 2. 已有副本的最大编号：新副本接着往后排（与 addBook 一致，不按数量，删过副本也不会撞号）
+    QHash<QString, int> existing;
+    perStatement = qMax(1, qMin(MaxRowsPerStatement, maxBind));
+    for(int i = 0; i < count; i += perStatement) {
+        int n = qMin(perStatement, count - i);
+        QVariantList params;
+        params.reserve(n);
+        for(int r = i; r < i + n; ++r) params << rows[r].isbn;
+        QStringList marks;
+        for(int r = 0; r < n; ++r) marks << "?";
+        QSqlQuery query = db->executePreparedQuery(QString("import.copyMax.%1").arg(n),
+            QString("SELECT ISBN, MAX(SUBSTR(CopyID, LENGTH(ISBN) + 2) + 0) FROM BookCopies "
+                    "WHERE ISBN IN (%1) GROUP BY ISBN")
+                .arg(marks.join(", ")),
+            params);
+        if(!query.isActive()) {
+            db->rollback();
+            return false;
+        }
+        while(query.next()) existing.insert(query.value(0).toString(), query.value(1).toInt());
+    }
+
+    // 3. 副本：ISBN-001、ISBN-002 ...
+    QVector<QPair<QString, QString> > copies;
+    for(int r = 0; r < count; ++r) {
+        int first = existing.value(rows[r].isbn);
+        for(int k = 1; k <= rows[r].copies; ++k) {
+            copies.append(qMakePair(QString("%1-%2").arg(rows[r].isbn).arg(first + k, 3, 10, QChar('0')),
+                                    rows[r].isbn));
+        }
+    }
+    perStatement = qMax(1, qMin(MaxRowsPerStatement, maxBind / CopyColumns));
+    for(int i = 0; i < copies.size(); i += perStatement) {
+        int n = qMin(perStatement, copies.size() - i);
+        QVariantList params;
+        params.reserve(n * CopyColumns);
+        for(int c = i; c < i + n; ++c) params << copies[c].first << copies[c].second;
+        QString sql = QString("INSERT INTO BookCopies (CopyID, ISBN, Status) VALUES %1")
+                          .arg(valueTuples(n, CopyColumns, ", 'Available'"));
+        if(!db->executePrepared(QString("import.copies.%1").arg(n), sql, params)) {
+            db->rollback();
+            return false;
+        }
+    }
+
+    // 4. 与 addBook 一致：已有排队读者的图书，新副本先分给队首
+    QStringList waiting;
+    perStatement = qMax(1, qMin(MaxRowsPerStatement, maxBind));
+    for(int i = 0; i < count; i += perStatement) {
+        int n = qMin(perStatement, count - i);
+        QVariantList params;
+        params.reserve(n);
+        for(int r = i; r < i + n; ++r) params << rows[r].isbn;
+        QStringList marks;
+        for(int r = 0; r < n; ++r) marks << "?";
+        QSqlQuery query = db->executePreparedQuery(QString("import.waiting.%1").arg(n),
+            QString("SELECT DISTINCT ISBN FROM Reservations WHERE Status = 'Pending' AND ISBN IN (%1)")
+                .arg(marks.join(", ")),
+            params);
+        if(!query.isActive()) {
+            db->rollback();
+            return false;
+        }
+        while(query.next()) waiting << query.value(0).toString();
+    }
+    QList<ReservationQueue::Promotion> promoted;
+    foreach (const QString &isbn, waiting) {
+        if(!ReservationQueue::promoteWaiting(isbn, &promoted)) {
+            db->rollback();
+            return false;
+        }
+    }
+
+    if(!db->commit()) {
+        db->rollback();
+        return false;
+    }
+    ReservationQueue::instance()->applyPromotions(promoted);
+    report.imported += count;
+    report.copies += copies.size();
+    report.held += promoted.size();
+    return true;
+}
+
+static QString csvField(const QString &text)
+{
+    if(!text.contains(',') && !text.contains('"') && !text.contains('\n')) return text;
+    QString escaped = text;
+    escaped.replace("\"", "\"\"");
+    return "\"" + escaped + "\"";
+}
+
+bool CatalogImporter::writeRejectReport(const Report &report)
+{
+    QFile file(m_options.rejectReportPath);
+    if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "Cannot write reject report:" << m_options.rejectReportPath << file.errorString();
+        return false;
+    }
+    QTextStream out(&file);
+    out.setCodec("UTF-8");
+    out << "row,isbn,reason\n";
+    for(const Reject &reject : report.rejects) {
+        out << reject.row << ',' << csvField(reject.isbn) << ',' << csvField(reject.reason) << '\n';
+    }
+    return true;
+}
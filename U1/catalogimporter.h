@@ -0,0 +1,96 @@
+// include/catalogimporter.h
+#ifndef CATALOGIMPORTER_H
+#define CATALOGIMPORTER_H
+
+#include <QString>
+#include <QByteArray>
+#include <QDate>
+#include <QList>
+#include <QVector>
+#include <functional>
+
+// 批量导入馆藏（命令行 --import-catalog）
+// 1. 解析：CSV（RFC 4180，首行为列名）或 ISO 2709 MARC 记录，分隔符用 SSE2 每次扫描16字节；
+//    MARC 先按记录结束符切分，再并行解析各条记录
+// 2. 校验：并行规范化并校验 ISBN-10/13 校验位、必填字段和册数，同一 ISBN 多行时合并册数；
+//    库里已有的图书按原样（可能带连字符）保存的 ISBN 写入，只加副本，不会另起一行
+// 3. 写库：每个事务写入一大批，图书和副本都用多行 INSERT，副本编号按已有副本数续编
+// 进度通过回调报告；被拒绝的行写入拒绝报告（CSV：行号、ISBN、原因）。
+class CatalogImporter
+{
+public:
+    enum Format { AutoDetect, Csv, Marc };
+
+    struct Options {
+        Format format;
+        int transactionTitles;    // 每个事务写入的图书数
+        QString rejectReportPath; // 为空时写到 <导入文件>.rejects.csv
+        Options();
+    };
+
+    struct Reject {
+        int row;        // CSV 为数据行号（列名行为第1行），MARC 为记录序号
+        QString isbn;
+        QString reason;
+    };
+
+    struct Report {
+        bool ok;
+        int parsed;     // 解析出的行/记录数
+        int imported;   // 写入的图书数（合并后）
+        int merged;     // 同一 ISBN 被合并的行数
+        int copies;     // 生成的副本数
+        int held;       // 新副本中直接保留给预约排队读者的册数
+        int rejected;
+        qint64 parseMs;
+        qint64 validateMs;
+        qint64 writeMs;
+        qint64 totalMs;
+        double titlesPerMinute;
+        QString rejectReportPath;
+        QList<Reject> rejects;
+        Report();
+    };
+
+    // 已写入的图书数 / 待写入总数
+    typedef std::function<void(int done, int total)> ProgressCallback;
+
+    explicit CatalogImporter(const Options &options = Options());
+
+    void setProgressCallback(const ProgressCallback &callback);
+    Report importFile(const QString &path);
+    Report importData(const QByteArray &data, Format format);
+
+    // ISBN 去掉连字符和空格并校验校验位，无效时返回空串
+    static QString normalizeIsbn(const QString &raw);
+
+private:
+    struct Row {
+        int row;
+        QString isbn;
+        QString title;
+        QString author;
+        QString publisher;
+        QDate publishDate;
+        QString price;
+        QString introduction;
+        int copies;
+        QString error;
+    };
+
+    static QVector<Row> parseCsv(const QByteArray &data);
+    static QVector<Row> parseMarc(const QByteArray &data);
+    static Row parseMarcRecord(const QByteArray &record, int index);
+    static void validateRow(Row &row);
+
+    QVector<Row> validate(QVector<Row> &rows, Report &report);
+    static bool matchStoredIsbns(QVector<Row> &rows);
+    bool write(const QVector<Row> &rows, Report &report);
+    bool writeChunk(const Row *rows, int count, Report &report);
+    bool writeRejectReport(const Report &report);
+
+    Options m_options;
+    ProgressCallback m_progress;
+};
+
+#endif // CATALOGIMPORTER_H
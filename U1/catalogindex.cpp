@@ -0,0 +1,404 @@
+// src/catalogindex.cpp
+#include "catalogindex.h"
+#include "database.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+// BM25 参数
+static const float K1 = 1.2f;
+static const float B = 0.75f;
+
+// 字段权重：书名和ISBN最重要，其次作者
+static const float TitleWeight = 3.0f;
+static const float IsbnWeight = 3.0f;
+static const float AuthorWeight = 2.0f;
+static const float PublisherWeight = 1.0f;
+static const float IntroductionWeight = 1.0f;
+
+static bool isCjk(ushort c)
+{
+    return (c >= 0x4E00 && c <= 0x9FFF)   // 中日韩统一表意文字
+        || (c >= 0x3400 && c <= 0x4DBF)   // 扩展A
+        || (c >= 0xF900 && c <= 0xFAFF)   // 兼容表意文字
+        || (c >= 0x3040 && c <= 0x30FF)   // 假名
+        || (c >= 0xAC00 && c <= 0xD7AF);  // 韩文音节
+}
+
+static bool isWordChar(QChar c)
+{
+    return c.isLetterOrNumber() && !isCjk(c.unicode());
+}
+
+// forQuery 为 true 时，两字及以上的中文只取双字词，查询更有区分度
+static QStringList splitTokens(const QString &text, bool forQuery)
+{
+    QStringList tokens;
+    const QString lower = text.toLower();
+    const int n = lower.size();
+    int i = 0;
+    while(i < n) {
+        QChar c = lower.at(i);
+        if(isCjk(c.unicode())) {
+            int start = i;
+            while(i < n && isCjk(lower.at(i).unicode())) ++i;
+            int length = i - start;
+            for(int k = start; k < i; ++k) {
+                if(!forQuery || length == 1) tokens << lower.mid(k, 1);
+                if(k + 1 < i) tokens << lower.mid(k, 2);
+            }
+        } else if(isWordChar(c)) {
+            int start = i;
+            // 单词内的连字符（如 ISBN 978-7-111-...）视为单词的一部分，入索引时去掉
+            while(i < n) {
+                QChar ch = lower.at(i);
+                if(isWordChar(ch) || (ch == '-' && i + 1 < n && isWordChar(lower.at(i + 1)))) {
+                    ++i;
+                } else {
+                    break;
+                }
+            }
+            QString word = lower.mid(start, i - start);
+            word.remove('-');
+            if(!word.isEmpty()) tokens << word;
+        } else {
+            ++i;
+        }
+    }
+    return tokens;
+}
+
+CatalogIndex::CatalogIndex(QObject *parent)
+    : QObject(parent), m_ready(false), m_totalLength(0.0), m_liveDocs(0), m_building(0)
+{
+}
+
+CatalogIndex* CatalogIndex::instance()
+{
+    static CatalogIndex *instance = new CatalogIndex();
+    return instance;
+}
+
+bool CatalogIndex::isReady() const
+{
+    QReadLocker lock(&m_lock);
+    return m_ready;
+}
+
+int CatalogIndex::documentCount() const
+{
+    QReadLocker lock(&m_lock);
+    return m_liveDocs;
+}
+
+QStringList CatalogIndex::tokenize(const QString &text)
+{
+    return splitTokens(text, false);
+}
+
+bool CatalogIndex::rebuild()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 从这里起的增量变更可能不在下面读到的结果里，先记下来，build() 换入后重放
+    {
+        QWriteLocker lock(&m_lock);
+        m_building++;
+    }
+
+    QList<Document> documents;
+    QSqlQuery q(Database::instance()->connection());
+    q.setForwardOnly(true);
+    if(!q.exec("SELECT ISBN, Title, Author, Publisher, Introduction FROM Books")) {
+        qDebug() << "Catalog index load error:" << q.lastError().text();
+        finishBuild();
+        return false;
+    }
+    while(q.next()) {
+        Document doc;
+        doc.isbn = q.value(0).toString();
+        doc.title = q.value(1).toString();
+        doc.author = q.value(2).toString();
+        doc.publisher = q.value(3).toString();
+        doc.introduction = q.value(4).toString();
+        documents.append(doc);
+    }
+
+    build(documents);
+    finishBuild();
+    qDebug() << "Catalog index built:" << documents.size() << "books in" << timer.elapsed() << "ms";
+    return true;
+}
+
+QFuture<bool> CatalogIndex::rebuildAsync(QThreadPool *pool)
+{
+    return QtConcurrent::run(pool, [this]() { return rebuild(); });
+}
+
+// 文档按线程数切段并行建局部索引，再按段顺序合并，保证倒排表按文档号有序
+void CatalogIndex::build(const QList<Document> &documents)
+{
+    int segmentCount = qMax(1, QThread::idealThreadCount());
+    int segmentSize = qMax(1, (documents.size() + segmentCount - 1) / segmentCount);
+
+    QList<QFuture<Segment>> futures;
+    for(int base = 0; base < documents.size(); base += segmentSize) {
+        QList<Document> slice = documents.mid(base, segmentSize);
+        futures.append(QtConcurrent::run([slice, base]() { return buildSegment(slice, base); }));
+    }
+
+    QVector<DocInfo> docs;
+    docs.reserve(documents.size());
+    QHash<QString, QVector<Posting>> postings;
+    double totalLength = 0.0;
+    for(int i = 0; i < futures.size(); ++i) {
+        Segment segment = futures[i].result();
+        for(const DocInfo &info : segment.docs) {
+            totalLength += info.length;
+        }
+        docs += segment.docs;
+        for(auto it = segment.postings.constBegin(); it != segment.postings.constEnd(); ++it) {
+            postings[it.key()] += it.value();
+        }
+    }
+
+    QHash<QString, int> docIds;
+    docIds.reserve(docs.size());
+    for(int i = 0; i < docs.size(); ++i) {
+        docIds.insert(docs[i].isbn, i);
+    }
+
+    QWriteLocker lock(&m_lock);
+    m_docs.swap(docs);
+    m_docIds.swap(docIds);
+    m_postings.swap(postings);
+    m_totalLength = totalLength;
+    m_liveDocs = m_docs.size();
+    m_ready = true;
+
+    // 重放构建期间的变更；已包含在读到的结果里的再做一遍，结果相同
+    foreach (const PendingChange &change, m_pending) {
+        if(change.removed) {
+            removeLocked(change.document.isbn);
+        } else {
+            QHash<QString, float> termFreqs;
+            float length = 0.0f;
+            indexDocument(change.document, termFreqs, length);
+            addLocked(change.document, termFreqs, length);
+        }
+    }
+}
+
+// 没有其他构建在进行时丢弃变更记录；构建失败时这些变更已在库里，下次构建会读到
+void CatalogIndex::finishBuild()
+{
+    QWriteLocker lock(&m_lock);
+    if(--m_building == 0) m_pending.clear();
+}
+
+CatalogIndex::Segment CatalogIndex::buildSegment(const QList<Document> &documents, int baseDoc)
+{
+    Segment segment;
+    segment.docs.reserve(documents.size());
+    for(int i = 0; i < documents.size(); ++i) {
+        QHash<QString, float> termFreqs;
+        float length = 0.0f;
+        indexDocument(documents[i], termFreqs, length);
+
+        DocInfo info;
+        info.isbn = documents[i].isbn;
+        info.length = length;
+        info.alive = true;
+        segment.docs.append(info);
+
+        for(auto it = termFreqs.constBegin(); it != termFreqs.constEnd(); ++it) {
+            Posting posting;
+            posting.doc = baseDoc + i;
+            posting.tf = it.value();
+            segment.postings[it.key()].append(posting);
+        }
+    }
+    return segment;
+}
+
+void CatalogIndex::indexDocument(const Document &document,
+                                 QHash<QString, float> &termFreqs, float &length)
+{
+    struct Field {
+        const QString *text;
+        float weight;
+    };
+    const Field fields[] = {
+        { &document.isbn, IsbnWeight },
+        { &document.title, TitleWeight },
+        { &document.author, AuthorWeight },
+        { &document.publisher, PublisherWeight },
+        { &document.introduction, IntroductionWeight }
+    };
+
+    length = 0.0f;
+    for(const Field &field : fields) {
+        foreach (const QString &token, splitTokens(*field.text, false)) {
+            termFreqs[token] += field.weight;
+            length += field.weight;
+        }
+    }
+}
+
+void CatalogIndex::addOrUpdate(const Document &document)
+{
+    QHash<QString, float> termFreqs;
+    float length = 0.0f;
+    indexDocument(document, termFreqs, length);
+
+    QWriteLocker lock(&m_lock);
+    if(m_building > 0) m_pending.append({false, document});
+    if(m_ready) addLocked(document, termFreqs, length);
+}
+
+void CatalogIndex::addLocked(const Document &document, const QHash<QString, float> &termFreqs, float length)
+{
+    // 旧文档只做删除标记，新内容追加为新文档号，倒排表保持有序
+    removeLocked(document.isbn);
+
+    int doc = m_docs.size();
+    DocInfo info;
+    info.isbn = document.isbn;
+    info.length = length;
+    info.alive = true;
+    m_docs.append(info);
+    m_docIds.insert(document.isbn, doc);
+    m_totalLength += length;
+    m_liveDocs++;
+
+    for(auto it = termFreqs.constBegin(); it != termFreqs.constEnd(); ++it) {
+        Posting posting;
+        posting.doc = doc;
+        posting.tf = it.value();
+        m_postings[it.key()].append(posting);
+    }
+}
+
+void CatalogIndex::remove(const QString &isbn)
+{
+    QWriteLocker lock(&m_lock);
+    if(m_building > 0) {
+        PendingChange change;
+        change.removed = true;
+        change.document.isbn = isbn;
+        m_pending.append(change);
+    }
+    removeLocked(isbn);
+}
+
+void CatalogIndex::removeLocked(const QString &isbn)
+{
+    auto it = m_docIds.find(isbn);
+    if(it == m_docIds.end()) return;
+
+    DocInfo &info = m_docs[it.value()];
+    info.alive = false;
+    m_totalLength -= info.length;
+    m_liveDocs--;
+    m_docIds.erase(it);
+}
+
+float CatalogIndex::bm25(float tf, float docLength, int df, float avgLength) const
+{
+    float idf = std::log(1.0f + (m_liveDocs - df + 0.5f) / (df + 0.5f));
+    if(idf < 0.0f) idf = 0.0f;
+    float norm = K1 * (1.0f - B + B * docLength / avgLength);
+    return idf * tf * (K1 + 1.0f) / (tf + norm);
+}
+
+QList<CatalogIndex::Hit> CatalogIndex::search(const QString &query, int limit) const
+{
+    QList<Hit> hits;
+
+    QStringList terms = splitTokens(query, true);
+    terms.removeDuplicates();
+    if(terms.isEmpty()) return hits;
+
+    QReadLocker lock(&m_lock);
+    if(!m_ready || m_liveDocs <= 0) return hits;
+    float avgLength = static_cast<float>(m_totalLength / m_liveDocs);
+    if(avgLength <= 0.0f) avgLength = 1.0f;
+
+    QVector<const QVector<Posting>*> lists;
+    bool missingTerm = false;
+    foreach (const QString &term, terms) {
+        auto it = m_postings.constFind(term);
+        if(it == m_postings.constEnd()) {
+            missingTerm = true;
+        } else {
+            lists.append(&it.value());
+        }
+    }
+    if(lists.isEmpty()) return hits;
+
+    // 从最短的倒排表出发
+    std::sort(lists.begin(), lists.end(), [](const QVector<Posting> *a, const QVector<Posting> *b) {
+        return a->size() < b->size();
+    });
+
+    QHash<int, float> scores;
+    if(!missingTerm) {
+        // 合取：其余倒排表按文档号二分查找
+        const QVector<Posting> &first = *lists[0];
+        for(const Posting &p : first) {
+            const DocInfo &info = m_docs[p.doc];
+            if(!info.alive) continue;
+
+            float score = bm25(p.tf, info.length, first.size(), avgLength);
+            bool matchedAll = true;
+            for(int k = 1; k < lists.size(); ++k) {
+                const QVector<Posting> &list = *lists[k];
+                auto pos = std::lower_bound(list.constBegin(), list.constEnd(), p.doc,
+                                            [](const Posting &a, int doc) { return a.doc < doc; });
+                if(pos == list.constEnd() || pos->doc != p.doc) {
+                    matchedAll = false;
+                    break;
+                }
+                score += bm25(pos->tf, info.length, list.size(), avgLength);
+            }
+            if(matchedAll) scores.insert(p.doc, score);
+        }
+    }
+
+    if(scores.isEmpty()) {
+        // 析取：任一词命中即可
+        for(const QVector<Posting> *list : lists) {
+            for(const Posting &p : *list) {
+                const DocInfo &info = m_docs[p.doc];
+                if(!info.alive) continue;
+                scores[p.doc] += bm25(p.tf, info.length, list->size(), avgLength);
+            }
+        }
+    }
+
+    QVector<QPair<float, int>> ranked;
+    ranked.reserve(scores.size());
+    for(auto it = scores.constBegin(); it != scores.constEnd(); ++it) {
+        ranked.append(qMakePair(it.value(), it.key()));
+    }
+    int count = (limit > 0) ? qMin(limit, ranked.size()) : ranked.size();
+    std::partial_sort(ranked.begin(), ranked.begin() + count, ranked.end(),
+                      [](const QPair<float, int> &a, const QPair<float, int> &b) {
+        return a.first > b.first;
+    });
+
+    for(int i = 0; i < count; ++i) {
+        Hit hit;
+        hit.isbn = m_docs[ranked[i].second].isbn;
+        hit.score = ranked[i].first;
+        hits.append(hit);
+    }
+    return hits;
+}
@@ -0,0 +1,98 @@
+// include/catalogindex.h
+#ifndef CATALOGINDEX_H
+#define CATALOGINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVector>
+#include <QFuture>
+#include <QThreadPool>
+#include <QReadWriteLock>
+
+// 进程内图书倒排索引
+// 中文按相邻两字(bigram)切分并保留单字，英文和数字按单词切分；
+// 对书名/作者/出版社/简介建索引，检索时用 BM25 打分排序。
+class CatalogIndex : public QObject
+{
+    Q_OBJECT
+public:
+    struct Document {
+        QString isbn;
+        QString title;
+        QString author;
+        QString publisher;
+        QString introduction;
+    };
+
+    struct Hit {
+        QString isbn;
+        float score;
+    };
+
+    static CatalogIndex* instance();
+
+    bool isReady() const;
+    int documentCount() const;
+
+    // 从数据库全量加载并并行建索引
+    bool rebuild();
+    // 在 pool 上后台构建
+    QFuture<bool> rebuildAsync(QThreadPool *pool);
+    void build(const QList<Document> &documents);
+
+    // 增量维护；全量构建进行中的变更另记一份，构建结果换入后重放
+    void addOrUpdate(const Document &document);
+    void remove(const QString &isbn);
+
+    // 所有查询词都命中的文档优先；没有时退化为任一词命中
+    QList<Hit> search(const QString &query, int limit = 200) const;
+
+    static QStringList tokenize(const QString &text);
+
+private:
+    struct Posting {
+        int doc;
+        float tf; // 按字段加权后的词频
+    };
+
+    struct DocInfo {
+        QString isbn;
+        float length;
+        bool alive;
+    };
+
+    struct PendingChange {
+        bool removed;
+        Document document;
+    };
+
+    // 一段文档构建出的局部索引，用于并行建索引后合并
+    struct Segment {
+        QVector<DocInfo> docs;
+        QHash<QString, QVector<Posting>> postings;
+    };
+
+    explicit CatalogIndex(QObject *parent = nullptr);
+
+    static Segment buildSegment(const QList<Document> &documents, int baseDoc);
+    static void indexDocument(const Document &document,
+                              QHash<QString, float> &termFreqs, float &length);
+    void finishBuild();
+    void addLocked(const Document &document, const QHash<QString, float> &termFreqs, float length);
+    void removeLocked(const QString &isbn);
+    float bm25(float tf, float docLength, int df, float avgLength) const;
+
+    mutable QReadWriteLock m_lock;
+    bool m_ready;
+    QVector<DocInfo> m_docs;
+    QHash<QString, int> m_docIds;
+    QHash<QString, QVector<Posting>> m_postings;
+    double m_totalLength;
+    int m_liveDocs;
+    int m_building;                     // 进行中的全量构建数
+    QList<PendingChange> m_pending;     // 构建期间的增量变更
+};
+
+#endif // CATALOGINDEX_H
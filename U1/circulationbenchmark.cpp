@@ -0,0 +1,211 @@
+// src/circulationbenchmark.cpp
+#include "circulationbenchmark.h"
+#include "database.h"
+#include "storagebackend.h"
+#include <QThread>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QSqlRecord>
+#include <QDebug>
+
+// 测试数据：读者 ID 以 Z 开头，与正常注册的 ID 不冲突
+static const char *BenchIsbn = "BENCH-CIRC-0001";
+static const int BenchUsers = 64;
+static const int ThroughputCopies = 1000;
+
+CirculationBenchmark::Options::Options()
+    : copies(200), durationMs(3000)
+{
+    clients << 1 << 2 << 4 << 8 << 16 << 32 << 64;
+}
+
+CirculationBenchmark::CirculationBenchmark(Library *library)
+    : m_library(library)
+{
+}
+
+QString CirculationBenchmark::userId(int index)
+{
+    return QString("Z%1").arg(index, 5, 10, QChar('0'));
+}
+
+bool CirculationBenchmark::setUp()
+{
+    Database *db = Database::instance();
+    tearDown();
+
+    bool ok = db->executePrepared("bench.insertBook",
+        "INSERT INTO Books (ISBN, Title, Author, TotalCopies, AvailableCopies) VALUES (?, ?, ?, 0, 0)",
+        {QString(BenchIsbn), QString("Circulation Benchmark"), QString("bench")});
+    for(int i = 0; ok && i < BenchUsers; ++i) {
+        ok = db->executePrepared("bench.insertUser",
+            "INSERT INTO Users (UserID, Email, Password, Name, Type, CreditScore) "
+            "VALUES (?, ?, 'bench', ?, 'Normal', 100)",
+            {userId(i), QString("%1@bench.invalid").arg(userId(i)), userId(i)});
+    }
+    return ok;
+}
+
+// 清空借阅记录，重置副本数和读者状态
+bool CirculationBenchmark::resetBook(int copies)
+{
+    Database *db = Database::instance();
+    return db->executePrepared("bench.clearRecords",
+               "DELETE FROM BorrowRecords WHERE ISBN = ?", {QString(BenchIsbn)})
+        && db->executePrepared("bench.resetBook",
+               "UPDATE Books SET TotalCopies = ?, AvailableCopies = ? WHERE ISBN = ?",
+               {copies, copies, QString(BenchIsbn)})
+        && db->executePrepared("bench.resetUsers",
+               "UPDATE Users SET CreditScore = 100, Fines = 0, HadLowCredit = FALSE WHERE UserID LIKE 'Z%'");
+}
+
+void CirculationBenchmark::tearDown()
+{
+    Database *db = Database::instance();
+    db->executePrepared("bench.clearRecords",
+        "DELETE FROM BorrowRecords WHERE ISBN = ?", {QString(BenchIsbn)});
+    db->executePrepared("bench.deleteBook",
+        "DELETE FROM Books WHERE ISBN = ?", {QString(BenchIsbn)});
+    db->executePrepared("bench.deleteUsers",
+        "DELETE FROM Users WHERE UserID LIKE 'Z%' AND Email LIKE '%@bench.invalid'");
+}
+
+bool CirculationBenchmark::run(const Options &options, QTextStream &out)
+{
+    // 每个客户端线程占一个连接
+    int maxClients = 0;
+    foreach (int clients, options.clients) maxClients = qMax(maxClients, clients);
+    ConnectionPool *pool = Database::instance()->pool();
+    int previousMax = pool->config().maxSize;
+    pool->setMaxSize(qMax(previousMax, maxClients + 1));
+
+    // 同一份输出格式在两种后端上各跑一次即可对比
+    out << "backend=" << Database::instance()->backend()->name() << '\n';
+    if(!setUp()) {
+        out << "error=setup_failed" << '\n';
+        tearDown();
+        pool->setMaxSize(previousMax);
+        return false;
+    }
+
+    bool passed = true;
+    foreach (int clients, options.clients) {
+        passed = runOversellCheck(clients, options.copies, out) && passed;
+        out.flush();
+    }
+    foreach (int clients, options.clients) {
+        runThroughput(clients, options.durationMs, out);
+        out.flush();
+    }
+
+    tearDown();
+    pool->setMaxSize(previousMax);
+    out << "result=" << (passed ? "PASS" : "FAIL") << '\n';
+    out.flush();
+    return passed;
+}
+
+bool CirculationBenchmark::runOversellCheck(int clients, int copies, QTextStream &out)
+{
+    if(!resetBook(copies)) {
+        out << "phase=oversell clients=" << clients << " error=reset_failed" << '\n';
+        return false;
+    }
+
+    QAtomicInt attempt(0);
+    QAtomicInt borrowed(0);
+    QAtomicInt errors(0);
+    QElapsedTimer timer;
+    timer.start();
+
+    // 读者轮流取用；副本数小于读者数 × 借阅上限，上限不会先于库存触发
+    QList<QThread*> threads;
+    for(int c = 0; c < clients; ++c) {
+        threads << QThread::create([this, &attempt, &borrowed, &errors]() {
+            while(true) {
+                int n = attempt.fetchAndAddRelaxed(1);
+                Library::CirculationResult result =
+                    m_library->executeBorrow(userId(n % BenchUsers), BenchIsbn);
+                if(result.status == Library::CirculationOk) {
+                    borrowed.fetchAndAddRelaxed(1);
+                } else if(result.status == Library::NoCopiesAvailable) {
+                    break;
+                } else if(errors.fetchAndAddRelaxed(1) > 100) {
+                    break;
+                }
+            }
+            Database::instance()->releaseConnection();
+        });
+    }
+    foreach (QThread *thread, threads) thread->start();
+    foreach (QThread *thread, threads) thread->wait();
+    qDeleteAll(threads);
+    qint64 elapsed = timer.elapsed();
+
+    int available = -1;
+    int openRecords = -1;
+    QSqlRecord q = Database::instance()->executePreparedRow("bench.check",
+        "SELECT b.AvailableCopies, "
+        "(SELECT COUNT(*) FROM BorrowRecords r WHERE r.ISBN = b.ISBN AND r.ReturnDate IS NULL) "
+        "FROM Books b WHERE b.ISBN = ?", {QString(BenchIsbn)});
+    if(!q.isEmpty()) {
+        available = q.value(0).toInt();
+        openRecords = q.value(1).toInt();
+    }
+
+    bool ok = borrowed.loadAcquire() == copies && available == 0 && openRecords == copies;
+    out << "phase=oversell clients=" << clients
+        << " copies=" << copies
+        << " borrowed=" << borrowed.loadAcquire()
+        << " available=" << available
+        << " open_records=" << openRecords
+        << " attempts=" << attempt.loadAcquire()
+        << " errors=" << errors.loadAcquire()
+        << " ms=" << elapsed
+        << " check=" << (ok ? "PASS" : "FAIL") << '\n';
+    return ok;
+}
+
+void CirculationBenchmark::runThroughput(int clients, int durationMs, QTextStream &out)
+{
+    if(!resetBook(ThroughputCopies)) {
+        out << "phase=throughput clients=" << clients << " error=reset_failed" << '\n';
+        return;
+    }
+
+    QAtomicInt cycles(0);
+    QAtomicInt failures(0);
+    QElapsedTimer timer;
+    timer.start();
+
+    QList<QThread*> threads;
+    for(int c = 0; c < clients; ++c) {
+        QString user = userId(c % BenchUsers);
+        threads << QThread::create([this, user, durationMs, &timer, &cycles, &failures]() {
+            while(timer.elapsed() < durationMs) {
+                bool ok = m_library->executeBorrow(user, BenchIsbn).status == Library::CirculationOk
+                       && m_library->executeReturn(user, BenchIsbn).status == Library::CirculationOk;
+                if(ok) {
+                    cycles.fetchAndAddRelaxed(1);
+                } else {
+                    failures.fetchAndAddRelaxed(1);
+                }
+            }
+            Database::instance()->releaseConnection();
+        });
+    }
+    foreach (QThread *thread, threads) thread->start();
+    foreach (QThread *thread, threads) thread->wait();
+    qDeleteAll(threads);
+
+    double seconds = timer.elapsed() / 1000.0;
+    int done = cycles.loadAcquire();
+    double opsPerSecond = seconds > 0 ? 2.0 * done / seconds : 0.0;
+    double latencyMs = done > 0 ? 1000.0 * seconds * clients / (2.0 * done) : 0.0;
+    out << "phase=throughput clients=" << clients
+        << " cycles=" << done
+        << " failures=" << failures.loadAcquire()
+        << " seconds=" << QString::number(seconds, 'f', 2)
+        << " ops_per_sec=" << QString::number(opsPerSecond, 'f', 1)
+        << " avg_latency_ms=" << QString::number(latencyMs, 'f', 2) << '\n';
+}
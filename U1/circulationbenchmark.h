@@ -0,0 +1,40 @@
+// include/circulationbenchmark.h
+#ifndef CIRCULATIONBENCHMARK_H
+#define CIRCULATIONBENCHMARK_H
+
+#include <QList>
+#include <QTextStream>
+#include "library.h"
+
+// 借还并发压测（命令行 --circulation-benchmark）
+// 用专用的测试读者和测试图书，在 1~64 个并发客户端下：
+//   1. 抢借：所有客户端同时借同一本书直到无副本，校验借出数 == 副本数、库存为 0，不会超借；
+//   2. 吞吐：每个客户端用自己的读者反复"借一本、还一本"，统计每秒借还次数。
+// 每行输出一条 key=value 结果，便于脚本解析。结束后清理测试数据。
+class CirculationBenchmark
+{
+public:
+    struct Options {
+        QList<int> clients;
+        int copies;      // 抢借阶段的副本数
+        int durationMs;  // 吞吐阶段每档的持续时间
+        Options();
+    };
+
+    explicit CirculationBenchmark(Library *library);
+
+    // 所有抢借校验都通过时返回 true
+    bool run(const Options &options, QTextStream &out);
+
+private:
+    bool setUp();
+    bool resetBook(int copies);
+    void tearDown();
+    bool runOversellCheck(int clients, int copies, QTextStream &out);
+    void runThroughput(int clients, int durationMs, QTextStream &out);
+    static QString userId(int index);
+
+    Library *m_library;
+};
+
+#endif // CIRCULATIONBENCHMARK_H
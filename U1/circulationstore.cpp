@@ -0,0 +1,503 @@
+// src/circulationstore.cpp
+#include "circulationstore.h"
+#include "database.h"
+#include <QSqlQuery>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CIRCULATION_STORE_SSE2
+#include <emmintrin.h>
+#endif
+
+static const qint32 OpenLoan = 0x7FFFFFFF;     // 未还的 ReturnDate
+static const int LoadChunkRows = 100000;
+static const int MinRowsPerTask = 1 << 16;
+
+// 一次统计的参数；日期都是儒略日
+struct ReportWindow {
+    qint32 from;
+    qint32 to;
+    qint32 today;
+    qint32 firstMonth;
+};
+
+struct LoanColumns {
+    const qint32 *user;
+    const qint32 *author;
+    const qint32 *borrow;
+    const qint32 *due;
+    const qint32 *ret;
+    const qint32 *fine;
+    const qint32 *month;
+    const quint8 *userSuper;
+};
+
+// 一个线程负责的行区间及其部分结果
+struct PartialReport {
+    int begin;
+    int end;
+    CirculationStore::Group total;
+    qint64 open;
+    CirculationStore::Group readers[2];
+    QVector<CirculationStore::Group> months;
+    QVector<CirculationStore::Group> authors;
+};
+
+CirculationStore::Group::Group()
+    : loans(0), overdue(0), fineCents(0)
+{
+}
+
+CirculationStore::Report::Report()
+    : rows(0), loans(0), openLoans(0), overdueLoans(0), overdueRate(0.0), fineCents(0), aggregateMs(0)
+{
+}
+
+CirculationStore::CirculationStore()
+    : m_loaded(false), m_loadMs(0), m_loading(0), m_generation(0)
+{
+}
+
+CirculationStore* CirculationStore::instance()
+{
+    static CirculationStore *instance = new CirculationStore();
+    return instance;
+}
+
+qint32 CirculationStore::dayNumber(const QDate &date)
+{
+    return date.isValid() ? qint32(date.toJulianDay()) : OpenLoan;
+}
+
+qint32 CirculationStore::monthKey(const QDate &date)
+{
+    return date.year() * 12 + date.month() - 1;
+}
+
+int CirculationStore::userSlotLocked(const QString &userId, bool super)
+{
+    auto it = m_userSlots.constFind(userId);
+    if(it != m_userSlots.constEnd()) return it.value();
+    int slot = m_userSuper.size();
+    m_userSlots.insert(userId, slot);
+    m_userSuper.append(super ? 1 : 0);
+    return slot;
+}
+
+int CirculationStore::bookSlotLocked(const QString &isbn, const QString &author)
+{
+    auto it = m_bookSlots.constFind(isbn);
+    if(it != m_bookSlots.constEnd()) return it.value();
+    auto authorIt = m_authorSlots.constFind(author);
+    int authorSlot;
+    if(authorIt != m_authorSlots.constEnd()) {
+        authorSlot = authorIt.value();
+    } else {
+        authorSlot = m_authors.size();
+        m_authorSlots.insert(author, authorSlot);
+        m_authors << author;
+    }
+    int slot = m_bookAuthor.size();
+    m_bookSlots.insert(isbn, slot);
+    m_bookAuthor.append(authorSlot);
+    return slot;
+}
+
+static qint64 openKey(int user, int book)
+{
+    return (qint64(user) << 32) | quint32(book);
+}
+
+// 在新对象里建好字典和各列再整体换进来，加载期间统计照常使用旧快照
+bool CirculationStore::load()
+{
+    QElapsedTimer timer;
+    timer.start();
+    CirculationStore fresh;
+    Database *db = Database::instance();
+    {
+        QWriteLocker lock(&m_lock);
+        m_loading++;
+    }
+
+    QSqlQuery users(db->connection());
+    users.setForwardOnly(true);
+    if(!users.exec("SELECT UserID, Type FROM Users")) {
+        qDebug() << "Circulation store: load users failed";
+        finishLoad();
+        return false;
+    }
+    while(users.next()) {
+        fresh.userSlotLocked(users.value(0).toString(), users.value(1).toString() == "Super");
+    }
+    users.finish();
+
+    QSqlQuery books(db->connection());
+    books.setForwardOnly(true);
+    if(!books.exec("SELECT ISBN, Author FROM Books")) {
+        qDebug() << "Circulation store: load books failed";
+        finishLoad();
+        return false;
+    }
+    while(books.next()) {
+        fresh.bookSlotLocked(books.value(0).toString(), books.value(1).toString());
+    }
+    books.finish();
+
+    // 按 RecordID 分块，避免驱动把整张表缓存在客户端
+    qint64 afterId = 0;
+    for(;;) {
+        QSqlQuery q(db->connection());
+        q.setForwardOnly(true);
+        q.prepare("SELECT RecordID, UserID, ISBN, BorrowDate, DueDate, ReturnDate, Fine "
+                  "FROM BorrowRecords WHERE RecordID > ? ORDER BY RecordID LIMIT ?");
+        q.addBindValue(afterId);
+        q.addBindValue(LoadChunkRows);
+        if(!q.exec()) {
+            qDebug() << "Circulation store: load borrow records failed";
+            finishLoad();
+            return false;
+        }
+        int rows = 0;
+        while(q.next()) {
+            afterId = q.value(0).toLongLong();
+            int user = fresh.userSlotLocked(q.value(1).toString(), false);
+            int book = fresh.bookSlotLocked(q.value(2).toString(), QString());
+            QDate borrowDate = q.value(3).toDate();
+            qint32 returnDay = dayNumber(q.value(5).toDate());
+            int row = fresh.m_user.size();
+            fresh.m_user.append(user);
+            fresh.m_book.append(book);
+            fresh.m_author.append(fresh.m_bookAuthor.at(book));
+            fresh.m_borrowDay.append(dayNumber(borrowDate));
+            fresh.m_dueDay.append(dayNumber(q.value(4).toDate()));
+            fresh.m_returnDay.append(returnDay);
+            fresh.m_fineCents.append(qint32(qRound64(q.value(6).toDouble() * 100)));
+            fresh.m_month.append(monthKey(borrowDate));
+            if(returnDay == OpenLoan) fresh.m_openRows.insert(openKey(user, book), row);
+            rows++;
+        }
+        if(rows < LoadChunkRows) break;
+    }
+
+    QWriteLocker lock(&m_lock);
+    fresh.replayLocked(m_pending);
+    m_userSlots.swap(fresh.m_userSlots);
+    m_userSuper.swap(fresh.m_userSuper);
+    m_bookSlots.swap(fresh.m_bookSlots);
+    m_bookAuthor.swap(fresh.m_bookAuthor);
+    m_authorSlots.swap(fresh.m_authorSlots);
+    m_authors.swap(fresh.m_authors);
+    m_user.swap(fresh.m_user);
+    m_book.swap(fresh.m_book);
+    m_author.swap(fresh.m_author);
+    m_borrowDay.swap(fresh.m_borrowDay);
+    m_dueDay.swap(fresh.m_dueDay);
+    m_returnDay.swap(fresh.m_returnDay);
+    m_fineCents.swap(fresh.m_fineCents);
+    m_month.swap(fresh.m_month);
+    m_openRows.swap(fresh.m_openRows);
+    m_loaded = true;
+    m_generation++;
+    m_loadMs = timer.elapsed();
+    if(--m_loading == 0) m_pending.clear();
+    return true;
+}
+
+QFuture<bool> CirculationStore::loadAsync(QThreadPool *pool)
+{
+    return QtConcurrent::run(pool, [this]() { return load(); });
+}
+
+void CirculationStore::finishLoad()
+{
+    QWriteLocker lock(&m_lock);
+    if(--m_loading == 0) m_pending.clear();
+}
+
+// 加载期间的借还，快照可能已经读到也可能没读到。借出按 (读者, 图书, 借出日) 和快照末尾的行对数，
+// 快照里没有的才追加；归还只结清仍在借的行
+void CirculationStore::replayLocked(const QList<PendingEvent> &events)
+{
+    qint32 firstDay = OpenLoan;
+    foreach (const PendingEvent &event, events) {
+        if(!event.returned) firstDay = qMin(firstDay, dayNumber(event.date));
+    }
+    QHash<QPair<qint64, qint32>, int> loaded;
+    for(int row = m_user.size() - 1; row >= 0 && m_borrowDay.at(row) >= firstDay; --row) {
+        loaded[qMakePair(openKey(m_user.at(row), m_book.at(row)), m_borrowDay.at(row))]++;
+    }
+    foreach (const PendingEvent &event, events) {
+        if(event.returned) {
+            appendReturnLocked(event.userId, event.isbn, event.date, event.fineCents);
+            continue;
+        }
+        int user = userSlotLocked(event.userId, false);
+        int book = bookSlotLocked(event.isbn, QString());
+        auto it = loaded.find(qMakePair(openKey(user, book), dayNumber(event.date)));
+        if(it != loaded.end() && it.value() > 0) {
+            it.value()--;
+            continue;
+        }
+        appendBorrowLocked(user, book, event.date, event.dueDate);
+    }
+}
+
+bool CirculationStore::isLoaded() const
+{
+    QReadLocker lock(&m_lock);
+    return m_loaded;
+}
+
+qint64 CirculationStore::rowCount() const
+{
+    QReadLocker lock(&m_lock);
+    return m_user.size();
+}
+
+qint64 CirculationStore::lastLoadMs() const
+{
+    QReadLocker lock(&m_lock);
+    return m_loadMs;
+}
+
+void CirculationStore::appendBorrow(const QString &userId, const QString &isbn, const QDate &borrowDate,
+                                    const QDate &dueDate)
+{
+    bool knownUser, knownBook;
+    quint32 generation;
+    {
+        QWriteLocker lock(&m_lock);
+        if(m_loading > 0) m_pending.append({false, userId, isbn, borrowDate, dueDate, 0});
+        if(!m_loaded) return;
+        knownUser = m_userSlots.contains(userId);
+        knownBook = m_bookSlots.contains(isbn);
+        generation = m_generation;
+    }
+
+    // 快照之后新增的读者或图书：在锁外查一次类型和作者
+    bool super = false;
+    QString author;
+    Database *db = Database::instance();
+    if(!knownUser) {
+        QSqlRecord q = db->executePreparedRow("circulation.user_type",
+            "SELECT Type FROM Users WHERE UserID = ?", {userId});
+        super = !q.isEmpty() && q.value(0).toString() == "Super";
+    }
+    if(!knownBook) {
+        QSqlRecord q = db->executePreparedRow("circulation.book_author",
+            "SELECT Author FROM Books WHERE ISBN = ?", {isbn});
+        if(!q.isEmpty()) author = q.value(0).toString();
+    }
+
+    QWriteLocker lock(&m_lock);
+    // 期间换入了新快照：它要么在加载开始前已提交、快照读得到，要么已由 replayLocked 补上
+    if(m_generation != generation) return;
+    appendBorrowLocked(userSlotLocked(userId, super), bookSlotLocked(isbn, author), borrowDate, dueDate);
+}
+
+void CirculationStore::appendBorrowLocked(int user, int book, const QDate &borrowDate, const QDate &dueDate)
+{
+    int row = m_user.size();
+    m_user.append(user);
+    m_book.append(book);
+    m_author.append(m_bookAuthor.at(book));
+    m_borrowDay.append(dayNumber(borrowDate));
+    m_dueDay.append(dayNumber(dueDate));
+    m_returnDay.append(OpenLoan);
+    m_fineCents.append(0);
+    m_month.append(monthKey(borrowDate));
+    m_openRows.insert(openKey(user, book), row);
+}
+
+// 与归还存储过程一致：结清该读者这本书最早的一条在借记录
+void CirculationStore::appendReturn(const QString &userId, const QString &isbn, const QDate &returnDate,
+                                    qint32 fineCents)
+{
+    QWriteLocker lock(&m_lock);
+    if(m_loading > 0) m_pending.append({true, userId, isbn, returnDate, QDate(), fineCents});
+    if(m_loaded) appendReturnLocked(userId, isbn, returnDate, fineCents);
+}
+
+void CirculationStore::appendReturnLocked(const QString &userId, const QString &isbn, const QDate &returnDate,
+                                          qint32 fineCents)
+{
+    auto user = m_userSlots.constFind(userId);
+    auto book = m_bookSlots.constFind(isbn);
+    if(user == m_userSlots.constEnd() || book == m_bookSlots.constEnd()) return;
+
+    qint64 key = openKey(user.value(), book.value());
+    QList<int> rows = m_openRows.values(key);
+    if(rows.isEmpty()) return;
+    int row = *std::min_element(rows.constBegin(), rows.constEnd());
+    m_openRows.remove(key, row);
+    m_returnDay[row] = dayNumber(returnDate);
+    m_fineCents[row] = fineCents;
+}
+
+// 只对命中区间的行做分组累加
+static inline void addToGroups(const LoanColumns &c, int row, bool overdue, const ReportWindow &w,
+                               PartialReport *p)
+{
+    qint32 fine = c.fine[row];
+    CirculationStore::Group *groups[3] = {
+        &p->months[c.month[row] - w.firstMonth],
+        &p->authors[c.author[row]],
+        &p->readers[c.userSuper[c.user[row]]]
+    };
+    for(CirculationStore::Group *g : groups) {
+        g->loans++;
+        g->overdue += overdue;
+        g->fineCents += fine;
+    }
+}
+
+static void aggregateRange(const LoanColumns &c, const ReportWindow &w, PartialReport *p)
+{
+    int i = p->begin;
+#ifdef CIRCULATION_STORE_SSE2
+    // 4行一组：借出日在 [from, to] 内为命中；实际归还日（未还取 today）晚于应还日为逾期
+    const __m128i lower = _mm_set1_epi32(w.from - 1);
+    const __m128i upper = _mm_set1_epi32(w.to + 1);
+    const __m128i today = _mm_set1_epi32(w.today);
+    const __m128i open = _mm_set1_epi32(OpenLoan);
+    const __m128i zero = _mm_setzero_si128();
+    __m128i fines = _mm_setzero_si128();
+    for(; i + 4 <= p->end; i += 4) {
+        __m128i borrow = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.borrow + i));
+        __m128i hit = _mm_and_si128(_mm_cmpgt_epi32(borrow, lower), _mm_cmplt_epi32(borrow, upper));
+        int hitBits = _mm_movemask_ps(_mm_castsi128_ps(hit));
+        if(!hitBits) continue;
+
+        __m128i ret = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.ret + i));
+        __m128i due = _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.due + i));
+        __m128i late = _mm_cmpgt_epi32(ret, today);
+        __m128i effective = _mm_or_si128(_mm_andnot_si128(late, ret), _mm_and_si128(late, today));
+        __m128i overdue = _mm_and_si128(hit, _mm_cmpgt_epi32(effective, due));
+        __m128i opened = _mm_and_si128(hit, _mm_cmpeq_epi32(ret, open));
+        int overdueBits = _mm_movemask_ps(_mm_castsi128_ps(overdue));
+        int openBits = _mm_movemask_ps(_mm_castsi128_ps(opened));
+
+        // 罚款按符号扩展成64位再累加
+        __m128i fine = _mm_and_si128(hit, _mm_loadu_si128(reinterpret_cast<const __m128i *>(c.fine + i)));
+        __m128i sign = _mm_cmplt_epi32(fine, zero);
+        fines = _mm_add_epi64(fines, _mm_unpacklo_epi32(fine, sign));
+        fines = _mm_add_epi64(fines, _mm_unpackhi_epi32(fine, sign));
+
+        p->total.loans += qPopulationCount(quint32(hitBits));
+        p->total.overdue += qPopulationCount(quint32(overdueBits));
+        p->open += qPopulationCount(quint32(openBits));
+        while(hitBits) {
+            int lane = qCountTrailingZeroBits(quint32(hitBits));
+            addToGroups(c, i + lane, (overdueBits >> lane) & 1, w, p);
+            hitBits &= hitBits - 1;
+        }
+    }
+    qint64 lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), fines);
+    p->total.fineCents += lanes[0] + lanes[1];
+#endif
+    for(; i < p->end; ++i) {
+        qint32 borrow = c.borrow[i];
+        if(borrow < w.from || borrow > w.to) continue;
+        qint32 effective = qMin(c.ret[i], w.today);
+        bool overdue = effective > c.due[i];
+        p->total.loans++;
+        p->total.overdue += overdue;
+        p->total.fineCents += c.fine[i];
+        p->open += c.ret[i] == OpenLoan;
+        addToGroups(c, i, overdue, w, p);
+    }
+}
+
+static void mergeGroup(CirculationStore::Group *into, const CirculationStore::Group &from)
+{
+    into->loans += from.loans;
+    into->overdue += from.overdue;
+    into->fineCents += from.fineCents;
+}
+
+CirculationStore::Report CirculationStore::report(const QDate &from, const QDate &to, const QDate &today,
+                                                  int topAuthors) const
+{
+    Report report;
+    report.from = from;
+    report.to = to;
+    if(!from.isValid() || !to.isValid() || to < from) return report;
+
+    QElapsedTimer timer;
+    timer.start();
+    QReadLocker lock(&m_lock);
+    report.rows = m_user.size();
+
+    ReportWindow w;
+    w.from = dayNumber(from);
+    w.to = dayNumber(to);
+    w.today = dayNumber(today);
+    w.firstMonth = monthKey(from);
+    int monthCount = monthKey(to) - w.firstMonth + 1;
+
+    LoanColumns c;
+    c.user = m_user.constData();
+    c.author = m_author.constData();
+    c.borrow = m_borrowDay.constData();
+    c.due = m_dueDay.constData();
+    c.ret = m_returnDay.constData();
+    c.fine = m_fineCents.constData();
+    c.month = m_month.constData();
+    c.userSuper = m_userSuper.constData();
+
+    // 按行区间分给线程，每段各有一套分组数组，最后合并
+    int rows = m_user.size();
+    int tasks = qBound(1, rows / MinRowsPerTask, qMax(1, QThread::idealThreadCount()));
+    QVector<PartialReport> partials(tasks);
+    for(int t = 0; t < tasks; ++t) {
+        PartialReport &p = partials[t];
+        p.begin = int(qint64(rows) * t / tasks);
+        p.end = int(qint64(rows) * (t + 1) / tasks);
+        p.open = 0;
+        p.months.resize(monthCount);
+        p.authors.resize(m_authors.size());
+    }
+    QtConcurrent::blockingMap(partials, [&c, &w](PartialReport &p) {
+        aggregateRange(c, w, &p);
+    });
+
+    QVector<Group> months(monthCount);
+    QVector<Group> authors(m_authors.size());
+    foreach (const PartialReport &p, partials) {
+        report.loans += p.total.loans;
+        report.overdueLoans += p.total.overdue;
+        report.fineCents += p.total.fineCents;
+        report.openLoans += p.open;
+        mergeGroup(&report.normalReaders, p.readers[0]);
+        mergeGroup(&report.superReaders, p.readers[1]);
+        for(int m = 0; m < monthCount; ++m) mergeGroup(&months[m], p.months.at(m));
+        for(int a = 0; a < authors.size(); ++a) mergeGroup(&authors[a], p.authors.at(a));
+    }
+    report.overdueRate = report.loans > 0 ? double(report.overdueLoans) / report.loans : 0.0;
+
+    for(int m = 0; m < monthCount; ++m) {
+        int key = w.firstMonth + m;
+        report.months.append({key / 12, key % 12 + 1, months.at(m)});
+    }
+
+    QVector<int> order;
+    for(int a = 0; a < authors.size(); ++a) {
+        if(authors.at(a).loans > 0) order.append(a);
+    }
+    int top = qMin(qMax(0, topAuthors), order.size());
+    std::partial_sort(order.begin(), order.begin() + top, order.end(), [&authors](int x, int y) {
+        return authors.at(x).loans > authors.at(y).loans;
+    });
+    for(int k = 0; k < top; ++k) {
+        report.topAuthors.append({m_authors.at(order.at(k)), authors.at(order.at(k))});
+    }
+
+    report.aggregateMs = timer.elapsed();
+    return report;
+}
@@ -0,0 +1,127 @@
+// include/circulationstore.h
+#ifndef CIRCULATIONSTORE_H
+#define CIRCULATIONSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QDate>
+#include <QList>
+#include <QFuture>
+#include <QThreadPool>
+#include <QReadWriteLock>
+
+// 借阅统计用的列式内存快照（命令行 --circulation-report）
+// 借阅记录按列存放：读者、图书、作者都编码成字典下标，日期存成 int32 天数，罚款存成整数分，
+// 另存一列借出月份。统计时按线程数切分行区间，每段用 SSE2 一次比较4行的日期区间和逾期条件，
+// 计数用 movemask + popcount，罚款累加到64位；按月份/作者/读者类型分组时只对命中的行做散列累加。
+// 图形界面启动时在后台加载，管理员的“借阅统计”按钮和命令行 --circulation-report 都用它。
+// 加载后由 Library 的借还事件增量追加；加载期间的借还先记下，换入新快照时补上快照没读到的部分。
+// 其他客户端的借还在下一次 load() 时并入。
+class CirculationStore
+{
+public:
+    struct Group {
+        qint64 loans;
+        qint64 overdue;
+        qint64 fineCents;
+        Group();
+    };
+
+    struct MonthRow {
+        int year;
+        int month;
+        Group totals;
+    };
+
+    struct AuthorRow {
+        QString author;
+        Group totals;
+    };
+
+    struct Report {
+        QDate from;
+        QDate to;
+        qint64 rows;            // 快照中的借阅记录数
+        qint64 loans;           // 区间内借出的
+        qint64 openLoans;       // 其中尚未归还的
+        qint64 overdueLoans;    // 其中逾期的（已还的按归还日，未还的按 today 算）
+        double overdueRate;
+        qint64 fineCents;
+        Group normalReaders;
+        Group superReaders;
+        QVector<MonthRow> months;
+        QVector<AuthorRow> topAuthors;
+        qint64 aggregateMs;
+        Report();
+    };
+
+    static CirculationStore* instance();
+
+    // 全量加载 Users、Books 和 BorrowRecords（按 RecordID 分块读取）
+    bool load();
+    // 在 pool 上后台加载
+    QFuture<bool> loadAsync(QThreadPool *pool);
+    bool isLoaded() const;
+    qint64 rowCount() const;
+    qint64 lastLoadMs() const;
+
+    // 借还事件；既未加载也不在加载中时忽略
+    void appendBorrow(const QString &userId, const QString &isbn, const QDate &borrowDate,
+                      const QDate &dueDate);
+    void appendReturn(const QString &userId, const QString &isbn, const QDate &returnDate,
+                      qint32 fineCents);
+
+    Report report(const QDate &from, const QDate &to, const QDate &today, int topAuthors = 10) const;
+
+private:
+    struct PendingEvent {
+        bool returned;
+        QString userId;
+        QString isbn;
+        QDate date;             // 借出日或归还日
+        QDate dueDate;
+        qint32 fineCents;
+    };
+
+    CirculationStore();
+
+    int userSlotLocked(const QString &userId, bool super);
+    int bookSlotLocked(const QString &isbn, const QString &author);
+    static qint32 dayNumber(const QDate &date);
+    static qint32 monthKey(const QDate &date);
+    void finishLoad();
+    void appendBorrowLocked(int user, int book, const QDate &borrowDate, const QDate &dueDate);
+    void appendReturnLocked(const QString &userId, const QString &isbn, const QDate &returnDate,
+                            qint32 fineCents);
+    void replayLocked(const QList<PendingEvent> &events);
+
+    mutable QReadWriteLock m_lock;
+    bool m_loaded;
+    qint64 m_loadMs;
+    int m_loading;                      // 进行中的全量加载数
+    quint32 m_generation;               // 每换入一次快照加一
+    QList<PendingEvent> m_pending;      // 加载期间的借还
+
+    // 字典
+    QHash<QString, int> m_userSlots;
+    QVector<quint8> m_userSuper;        // 下标为读者编号
+    QHash<QString, int> m_bookSlots;
+    QVector<qint32> m_bookAuthor;       // 下标为图书编号
+    QHash<QString, int> m_authorSlots;
+    QStringList m_authors;
+
+    // 借阅记录各列，同一下标为同一行
+    QVector<qint32> m_user;
+    QVector<qint32> m_book;
+    QVector<qint32> m_author;
+    QVector<qint32> m_borrowDay;
+    QVector<qint32> m_dueDay;
+    QVector<qint32> m_returnDay;        // 未还为 OpenLoan
+    QVector<qint32> m_fineCents;
+    QVector<qint32> m_month;            // 年 * 12 + 月 - 1
+    QMultiHash<qint64, int> m_openRows; // (读者, 图书) -> 未还的行
+};
+
+#endif // CIRCULATIONSTORE_H
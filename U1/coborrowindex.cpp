@@ -0,0 +1,348 @@
+// src/coborrowindex.cpp
+#include "coborrowindex.h"
+#include "database.h"
+#include <QSqlQuery>
+#include <QSettings>
+#include <QElapsedTimer>
+#include <QThread>
+#include <QtConcurrent>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+static const int DefaultMemoryMb = 256;
+static const int MinNeighbors = 4;
+static const int MaxNeighbors = 64;
+static const int LoadChunkRows = 100000;
+static const int TasksPerThread = 4;
+static const qint64 BytesPerTitleKey = 96;     // 字典里一个 ISBN 的大致开销
+static const qint64 BytesPerReaderKey = 64;
+
+CoBorrowIndex::CoBorrowIndex()
+    : m_ready(false), m_capacity(MaxNeighbors), m_building(0)
+{
+}
+
+CoBorrowIndex* CoBorrowIndex::instance()
+{
+    static CoBorrowIndex *instance = new CoBorrowIndex();
+    return instance;
+}
+
+bool CoBorrowIndex::isReady() const
+{
+    QReadLocker lock(&m_lock);
+    return m_ready;
+}
+
+int CoBorrowIndex::titleCount() const
+{
+    QReadLocker lock(&m_lock);
+    return m_isbns.size();
+}
+
+int CoBorrowIndex::neighborsPerTitle() const
+{
+    QReadLocker lock(&m_lock);
+    return m_capacity;
+}
+
+qint64 CoBorrowIndex::memoryBytes() const
+{
+    QReadLocker lock(&m_lock);
+    qint64 bytes = qint64(m_isbns.size()) * (BytesPerTitleKey + sizeof(quint32) + 1)
+                 + qint64(m_entries.size()) * sizeof(Entry)
+                 + qint64(m_baskets.size()) * BytesPerReaderKey;
+    for(auto it = m_baskets.constBegin(); it != m_baskets.constEnd(); ++it) {
+        bytes += it.value().capacity() * sizeof(int);
+    }
+    return bytes;
+}
+
+qint64 CoBorrowIndex::memoryCap()
+{
+    QSettings settings(Database::configFile(), QSettings::IniFormat);
+    qint64 mb = settings.value("recommend/memory_mb", DefaultMemoryMb).toLongLong();
+    return qMax<qint64>(1, mb) * 1024 * 1024;
+}
+
+// 字典和读者篮子先占去一部分，剩下的平均分给每行
+int CoBorrowIndex::capacityFor(int titles, qint64 fixedBytes)
+{
+    if(titles <= 0) return MaxNeighbors;
+    qint64 perRow = (memoryCap() - fixedBytes) / titles / qint64(sizeof(Entry) + 1);
+    if(perRow < MinNeighbors) {
+        qDebug() << "Co-borrow index: memory cap too small for" << titles << "titles, using"
+                 << MinNeighbors << "neighbors per title";
+    }
+    return int(qBound<qint64>(MinNeighbors, perRow, MaxNeighbors));
+}
+
+int CoBorrowIndex::itemLocked(const QString &isbn)
+{
+    auto it = m_items.constFind(isbn);
+    if(it != m_items.constEnd()) return it.value();
+    int item = m_isbns.size();
+    m_items.insert(isbn, item);
+    m_isbns.append(isbn);
+    m_popularity.append(0);
+    m_rowSize.append(0);
+    m_entries.resize(m_entries.size() + m_capacity);
+    return item;
+}
+
+// 把书放到篮子末尾；已在篮子里时只调整顺序。返回被挤出篮子的书，没有时为 -1
+static int pushRecent(QVector<int> &basket, int item)
+{
+    int pos = basket.indexOf(item);
+    if(pos >= 0) {
+        basket.remove(pos);
+        basket.append(item);
+        return -1;
+    }
+    basket.append(item);
+    if(basket.size() <= CoBorrowIndex::RecentPerReader) return -1;
+    int evicted = basket.first();
+    basket.remove(0);
+    return evicted;
+}
+
+bool CoBorrowIndex::rebuild()
+{
+    QElapsedTimer timer;
+    timer.start();
+    Database *db = Database::instance();
+    {
+        QWriteLocker lock(&m_lock);
+        m_building++;
+    }
+
+    QHash<QString, int> items;
+    QVector<QString> isbns;
+    QSqlQuery books(db->connection());
+    books.setForwardOnly(true);
+    if(!books.exec("SELECT ISBN FROM Books")) {
+        qDebug() << "Co-borrow index: load books failed";
+        finishBuild();
+        return false;
+    }
+    while(books.next()) {
+        QString isbn = books.value(0).toString();
+        if(!items.contains(isbn)) {
+            items.insert(isbn, isbns.size());
+            isbns.append(isbn);
+        }
+    }
+    books.finish();
+
+    // 按 RecordID 分块读借阅记录，每位读者只留最近的几种书
+    QHash<QString, QVector<int> > baskets;
+    qint64 afterId = 0;
+    for(;;) {
+        QSqlQuery q(db->connection());
+        q.setForwardOnly(true);
+        q.prepare("SELECT RecordID, UserID, ISBN FROM BorrowRecords WHERE RecordID > ? ORDER BY RecordID LIMIT ?");
+        q.addBindValue(afterId);
+        q.addBindValue(LoadChunkRows);
+        if(!q.exec()) {
+            qDebug() << "Co-borrow index: load borrow records failed";
+            finishBuild();
+            return false;
+        }
+        int rows = 0;
+        while(q.next()) {
+            afterId = q.value(0).toLongLong();
+            QString isbn = q.value(2).toString();
+            auto it = items.constFind(isbn);
+            int item;
+            if(it != items.constEnd()) {
+                item = it.value();
+            } else {
+                item = isbns.size();
+                items.insert(isbn, item);
+                isbns.append(isbn);
+            }
+            pushRecent(baskets[q.value(1).toString()], item);
+            rows++;
+        }
+        if(rows < LoadChunkRows) break;
+    }
+
+    // 倒排：书 -> 含这本书的篮子（CSR）
+    int titles = isbns.size();
+    QVector<QVector<int> > basketList;
+    basketList.reserve(baskets.size());
+    qint64 basketBytes = 0;
+    for(auto it = baskets.constBegin(); it != baskets.constEnd(); ++it) {
+        basketList.append(it.value());
+        basketBytes += BytesPerReaderKey + it.value().capacity() * sizeof(int);
+    }
+    QVector<quint32> popularity(titles, 0);
+    QVector<int> offsets(titles + 1, 0);
+    for(const QVector<int> &basket : basketList) {
+        for(int item : basket) {
+            popularity[item]++;
+        }
+    }
+    for(int i = 0; i < titles; ++i) {
+        offsets[i + 1] = offsets[i] + int(popularity[i]);
+    }
+    QVector<int> postings(offsets[titles]);
+    QVector<int> fill = offsets;
+    for(int b = 0; b < basketList.size(); ++b) {
+        for(int item : basketList.at(b)) {
+            postings[fill[item]++] = b;
+        }
+    }
+
+    int capacity = capacityFor(titles, qint64(titles) * (BytesPerTitleKey + sizeof(quint32)) + basketBytes);
+    QVector<Entry> entries(titles * capacity);
+    QVector<quint8> rowSize(titles, 0);
+
+    // 按书目分段并行：每段各用一个计数数组精确统计该段每行的邻居，只保留次数最多的 capacity 个。
+    // 各段只写自己的行，不需要加锁
+    int tasks = qMax(1, QThread::idealThreadCount() * TasksPerThread);
+    QVector<QPair<int, int> > ranges;
+    for(int t = 0; t < tasks; ++t) {
+        int begin = int(qint64(titles) * t / tasks);
+        int end = int(qint64(titles) * (t + 1) / tasks);
+        if(begin < end) ranges.append(qMakePair(begin, end));
+    }
+    Entry *entryData = entries.data();
+    quint8 *sizeData = rowSize.data();
+    const QVector<QVector<int> > &constBaskets = basketList;
+    const int *offsetData = offsets.constData();
+    const int *postingData = postings.constData();
+    QtConcurrent::blockingMap(ranges, [=, &constBaskets](const QPair<int, int> &range) {
+        QVector<quint32> counts(titles, 0);
+        QVector<int> touched;
+        for(int a = range.first; a < range.second; ++a) {
+            for(int p = offsetData[a]; p < offsetData[a + 1]; ++p) {
+                for(int b : constBaskets.at(postingData[p])) {
+                    if(b != a && counts[b]++ == 0) touched.append(b);
+                }
+            }
+            int keep = qMin(capacity, touched.size());
+            std::partial_sort(touched.begin(), touched.begin() + keep, touched.end(), [&counts](int x, int y) {
+                return counts.at(x) > counts.at(y);
+            });
+            Entry *slots = entryData + qint64(a) * capacity;
+            for(int k = 0; k < keep; ++k) {
+                slots[k].item = touched.at(k);
+                slots[k].count = counts.at(touched.at(k));
+            }
+            sizeData[a] = quint8(keep);
+            for(int b : touched) {
+                counts[b] = 0;
+            }
+            touched.clear();
+        }
+    });
+
+    QWriteLocker lock(&m_lock);
+    m_capacity = capacity;
+    m_items.swap(items);
+    m_isbns.swap(isbns);
+    m_popularity.swap(popularity);
+    m_entries.swap(entries);
+    m_rowSize.swap(rowSize);
+    m_baskets.swap(baskets);
+    m_ready = true;
+    // 构建期间的借书：已读到的只调整篮子顺序，没读到的补上计数
+    typedef QPair<QString, QString> Borrow;
+    foreach (const Borrow &borrow, m_pending) {
+        recordLocked(borrow.first, borrow.second);
+    }
+    qDebug() << "Co-borrow index built:" << m_isbns.size() << "titles," << m_baskets.size() << "readers,"
+             << m_capacity << "neighbors per title in" << timer.elapsed() << "ms";
+    if(--m_building == 0) m_pending.clear();
+    return true;
+}
+
+void CoBorrowIndex::finishBuild()
+{
+    QWriteLocker lock(&m_lock);
+    if(--m_building == 0) m_pending.clear();
+}
+
+QFuture<bool> CoBorrowIndex::rebuildAsync(QThreadPool *pool)
+{
+    return QtConcurrent::run(pool, [this]() { return rebuild(); });
+}
+
+// Space-Saving：行满时顶替次数最少的邻居，沿用其次数加一
+void CoBorrowIndex::bumpLocked(int row, int neighbor)
+{
+    Entry *slots = m_entries.data() + qint64(row) * m_capacity;
+    int size = m_rowSize.at(row);
+    int weakest = 0;
+    for(int i = 0; i < size; ++i) {
+        if(slots[i].item == neighbor) {
+            slots[i].count++;
+            return;
+        }
+        if(slots[i].count < slots[weakest].count) weakest = i;
+    }
+    if(size < m_capacity) {
+        slots[size].item = neighbor;
+        slots[size].count = 1;
+        m_rowSize[row] = quint8(size + 1);
+        return;
+    }
+    slots[weakest].item = neighbor;
+    slots[weakest].count++;
+}
+
+void CoBorrowIndex::recordBorrow(const QString &userId, const QString &isbn)
+{
+    QWriteLocker lock(&m_lock);
+    if(m_building > 0) m_pending.append(qMakePair(userId, isbn));
+    if(m_ready) recordLocked(userId, isbn);
+}
+
+// 人气与全量构建一致，按篮子计：放入时加一，挤出篮子时减一
+void CoBorrowIndex::recordLocked(const QString &userId, const QString &isbn)
+{
+    int item = itemLocked(isbn);
+    QVector<int> &basket = m_baskets[userId];
+    if(basket.contains(item)) {
+        pushRecent(basket, item);
+        return;
+    }
+    foreach (int other, basket) {
+        bumpLocked(item, other);
+        bumpLocked(other, item);
+    }
+    m_popularity[item]++;
+    int evicted = pushRecent(basket, item);
+    if(evicted >= 0 && m_popularity.at(evicted) > 0) m_popularity[evicted]--;
+}
+
+// 只读一行（至多 MaxNeighbors 个槽位），与书目总数无关
+QList<CoBorrowIndex::Hit> CoBorrowIndex::similar(const QString &isbn, int limit) const
+{
+    QList<Hit> hits;
+    QReadLocker lock(&m_lock);
+    if(!m_ready || limit <= 0) return hits;
+    auto it = m_items.constFind(isbn);
+    if(it == m_items.constEnd()) return hits;
+
+    int row = it.value();
+    const Entry *slots = m_entries.constData() + qint64(row) * m_capacity;
+    int size = m_rowSize.at(row);
+    float rowPopularity = float(qMax<quint32>(1, m_popularity.at(row)));
+    QVector<QPair<float, int> > scored;
+    scored.reserve(size);
+    for(int i = 0; i < size; ++i) {
+        float other = float(qMax<quint32>(1, m_popularity.at(slots[i].item)));
+        scored.append(qMakePair(slots[i].count / std::sqrt(rowPopularity * other), i));
+    }
+    int keep = qMin(limit, scored.size());
+    std::partial_sort(scored.begin(), scored.begin() + keep, scored.end(),
+                      [](const QPair<float, int> &x, const QPair<float, int> &y) { return x.first > y.first; });
+    for(int k = 0; k < keep; ++k) {
+        const Entry &entry = slots[scored.at(k).second];
+        hits.append({m_isbns.at(entry.item), scored.at(k).first, int(entry.count)});
+    }
+    return hits;
+}
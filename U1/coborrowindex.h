@@ -0,0 +1,79 @@
+// include/coborrowindex.h
+#ifndef COBORROWINDEX_H
+#define COBORROWINDEX_H
+
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QHash>
+#include <QPair>
+#include <QFuture>
+#include <QThreadPool>
+#include <QReadWriteLock>
+
+// “借过这本书的读者也借了”
+// 每位读者取最近借的 RecentPerReader 种书作为一个篮子，同一篮子里的两本书各记一次共同借阅。
+// 共现矩阵按行稀疏存放：每本书一行、固定容量的 (邻居, 次数) 槽位，容量由内存上限
+// （配置文件 recommend/memory_mb）除以书目数得出，100万种书时每行十几个邻居。
+// 全量构建时按书目分段并行、精确计数后保留次数最多的邻居；构建期间的借书先记下，换入后重放。
+// 之后每次借书增量更新，行满时替换次数最少的邻居并在其次数上加一
+// （Space-Saving，次数可能偏高，不会漏掉高频邻居）；书被挤出篮子时人气减一，与全量构建的口径一致。
+// 查询只看一行，按余弦相似度 次数 / sqrt(借阅人数A * 借阅人数B) 排序。
+class CoBorrowIndex
+{
+public:
+    static const int RecentPerReader = 32;
+
+    struct Hit {
+        QString isbn;
+        float score;
+        int together;   // 共同借阅的读者数
+    };
+
+    static CoBorrowIndex* instance();
+
+    bool isReady() const;
+    int titleCount() const;
+    int neighborsPerTitle() const;
+    qint64 memoryBytes() const;
+
+    // 从 BorrowRecords 全量构建
+    bool rebuild();
+    // 在 pool 上后台构建
+    QFuture<bool> rebuildAsync(QThreadPool *pool);
+
+    // 借书成功后调用；全量构建进行中时同时记下，换入新结果后重放。
+    // 构建已读到的借阅重放时书已在篮子里，只调整顺序，不会重复计数
+    void recordBorrow(const QString &userId, const QString &isbn);
+
+    QList<Hit> similar(const QString &isbn, int limit = 5) const;
+
+private:
+    struct Entry {
+        qint32 item;
+        quint32 count;
+    };
+
+    CoBorrowIndex();
+
+    static qint64 memoryCap();
+    static int capacityFor(int titles, qint64 fixedBytes);
+    int itemLocked(const QString &isbn);
+    void bumpLocked(int row, int neighbor);
+    void recordLocked(const QString &userId, const QString &isbn);
+    void finishBuild();
+
+    mutable QReadWriteLock m_lock;
+    bool m_ready;
+    int m_capacity;                     // 每行的邻居槽位数
+    QHash<QString, int> m_items;
+    QVector<QString> m_isbns;
+    QVector<quint32> m_popularity;      // 篮子里有这本书的读者数
+    QVector<Entry> m_entries;           // 第 i 行占 [i * m_capacity, (i + 1) * m_capacity)
+    QVector<quint8> m_rowSize;
+    QHash<QString, QVector<int> > m_baskets;    // 读者 -> 最近借的书，旧的在前
+    int m_building;                     // 进行中的全量构建数
+    QList<QPair<QString, QString> > m_pending;  // 构建期间的借书 (读者, ISBN)
+};
+
+#endif // COBORROWINDEX_H
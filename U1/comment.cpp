@@ -1,7 +1,10 @@
 // src/comment.cpp
 #include "comment.h"
 #include "database.h"
+#include "storagebackend.h"
 #include "user.h"
+#include "book.h"
+#include "entitycache.h"
 #include <QSqlQuery>
 #include <QSqlRecord>
 #include <QDebug>
@@ -26,20 +29,32 @@ bool Comment::addCommentToDatabase(const QString &userId, const QString &isbn,
     // 获取当前时间
     QDateTime now = QDateTime::currentDateTime();
 
-    // 构建SQL查询
-    QString query = QString(
-        "INSERT INTO Comments (UserID, ISBN, Comment, Rating, CommentDate) "
-        "VALUES ('%1', '%2', '%3', %4, '%5')"
-    ).arg(
-        Database::instance()->escapeString(userId),
-        Database::instance()->escapeString(isbn),
-        Database::instance()->escapeString(content),
-        QString::number(rating),
-        now.toString("yyyy-MM-dd hh:mm:ss")
-    );
-
-    // 执行查询
-    return Database::instance()->execute(query);
+    // 评论和评分汇总在同一事务里写入
+    Database *db = Database::instance();
+    if(!db->transaction()) return false;
+
+    bool ok = db->executePrepared("comments.insert",
+        "INSERT INTO Comments (UserID, ISBN, Comment, Rating, CommentDate) VALUES (?, ?, ?, ?, ?)",
+        {userId, isbn, content, rating, now});
+
+    // 增量更新该书的评分汇总：数量、总分和对应星级的计数
+    ok = ok && db->executePrepared("ratingStats.add",
+        "INSERT INTO BookRatingStats (ISBN, RatingCount, RatingSum, Rating1, Rating2, Rating3, Rating4, Rating5) "
+        "VALUES (?, 1, ?, ?, ?, ?, ?, ?) "
+        + db->backend()->upsertAdding("ISBN", QStringList{"RatingCount", "RatingSum", "Rating1",
+                                                          "Rating2", "Rating3", "Rating4", "Rating5"}),
+        {isbn, rating, int(rating == 1), int(rating == 2), int(rating == 3),
+         int(rating == 4), int(rating == 5)});
+
+    if(!ok) {
+        db->rollback();
+        return false;
+    }
+    if(!db->commit()) return false;
+
+    // 缓存的图书行里带着评分汇总
+    EntityCache::instance()->invalidateBook(isbn);
+    return true;
 }
 
 QList<Comment*> Comment::getCommentsForBook(const QString &isbn)
@@ -76,15 +91,7 @@ QList<Comment*> Comment::getCommentsForBook(const QString &isbn)
 
 double Comment::getAverageRatingForBook(const QString &isbn)
 {
-    QString query = QString(
-        "SELECT AVG(Rating) as AvgRating FROM Comments WHERE ISBN = '%1'"
-    ).arg(Database::instance()->escapeString(isbn));
-
-    QSqlQuery q = Database::instance()->executeQuery(query);
-    if(q.next()) {
-        return q.value("AvgRating").toDouble();
-    }
-    return 0.0;
+    return Book::calculateAverageRating(isbn);
 }
 
 QList<Comment*> Comment::getAdminCommentsForBook(const QString &isbn)
@@ -0,0 +1,450 @@
+// src/completiontrie.cpp
+#include "completiontrie.h"
+#include "database.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QHash>
+#include <QSet>
+#include <QMutexLocker>
+#include <QtConcurrent>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+CompletionTrie::CompletionTrie(QObject *parent)
+    : QObject(parent), m_lastSeq(0), m_building(0), m_merging(false)
+{
+}
+
+CompletionTrie* CompletionTrie::instance()
+{
+    static CompletionTrie *instance = new CompletionTrie();
+    return instance;
+}
+
+bool CompletionTrie::isReady() const
+{
+    QMutexLocker lock(&m_mutex);
+    return !m_snapshot.isNull();
+}
+
+// 与目录索引一致：忽略大小写、多余空白和连字符（ISBN 可带可不带 '-'）
+QString CompletionTrie::normalize(const QString &text)
+{
+    QString key = text.simplified().toCaseFolded();
+    key.remove('-');
+    return key;
+}
+
+bool CompletionTrie::rebuild()
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    // 增减都在提交之后记录，开始之前记下的下面的查询都能读到
+    qint64 appliedSeq;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_building++;
+        appliedSeq = m_lastSeq;
+    }
+
+    // 热度取历史借阅次数；作者的热度为其全部图书借阅次数之和
+    QSqlQuery q(Database::instance()->connection());
+    q.setForwardOnly(true);
+    if(!q.exec("SELECT b.ISBN, b.Title, b.Author, COUNT(r.RecordID) "
+               "FROM Books b LEFT JOIN BorrowRecords r ON r.ISBN = b.ISBN "
+               "GROUP BY b.ISBN, b.Title, b.Author")) {
+        qDebug() << "Completion trie load error:" << q.lastError().text();
+        QMutexLocker lock(&m_mutex);
+        m_building--;
+        return false;
+    }
+
+    QList<Entry> entries;
+    while(q.next()) {
+        quint32 borrows = q.value(3).toUInt();
+        Entry isbn = { q.value(0).toString(), borrows };
+        Entry title = { q.value(1).toString(), borrows };
+        Entry author = { q.value(2).toString(), borrows };
+        entries << isbn << title << author;
+    }
+
+    QSharedPointer<Snapshot> snap = buildSnapshot(entries);
+    snap->appliedSeq = appliedSeq;
+    QMutexLocker lock(&m_mutex);
+    installLocked(snap);
+    m_building--;
+    qDebug() << "Completion trie built:" << entries.size() << "entries in" << timer.elapsed() << "ms";
+    return true;
+}
+
+QFuture<bool> CompletionTrie::rebuildAsync(QThreadPool *pool)
+{
+    return QtConcurrent::run(pool, [this]() { return rebuild(); });
+}
+
+QSharedPointer<CompletionTrie::Snapshot> CompletionTrie::buildSnapshot(const QList<Entry> &entries)
+{
+    struct Keyed {
+        QString key;
+        int source;
+    };
+
+    QVector<Keyed> keyed;
+    keyed.reserve(entries.size());
+    for(int i = 0; i < entries.size(); ++i) {
+        QString key = normalize(entries.at(i).text);
+        if(key.isEmpty()) continue;
+        Keyed item = { key, i };
+        keyed.append(item);
+    }
+    std::sort(keyed.begin(), keyed.end(), [](const Keyed &a, const Keyed &b) {
+        return a.key < b.key;
+    });
+
+    QSharedPointer<Snapshot> snap(new Snapshot);
+    snap->keys.reserve(keyed.size());
+    snap->texts.reserve(keyed.size());
+    snap->weights.reserve(keyed.size());
+    snap->counts.reserve(keyed.size());
+
+    // 相同的键合并，热度和条目数累加（如同一作者的多本书）
+    for(int i = 0; i < keyed.size(); ++i) {
+        const Entry &entry = entries.at(keyed.at(i).source);
+        if(!snap->keys.isEmpty() && snap->keys.last() == keyed.at(i).key) {
+            snap->weights.last() += entry.weight;
+            snap->counts.last()++;
+            continue;
+        }
+        snap->keys.append(keyed.at(i).key);
+        snap->texts.append(entry.text.simplified());
+        snap->weights.append(entry.weight);
+        snap->counts.append(1);
+    }
+
+    buildNodes(*snap);
+    return snap;
+}
+
+void CompletionTrie::buildNodes(Snapshot &snap)
+{
+    if(snap.keys.isEmpty()) return;
+    snap.nodes.reserve(snap.keys.size() * 2);
+    snap.nodes.append(Node());
+    fillNode(snap, 0, 0, snap.keys.size(), 0);
+    snap.nodes.squeeze();
+    snap.top.squeeze();
+}
+
+// 把 base 之后的增减按键累加；条目数和热度都可能为 0
+QHash<QString, CompletionTrie::Change> CompletionTrie::pendingChanges(const Snapshot *base,
+                                                                      const QList<Change> &changes)
+{
+    QHash<QString, Change> pending;
+    qint64 appliedSeq = base ? base->appliedSeq : 0;
+    foreach (const Change &change, changes) {
+        if(change.seq <= appliedSeq) continue;
+        auto it = pending.find(change.key);
+        if(it == pending.end()) {
+            pending.insert(change.key, change);
+            continue;
+        }
+        if(it.value().text.isEmpty()) it.value().text = change.text;
+        it.value().weight += change.weight;
+        it.value().count += change.count;
+        it.value().seq = change.seq;
+    }
+    return pending;
+}
+
+int CompletionTrie::findKey(const Snapshot &snap, const QString &key)
+{
+    auto it = std::lower_bound(snap.keys.constBegin(), snap.keys.constEnd(), key);
+    if(it == snap.keys.constEnd() || *it != key) return -1;
+    return int(it - snap.keys.constBegin());
+}
+
+// 快照的键已有序，增量表按键排序后两路归并，不必从数据库重新加载
+QSharedPointer<CompletionTrie::Snapshot> CompletionTrie::mergeSnapshot(const Snapshot &base,
+                                                                       const QList<Change> &changes)
+{
+    QHash<QString, Change> pending = pendingChanges(&base, changes);
+    QSharedPointer<Snapshot> snap(new Snapshot);
+    snap->appliedSeq = base.appliedSeq;
+    if(!changes.isEmpty()) snap->appliedSeq = qMax(base.appliedSeq, changes.last().seq);
+
+    QVector<Change> added;
+    for(auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        if(findKey(base, it.key()) < 0 && it.value().count > 0) added.append(it.value());
+    }
+    std::sort(added.begin(), added.end(), [](const Change &a, const Change &b) {
+        return a.key < b.key;
+    });
+
+    int capacity = base.keys.size() + added.size();
+    snap->keys.reserve(capacity);
+    snap->texts.reserve(capacity);
+    snap->weights.reserve(capacity);
+    snap->counts.reserve(capacity);
+    int i = 0;
+    int j = 0;
+    while(i < base.keys.size() || j < added.size()) {
+        if(j == added.size() || (i < base.keys.size() && base.keys.at(i) < added.at(j).key)) {
+            quint32 weight = base.weights.at(i);
+            int count = base.counts.at(i);
+            auto change = pending.constFind(base.keys.at(i));
+            if(change != pending.constEnd()) {
+                weight += change.value().weight;
+                count += change.value().count;
+            }
+            if(count > 0) {
+                snap->keys.append(base.keys.at(i));
+                snap->texts.append(base.texts.at(i));
+                snap->weights.append(weight);
+                snap->counts.append(count);
+            }
+            ++i;
+        } else {
+            const Change &change = added.at(j);
+            snap->keys.append(change.key);
+            snap->texts.append(change.text);
+            snap->weights.append(change.weight);
+            snap->counts.append(change.count);
+            ++j;
+        }
+    }
+
+    buildNodes(*snap);
+    return snap;
+}
+
+// 较旧的结果（另一次构建已换入更新的快照）直接丢弃；已并入的增减从增量表里去掉
+void CompletionTrie::installLocked(const QSharedPointer<Snapshot> &snap)
+{
+    if(m_snapshot && snap->appliedSeq < m_snapshot->appliedSeq) return;
+    m_snapshot = snap;
+    while(!m_changes.isEmpty() && m_changes.first().seq <= snap->appliedSeq) {
+        m_changes.removeFirst();
+    }
+}
+
+void CompletionTrie::merge()
+{
+    QSharedPointer<const Snapshot> base;
+    QList<Change> changes;
+    {
+        QMutexLocker lock(&m_mutex);
+        base = m_snapshot;
+        changes = m_changes;
+    }
+    QSharedPointer<Snapshot> snap = mergeSnapshot(*base, changes);
+
+    QMutexLocker lock(&m_mutex);
+    m_merging = false;
+    // 合并期间开始了全量构建或换过快照：这次结果作废，增量表留给下一次
+    if(m_building > 0 || m_snapshot != base) return;
+    installLocked(snap);
+}
+
+// 结点覆盖有序键区间 [lo, hi)，边标签从 labelStart 延伸到区间的最长公共前缀处。
+// 子结点连续分配后再递归填充，最后由子结点的前 K 名合并出本结点的前 K 名。
+void CompletionTrie::fillNode(Snapshot &snap, int nodeIndex, int lo, int hi, int labelStart)
+{
+    const QString &first = snap.keys.at(lo);
+    const QString &last = snap.keys.at(hi - 1);
+    int end = labelStart;
+    int limit = qMin(first.size(), last.size());
+    while(end < limit && first.at(end) == last.at(end)) ++end;
+
+    // 按 end 处的字符分组（键有序，所以每组是连续的一段）
+    QVector<QPair<int, int> > groups;
+    int terminal = -1;
+    int i = lo;
+    if(first.size() == end) {
+        terminal = lo;
+        ++i;
+    }
+    while(i < hi) {
+        QChar c = snap.keys.at(i).at(end);
+        int j = i + 1;
+        while(j < hi && snap.keys.at(j).at(end) == c) ++j;
+        groups.append(qMakePair(i, j));
+        i = j;
+    }
+
+    int firstChild = snap.nodes.size();
+    snap.nodes.resize(firstChild + groups.size());
+    for(int g = 0; g < groups.size(); ++g) {
+        fillNode(snap, firstChild + g, groups.at(g).first, groups.at(g).second, end);
+    }
+
+    QVector<int> candidates;
+    if(terminal >= 0) candidates.append(terminal);
+    for(int g = 0; g < groups.size(); ++g) {
+        const Node &child = snap.nodes.at(firstChild + g);
+        for(int t = 0; t < child.topCount; ++t) {
+            candidates.append(snap.top.at(child.topStart + t));
+        }
+    }
+    const QVector<quint32> &weights = snap.weights;
+    std::sort(candidates.begin(), candidates.end(), [&weights](int a, int b) {
+        if(weights.at(a) != weights.at(b)) return weights.at(a) > weights.at(b);
+        return a < b;
+    });
+
+    Node &node = snap.nodes[nodeIndex];
+    node.keyRef = lo;
+    node.labelStart = labelStart;
+    node.labelLength = end - labelStart;
+    node.firstChild = firstChild;
+    node.childCount = groups.size();
+    node.topStart = snap.top.size();
+    node.topCount = qMin(candidates.size(), int(TopK));
+    for(int t = 0; t < node.topCount; ++t) {
+        snap.top.append(candidates.at(t));
+    }
+}
+
+void CompletionTrie::add(const Entry &entry)
+{
+    recordChange(entry.text, entry.weight, 1);
+}
+
+void CompletionTrie::remove(const QString &text)
+{
+    recordChange(text, 0, -1);
+}
+
+void CompletionTrie::recordChange(const QString &text, quint32 weight, int count)
+{
+    QString key = normalize(text);
+    if(key.isEmpty()) return;
+    QMutexLocker lock(&m_mutex);
+    Change change = { key, text.simplified(), weight, count, ++m_lastSeq };
+    m_changes.append(change);
+
+    // 合并只用内存里的数据，放在全局线程池；构建进行中时由构建结果一并吸收
+    if(m_changes.size() >= MergeThreshold && m_snapshot && !m_merging && m_building == 0) {
+        m_merging = true;
+        QtConcurrent::run([this]() { merge(); });
+    }
+}
+
+QStringList CompletionTrie::complete(const QString &prefix, int limit) const
+{
+    QStringList result;
+    const QString key = normalize(prefix);
+    if(key.isEmpty() || limit <= 0) return result;
+
+    QSharedPointer<const Snapshot> snap;
+    QList<Change> changes;
+    {
+        QMutexLocker lock(&m_mutex);
+        snap = m_snapshot;
+        changes = m_changes;
+    }
+    QHash<QString, Change> pending = pendingChanges(snap.data(), changes);
+
+    QList<Entry> matches;
+    if(snap && !snap->nodes.isEmpty()) {
+        int nodeIndex = 0;
+        int pos = 0;
+        bool found = false;
+        while(true) {
+            const Node &node = snap->nodes.at(nodeIndex);
+            const QString &label = snap->keys.at(node.keyRef);
+            int k = 0;
+            while(k < node.labelLength && pos < key.size()
+                  && label.at(node.labelStart + k) == key.at(pos)) {
+                ++k;
+                ++pos;
+            }
+            if(pos == key.size()) {
+                found = true;
+                break;
+            }
+            if(k < node.labelLength) break;
+
+            // 子结点按首字符有序，二分查找
+            QChar c = key.at(pos);
+            int left = node.firstChild;
+            int right = node.firstChild + node.childCount;
+            while(left < right) {
+                int mid = (left + right) / 2;
+                const Node &child = snap->nodes.at(mid);
+                if(snap->keys.at(child.keyRef).at(child.labelStart) < c) {
+                    left = mid + 1;
+                } else {
+                    right = mid;
+                }
+            }
+            if(left == node.firstChild + node.childCount) break;
+            const Node &child = snap->nodes.at(left);
+            if(snap->keys.at(child.keyRef).at(child.labelStart) != c) break;
+            nodeIndex = left;
+        }
+
+        if(found) {
+            const Node &node = snap->nodes.at(nodeIndex);
+            bool skipped = false;
+            for(int t = 0; t < node.topCount; ++t) {
+                int index = snap->top.at(node.topStart + t);
+                // 增量表里有这个键时由下面按合并后的条目数和热度处理
+                if(pending.contains(snap->keys.at(index))) {
+                    skipped = true;
+                    continue;
+                }
+                Entry entry = { snap->texts.at(index), snap->weights.at(index) };
+                matches.append(entry);
+            }
+
+            // 跳过的位置要从子树更深处补上，否则删书或热度变化后候选会少于 limit。
+            // 子树的键在有序键表里是连续的一段，在其中按热度取前 limit 个不在增量表里的键；
+            // 增量表并入快照后又回到只读结点的前 K 个
+            if(skipped && node.topCount == TopK) {
+                matches.clear();
+                QVector<int> candidates;
+                int first = int(std::lower_bound(snap->keys.constBegin(), snap->keys.constEnd(), key)
+                                - snap->keys.constBegin());
+                for(int i = first; i < snap->keys.size() && snap->keys.at(i).startsWith(key); ++i) {
+                    if(!pending.contains(snap->keys.at(i))) candidates.append(i);
+                }
+                int take = qMin(limit, candidates.size());
+                const QVector<quint32> &weights = snap->weights;
+                std::partial_sort(candidates.begin(), candidates.begin() + take, candidates.end(),
+                                  [&weights](int a, int b) {
+                    if(weights.at(a) != weights.at(b)) return weights.at(a) > weights.at(b);
+                    return a < b;
+                });
+                for(int t = 0; t < take; ++t) {
+                    Entry entry = { snap->texts.at(candidates.at(t)), snap->weights.at(candidates.at(t)) };
+                    matches.append(entry);
+                }
+            }
+        }
+    }
+
+    // 增量表很小，直接线性匹配；条目数减到 0 的键（书已删完）不再联想
+    foreach (const Change &change, pending) {
+        if(!change.key.startsWith(key)) continue;
+        int index = snap ? findKey(*snap, change.key) : -1;
+        int count = change.count + (index >= 0 ? snap->counts.at(index) : 0);
+        if(count <= 0) continue;
+        Entry match = { index >= 0 ? snap->texts.at(index) : change.text,
+                        change.weight + (index >= 0 ? snap->weights.at(index) : 0) };
+        matches.append(match);
+    }
+
+    std::stable_sort(matches.begin(), matches.end(), [](const Entry &a, const Entry &b) {
+        return a.weight > b.weight;
+    });
+    QSet<QString> seen;
+    foreach (const Entry &entry, matches) {
+        if(result.size() >= limit) break;
+        if(seen.contains(entry.text)) continue;
+        seen.insert(entry.text);
+        result.append(entry.text);
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+// include/completiontrie.h
+#ifndef COMPLETIONTRIE_H
+#define COMPLETIONTRIE_H
+
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QFuture>
+#include <QThreadPool>
+#include <QMutex>
+#include <QSharedPointer>
+
+// 输入联想：书名/作者/ISBN 的压缩前缀树（基数树）
+// 每个结点预先算好子树中最热门的前 K 个候选，查询只需沿前缀走到结点直接返回，不访问数据库。
+// 增删图书先记进增量表，查询时与快照合并；增量表累计到 MergeThreshold 条时在后台并入新快照。
+class CompletionTrie : public QObject
+{
+    Q_OBJECT
+public:
+    struct Entry {
+        QString text;   // 显示文本
+        quint32 weight; // 热度（借阅次数）
+    };
+
+    static const int TopK = 8;
+    static const int MergeThreshold = 256;
+
+    static CompletionTrie* instance();
+
+    bool isReady() const;
+
+    // 从数据库加载书名、作者和ISBN并构建
+    bool rebuild();
+    // 在 pool 上后台构建
+    QFuture<bool> rebuildAsync(QThreadPool *pool);
+
+    // 图书入库、删除提交之后调用。同一书名或作者按条目计数，最后一本删掉后才不再联想；
+    // 删除不扣热度，下次全量构建时更正
+    void add(const Entry &entry);
+    void remove(const QString &text);
+
+    QStringList complete(const QString &prefix, int limit = TopK) const;
+
+private:
+    struct Node {
+        int keyRef;      // 边标签取自 m_keys[keyRef] 的 [labelStart, labelStart + labelLength)
+        int labelStart;
+        int labelLength;
+        int firstChild;  // 子结点在 nodes 中连续存放，按首字符排序
+        int childCount;
+        int topStart;    // 在 top 中的起始位置
+        int topCount;
+    };
+
+    struct Snapshot {
+        QVector<QString> keys;    // 规范化后的键，按字典序排列
+        QVector<QString> texts;   // 对应的显示文本
+        QVector<quint32> weights;
+        QVector<int> counts;      // 合并进这个键的条目数（如同一作者的多本书）
+        QVector<Node> nodes;
+        QVector<int> top;         // 各结点的前 K 个候选（keys 下标），按热度降序
+        qint64 appliedSeq;        // 已包含的最后一条增减
+        Snapshot() : appliedSeq(0) {}
+    };
+
+    // 一条增减；同一个键的多条在查询和合并时累加
+    struct Change {
+        QString key;
+        QString text;
+        quint32 weight;
+        int count;
+        qint64 seq;
+    };
+
+    explicit CompletionTrie(QObject *parent = nullptr);
+
+    static QString normalize(const QString &text);
+    static QSharedPointer<Snapshot> buildSnapshot(const QList<Entry> &entries);
+    static QSharedPointer<Snapshot> mergeSnapshot(const Snapshot &base, const QList<Change> &changes);
+    static QHash<QString, Change> pendingChanges(const Snapshot *base, const QList<Change> &changes);
+    static int findKey(const Snapshot &snap, const QString &key);
+    static void buildNodes(Snapshot &snap);
+    static void fillNode(Snapshot &snap, int nodeIndex, int lo, int hi, int labelStart);
+    void recordChange(const QString &text, quint32 weight, int count);
+    void installLocked(const QSharedPointer<Snapshot> &snap);
+    void merge();
+
+    mutable QMutex m_mutex;
+    QSharedPointer<const Snapshot> m_snapshot;
+    QList<Change> m_changes;    // 按 seq 递增，尚未并入快照的增减
+    qint64 m_lastSeq;
+    int m_building;             // 进行中的全量构建数，期间不合并
+    bool m_merging;
+};
+
+#endif // COMPLETIONTRIE_H
@@ -0,0 +1,277 @@
+// src/connectionpool.cpp
+#include "connectionpool.h"
+#include <QSqlDriver>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThread>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+
+ConnectionPool::Config::Config()
+    : driver("QMYSQL"), port(3306), minSize(2), maxSize(8),
+      acquireTimeoutMs(5000), validateAfterIdleMs(60000),
+      validationQuery("SELECT 1")
+{
+}
+
+ConnectionPool::ConnectionPool(const Config &config, QObject *parent)
+    : QObject(parent), m_config(config), m_total(0), m_serial(0)
+{
+    if(m_config.maxSize < 1) m_config.maxSize = 1;
+    if(m_config.minSize < 0) m_config.minSize = 0;
+    if(m_config.minSize > m_config.maxSize) m_config.minSize = m_config.maxSize;
+
+    m_metrics.acquires = 0;
+    m_metrics.releases = 0;
+    m_metrics.waits = 0;
+    m_metrics.timeouts = 0;
+    m_metrics.created = 0;
+    m_metrics.validationFailures = 0;
+    m_metrics.totalWaitMs = 0;
+    m_metrics.idle = 0;
+    m_metrics.inUse = 0;
+}
+
+ConnectionPool::~ConnectionPool()
+{
+    QMutexLocker lock(&m_mutex);
+    m_idle.clear();
+    m_connections.clear();
+}
+
+// 预热：在当前线程打开 minSize 个连接，随即脱离线程放入空闲队列
+bool ConnectionPool::warmUp()
+{
+    while(true) {
+        QString name;
+        {
+            QMutexLocker lock(&m_mutex);
+            if(m_total >= m_config.minSize) break;
+            m_total++;
+            name = nextConnectionName();
+        }
+
+        {
+            QSqlDatabase db = openConnection(name);
+            if(db.isOpen()) {
+                detach(db);
+                QMutexLocker lock(&m_mutex);
+                m_connections.insert(name, db);
+                m_metrics.created++;
+
+                IdleConnection idle;
+                idle.name = name;
+                idle.idleSince = QDateTime::currentMSecsSinceEpoch();
+                m_idle.append(idle);
+                m_metrics.idle = m_idle.size();
+                m_released.wakeOne();
+                continue;
+            }
+        }
+
+        QSqlDatabase::removeDatabase(name);
+        QMutexLocker lock(&m_mutex);
+        m_total--;
+        return false;
+    }
+    return true;
+}
+
+QSqlDatabase ConnectionPool::acquire()
+{
+    QString name;
+    qint64 idleSince = 0;
+    if(!reserveSlot(name, idleSince)) {
+        return QSqlDatabase();
+    }
+
+    if(!name.isEmpty()) {
+        QSqlDatabase db;
+        {
+            QMutexLocker lock(&m_mutex);
+            db = m_connections.value(name);
+        }
+        attach(db);
+
+        qint64 idleMs = QDateTime::currentMSecsSinceEpoch() - idleSince;
+        if(db.isOpen() && idleMs < m_config.validateAfterIdleMs) return db;
+        if(validate(db)) return db;
+
+        // 校验失败的连接直接丢弃，占用的名额留给新连接
+        qDebug() << "Pooled connection failed validation:" << name;
+        {
+            QMutexLocker lock(&m_mutex);
+            m_metrics.validationFailures++;
+            m_connections.remove(name);
+        }
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase(name);
+    }
+
+    QString fresh;
+    {
+        QMutexLocker lock(&m_mutex);
+        fresh = nextConnectionName();
+    }
+    {
+        QSqlDatabase db = openConnection(fresh);
+        if(db.isOpen()) {
+            QMutexLocker lock(&m_mutex);
+            m_connections.insert(fresh, db);
+            m_metrics.created++;
+            return db;
+        }
+    }
+
+    QSqlDatabase::removeDatabase(fresh);
+    QMutexLocker lock(&m_mutex);
+    m_total--;
+    m_metrics.inUse--;
+    m_released.wakeOne();
+    return QSqlDatabase();
+}
+
+// 必须在持有该连接的线程中调用
+void ConnectionPool::release(QSqlDatabase db)
+{
+    QString name = db.connectionName();
+    {
+        QMutexLocker lock(&m_mutex);
+        if(!db.isValid() || !m_connections.contains(name)) return;
+    }
+
+    detach(db);
+
+    QMutexLocker lock(&m_mutex);
+    IdleConnection idle;
+    idle.name = name;
+    idle.idleSince = QDateTime::currentMSecsSinceEpoch();
+    m_idle.append(idle);
+    m_metrics.releases++;
+    m_metrics.inUse--;
+    m_metrics.idle = m_idle.size();
+    m_released.wakeOne();
+}
+
+ConnectionPool::Config ConnectionPool::config() const
+{
+    return m_config;
+}
+
+ConnectionPool::Metrics ConnectionPool::metrics() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_metrics;
+}
+
+void ConnectionPool::setMaxSize(int maxSize)
+{
+    QMutexLocker lock(&m_mutex);
+    m_config.maxSize = qMax(1, maxSize);
+    if(m_config.minSize > m_config.maxSize) m_config.minSize = m_config.maxSize;
+    m_released.wakeAll(); // 上限变大时让等待者重新尝试新建连接
+}
+
+// 占用一个名额：优先取空闲连接(name 非空)，否则在上限内新建(name 为空)，都不行就等待
+bool ConnectionPool::reserveSlot(QString &name, qint64 &idleSince)
+{
+    QMutexLocker lock(&m_mutex);
+    m_metrics.acquires++;
+
+    QElapsedTimer timer;
+    timer.start();
+    bool waited = false;
+    while(true) {
+        if(!m_idle.isEmpty()) {
+            // 后进先出，优先复用最近用过的热连接
+            IdleConnection idle = m_idle.takeLast();
+            name = idle.name;
+            idleSince = idle.idleSince;
+            break;
+        }
+        if(m_total < m_config.maxSize) {
+            m_total++;
+            name.clear();
+            break;
+        }
+
+        if(!waited) {
+            m_metrics.waits++;
+            waited = true;
+        }
+        qint64 remaining = m_config.acquireTimeoutMs - timer.elapsed();
+        if(remaining <= 0) {
+            m_metrics.timeouts++;
+            m_metrics.totalWaitMs += timer.elapsed();
+            qDebug() << "Connection pool exhausted, acquire timed out after"
+                     << m_config.acquireTimeoutMs << "ms";
+            return false;
+        }
+        m_released.wait(&m_mutex, static_cast<unsigned long>(remaining));
+    }
+
+    if(waited) m_metrics.totalWaitMs += timer.elapsed();
+    m_metrics.inUse++;
+    m_metrics.idle = m_idle.size();
+    return true;
+}
+
+// 调用方需持有 m_mutex
+QString ConnectionPool::nextConnectionName()
+{
+    return QString("library_pool_%1").arg(++m_serial);
+}
+
+QSqlDatabase ConnectionPool::openConnection(const QString &name)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase(m_config.driver, name);
+    db.setHostName(m_config.hostName);
+    db.setDatabaseName(m_config.databaseName);
+    db.setUserName(m_config.userName);
+    db.setPassword(m_config.password);
+    db.setPort(m_config.port);
+    db.setConnectOptions(m_config.connectOptions);
+    if(!db.open()) {
+        qDebug() << "Database connection error:" << db.lastError().text();
+    } else if(!prepareConnection(db)) {
+        db.close();
+    }
+    return db;
+}
+
+bool ConnectionPool::prepareConnection(QSqlDatabase &db)
+{
+    foreach (const QString &sql, m_config.initStatements) {
+        QSqlQuery q(db);
+        if(!q.exec(sql)) {
+            qDebug() << "Connection setup error:" << q.lastError().text();
+            qDebug() << "Query:" << sql;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ConnectionPool::validate(QSqlDatabase &db)
+{
+    if(db.isOpen()) {
+        QSqlQuery q(db);
+        if(q.exec(m_config.validationQuery)) return true;
+        db.close();
+    }
+    // 重连一次
+    return db.open() && prepareConnection(db);
+}
+
+void ConnectionPool::detach(QSqlDatabase &db)
+{
+    if(db.driver()) db.driver()->moveToThread(nullptr);
+}
+
+void ConnectionPool::attach(QSqlDatabase &db)
+{
+    // 没有线程归属的对象可以被任意线程拉到当前线程
+    if(db.driver()) db.driver()->moveToThread(QThread::currentThread());
+}
@@ -0,0 +1,85 @@
+// include/connectionpool.h
+#ifndef CONNECTIONPOOL_H
+#define CONNECTIONPOOL_H
+
+#include <QObject>
+#include <QSqlDatabase>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QHash>
+#include <QList>
+#include <QStringList>
+
+// 数据库连接池
+// QSqlDatabase 不能跨线程共享，所以每个线程必须持有自己的命名连接。
+// 空闲连接的 driver 不属于任何线程，取出时由使用方线程"拉"到自己线程，归还时再推出去。
+class ConnectionPool : public QObject
+{
+    Q_OBJECT
+public:
+    struct Config {
+        QString driver;
+        QString hostName;
+        QString databaseName;
+        QString userName;
+        QString password;
+        int port;
+        QString connectOptions;
+        QStringList initStatements; // 每个新连接打开（含重连）后依次执行，如 SQLite 的 PRAGMA
+        int minSize;              // 启动时预热的连接数
+        int maxSize;              // 连接总数上限
+        int acquireTimeoutMs;     // 无空闲连接时的最长等待时间
+        int validateAfterIdleMs;  // 空闲超过该时间的连接在取出前先校验
+        QString validationQuery;
+        Config();
+    };
+
+    struct Metrics {
+        quint64 acquires;
+        quint64 releases;
+        quint64 waits;
+        quint64 timeouts;
+        quint64 created;
+        quint64 validationFailures;
+        qint64 totalWaitMs;
+        int idle;
+        int inUse;
+    };
+
+    explicit ConnectionPool(const Config &config, QObject *parent = nullptr);
+    ~ConnectionPool();
+
+    bool warmUp();
+    QSqlDatabase acquire();
+    void release(QSqlDatabase db);
+
+    Config config() const;
+    Metrics metrics() const;
+    // 调整连接上限（压测等需要更多并发连接时），已有连接不受影响
+    void setMaxSize(int maxSize);
+
+private:
+    struct IdleConnection {
+        QString name;
+        qint64 idleSince;
+    };
+
+    bool reserveSlot(QString &name, qint64 &idleSince);
+    QString nextConnectionName();
+    QSqlDatabase openConnection(const QString &name);
+    bool prepareConnection(QSqlDatabase &db);
+    bool validate(QSqlDatabase &db);
+    void detach(QSqlDatabase &db);
+    void attach(QSqlDatabase &db);
+
+    Config m_config;
+    mutable QMutex m_mutex;
+    QWaitCondition m_released;
+    QHash<QString, QSqlDatabase> m_connections;
+    QList<IdleConnection> m_idle;
+    int m_total;
+    int m_serial;
+    Metrics m_metrics;
+};
+
+#endif // CONNECTIONPOOL_H
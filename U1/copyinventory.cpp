@@ -0,0 +1,195 @@
+// src/copyinventory.cpp
+#include "copyinventory.h"
+#include "database.h"
+#include "entitycache.h"
+#include <QSqlQuery>
+#include <QDebug>
+
+static const int MaxSamples = 20;
+
+CopyInventory::VerifyReport::VerifyReport()
+    : ok(false), titles(0), mismatched(0), repaired(0), staleShelves(0)
+{
+}
+
+CopyInventory::CopyInventory()
+{
+}
+
+CopyInventory* CopyInventory::instance()
+{
+    static CopyInventory *instance = new CopyInventory();
+    return instance;
+}
+
+bool CopyInventory::loadShelf(const QString &isbn, Shelf *shelf)
+{
+    QSqlQuery q = Database::instance()->executePreparedQuery("inventory.copies",
+        "SELECT CopyID, Status FROM BookCopies WHERE ISBN = ? ORDER BY CopyID", {isbn});
+    if(!q.isActive()) return false;
+
+    shelf->copyIds.clear();
+    shelf->slots.clear();
+    shelf->available.clear();
+    shelf->availableCount = 0;
+    while(q.next()) {
+        int slot = shelf->copyIds.size();
+        shelf->copyIds.append(q.value(0).toString());
+        shelf->slots.insert(shelf->copyIds.last(), slot);
+        if(slot % 64 == 0) shelf->available.append(0);
+        if(q.value(1).toString() == "Available") {
+            shelf->available[slot / 64] |= quint64(1) << (slot % 64);
+            shelf->availableCount++;
+        }
+    }
+    return true;
+}
+
+// 调用方持有 m_mutex；加载期间放开锁，数据库查询不阻塞其他图书
+CopyInventory::Shelf *CopyInventory::shelfLocked(const QString &isbn)
+{
+    auto it = m_shelves.find(isbn);
+    if(it != m_shelves.end()) return &it.value();
+
+    Shelf shelf;
+    m_mutex.unlock();
+    bool loaded = loadShelf(isbn, &shelf);
+    m_mutex.lock();
+    if(!loaded) return nullptr;
+    it = m_shelves.find(isbn);
+    if(it == m_shelves.end()) it = m_shelves.insert(isbn, shelf);
+    return &it.value();
+}
+
+QString CopyInventory::pickAvailable(const QString &isbn)
+{
+    QMutexLocker lock(&m_mutex);
+    Shelf *shelf = shelfLocked(isbn);
+    if(!shelf || shelf->availableCount == 0) return QString();
+    for(int word = 0; word < shelf->available.size(); ++word) {
+        quint64 bits = shelf->available.at(word);
+        if(bits) {
+            return shelf->copyIds.at(word * 64 + qCountTrailingZeroBits(bits));
+        }
+    }
+    return QString();
+}
+
+void CopyInventory::setAvailable(const QString &isbn, const QString &copyId, bool available)
+{
+    if(copyId.isEmpty()) return;
+    QMutexLocker lock(&m_mutex);
+    auto it = m_shelves.find(isbn);
+    if(it == m_shelves.end()) return; // 还没加载过，下次加载时从数据库读到最新状态
+    Shelf &shelf = it.value();
+    auto slot = shelf.slots.constFind(copyId);
+    if(slot == shelf.slots.constEnd()) {
+        // 位图加载之后新增的副本
+        m_shelves.erase(it);
+        return;
+    }
+    quint64 &word = shelf.available[slot.value() / 64];
+    quint64 mask = quint64(1) << (slot.value() % 64);
+    if(available && !(word & mask)) {
+        word |= mask;
+        shelf.availableCount++;
+    } else if(!available && (word & mask)) {
+        word &= ~mask;
+        shelf.availableCount--;
+    }
+}
+
+void CopyInventory::markBorrowed(const QString &isbn, const QString &copyId)
+{
+    setAvailable(isbn, copyId, false);
+}
+
+void CopyInventory::markAvailable(const QString &isbn, const QString &copyId)
+{
+    setAvailable(isbn, copyId, true);
+}
+
+int CopyInventory::availableCopies(const QString &isbn)
+{
+    QMutexLocker lock(&m_mutex);
+    Shelf *shelf = shelfLocked(isbn);
+    return shelf ? shelf->availableCount : 0;
+}
+
+void CopyInventory::invalidate(const QString &isbn)
+{
+    QMutexLocker lock(&m_mutex);
+    m_shelves.remove(isbn);
+}
+
+void CopyInventory::invalidateAll()
+{
+    QMutexLocker lock(&m_mutex);
+    m_shelves.clear();
+}
+
+// 一条聚合查询按书推出可借数：可借副本 - 为预约保留的册数；没有副本记录的旧书不参与核对
+CopyInventory::VerifyReport CopyInventory::verify(bool repair)
+{
+    VerifyReport report;
+    Database *db = Database::instance();
+    QSqlQuery q(db->connection());
+    q.setForwardOnly(true);
+    if(!q.exec("SELECT b.ISBN, b.AvailableCopies, c.Available, COALESCE(r.Held, 0) "
+               "FROM Books b "
+               "JOIN (SELECT ISBN, SUM(CASE WHEN Status = 'Available' THEN 1 ELSE 0 END) AS Available "
+               "      FROM BookCopies GROUP BY ISBN) c ON c.ISBN = b.ISBN "
+               "LEFT JOIN (SELECT ISBN, COUNT(*) AS Held FROM Reservations "
+               "           WHERE Status = 'Ready' GROUP BY ISBN) r ON r.ISBN = b.ISBN")) {
+        qDebug() << "Inventory verify query failed";
+        return report;
+    }
+
+    QHash<QString, int> derived;   // 不符的图书 -> 推出的可借数
+    QHash<QString, int> shelved;   // 各书可借副本数，用于核对内存位图
+    while(q.next()) {
+        QString isbn = q.value(0).toString();
+        int recorded = q.value(1).toInt();
+        int available = q.value(2).toInt();
+        int expected = qMax(0, available - q.value(3).toInt());
+        report.titles++;
+        shelved.insert(isbn, available);
+        if(recorded != expected) {
+            report.mismatched++;
+            derived.insert(isbn, expected);
+            if(report.samples.size() < MaxSamples) {
+                report.samples << QString("%1 recorded=%2 derived=%3").arg(isbn).arg(recorded).arg(expected);
+            }
+        }
+    }
+    q.finish();
+
+    if(repair && !derived.isEmpty()) {
+        if(!db->transaction()) return report;
+        for(auto it = derived.constBegin(); it != derived.constEnd(); ++it) {
+            if(!db->executePrepared("inventory.repair",
+                    "UPDATE Books SET AvailableCopies = ? WHERE ISBN = ?", {it.value(), it.key()})) {
+                db->rollback();
+                return report;
+            }
+        }
+        if(!db->commit()) return report;
+        report.repaired = derived.size();
+        for(auto it = derived.constBegin(); it != derived.constEnd(); ++it) {
+            EntityCache::instance()->invalidateBook(it.key());
+        }
+    }
+
+    // 已加载的位图计数与数据库不同时丢弃，下次按数据库重新加载
+    QMutexLocker lock(&m_mutex);
+    for(auto it = m_shelves.begin(); it != m_shelves.end(); ) {
+        if(it.value().availableCount != shelved.value(it.key())) {
+            report.staleShelves++;
+            it = m_shelves.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    report.ok = true;
+    return report;
+}
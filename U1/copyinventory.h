@@ -0,0 +1,62 @@
+// include/copyinventory.h
+#ifndef COPYINVENTORY_H
+#define COPYINVENTORY_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+
+// 副本级库存
+// 每本书第一次借阅时从 BookCopies 加载该书的副本，在内存里保存一张可借位图（每册一位），
+// 借书时取第一个置位的位（find-first-set，每次跳过64册）作为建议借出的副本，交给存储后端在事务里确认；
+// 借还成功后按实际借出/归还的副本更新位图。几千册的教材也只是几十个字。
+// Books.AvailableCopies 仍是借阅判断的依据，它应等于可借副本数减去为预约保留的册数，verify() 核对这一点。
+class CopyInventory
+{
+public:
+    struct VerifyReport {
+        bool ok;
+        int titles;         // 核对的图书数
+        int mismatched;     // AvailableCopies 与副本状态不符的图书数
+        int repaired;
+        int staleShelves;   // 内存位图与数据库不符、已丢弃重载的图书数
+        QStringList samples;    // 前几条不符的明细
+        VerifyReport();
+    };
+
+    static CopyInventory* instance();
+
+    // 建议借出的副本；该书没有副本记录或都已借出时返回空串
+    QString pickAvailable(const QString &isbn);
+    void markBorrowed(const QString &isbn, const QString &copyId);
+    void markAvailable(const QString &isbn, const QString &copyId);
+    int availableCopies(const QString &isbn);
+
+    // 副本被批量改动（导入、删书、核对修复）后丢弃内存位图，下次使用时重新加载
+    void invalidate(const QString &isbn);
+    void invalidateAll();
+
+    // 按副本状态核对 AvailableCopies；repair 时改成由副本推出的值
+    VerifyReport verify(bool repair);
+
+private:
+    CopyInventory();
+
+    struct Shelf {
+        QVector<QString> copyIds;
+        QHash<QString, int> slots;
+        QVector<quint64> available;     // 第 i 位为 1 表示 copyIds[i] 可借
+        int availableCount;
+    };
+
+    static bool loadShelf(const QString &isbn, Shelf *shelf);
+    Shelf *shelfLocked(const QString &isbn);
+    void setAvailable(const QString &isbn, const QString &copyId, bool available);
+
+    QMutex m_mutex;
+    QHash<QString, Shelf> m_shelves;
+};
+
+#endif // COPYINVENTORY_H
@@ -0,0 +1,14 @@
+# 链接 core.pro 生成的静态库；由 librarysystem.pro 保证先于使用者构建
+# 静态库在本文件所在目录对应的构建目录里，tests/ 下的子工程也能找到
+QT += sql concurrent
+INCLUDEPATH += $$PWD
+DEPENDPATH += $$PWD
+
+CORE_OUT_PWD = $$shadowed($$PWD)
+CORE_LIB_DIR = $$CORE_OUT_PWD
+win32:CONFIG(release, debug|release): CORE_LIB_DIR = $$CORE_OUT_PWD/release
+else:win32:CONFIG(debug, debug|release): CORE_LIB_DIR = $$CORE_OUT_PWD/debug
+
+LIBS += -L$$CORE_LIB_DIR -llibrarycore
+win32-msvc*: PRE_TARGETDEPS += $$CORE_LIB_DIR/librarycore.lib
+else: PRE_TARGETDEPS += $$CORE_LIB_DIR/liblibrarycore.a
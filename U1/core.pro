@@ -0,0 +1,65 @@
+# 业务与存储核心：不依赖任何控件，图形界面程序和命令行压测工具都链接这个静态库
+TEMPLATE = lib
+TARGET = librarycore
+CONFIG += staticlib c++11
+QT = core sql concurrent
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+SOURCES += \
+    book.cpp \
+    catalogbenchmark.cpp \
+    catalogimporter.cpp \
+    catalogindex.cpp \
+    circulationbenchmark.cpp \
+    circulationstore.cpp \
+    coborrowindex.cpp \
+    comment.cpp \
+    completiontrie.cpp \
+    connectionpool.cpp \
+    copyinventory.cpp \
+    database.cpp \
+    entitycache.cpp \
+    entityloader.cpp \
+    library.cpp \
+    mysqlbackend.cpp \
+    overdueengine.cpp \
+    records.cpp \
+    reservationqueue.cpp \
+    schemamigrator.cpp \
+    sqlitebackend.cpp \
+    startuptimer.cpp \
+    storagebackend.cpp \
+    streamingexporter.cpp \
+    unitofwork.cpp \
+    user.cpp
+
+HEADERS += \
+    book.h \
+    catalogbenchmark.h \
+    catalogimporter.h \
+    catalogindex.h \
+    circulationbenchmark.h \
+    circulationstore.h \
+    coborrowindex.h \
+    comment.h \
+    completiontrie.h \
+    connectionpool.h \
+    copyinventory.h \
+    database.h \
+    entitycache.h \
+    entityloader.h \
+    futurecontinuation.h \
+    library.h \
+    mysqlbackend.h \
+    overdueengine.h \
+    records.h \
+    recordstream.h \
+    reservationqueue.h \
+    schemamigrator.h \
+    sqlitebackend.h \
+    startuptimer.h \
+    storagebackend.h \
+    streamingexporter.h \
+    unitofwork.h \
+    user.h
@@ -0,0 +1,81 @@
+// src/corebench.cpp
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include "database.h"
+#include "library.h"
+#include "catalogbenchmark.h"
+#include "circulationbenchmark.h"
+
+// 预编译语句缓存的命中情况，跟在压测结果后面输出
+static void printStatementCache(QTextStream &out)
+{
+    Database::StatementCacheStats stats = Database::instance()->statementCacheStats();
+    quint64 lookups = stats.hits + stats.misses;
+    out << "statement_cache_hits=" << stats.hits << '\n'
+        << "statement_cache_misses=" << stats.misses << '\n'
+        << "statement_cache_hit_rate=" << QString::number(lookups ? double(stats.hits) / lookups : 0.0, 'f', 4) << '\n'
+        << "statement_cache_size=" << stats.cachedStatements << endl;
+}
+
+// 无界面压测工具：只依赖核心库，可在没有显示器的服务器上运行
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption sizes("sizes",
+        "Comma-separated catalog sizes (default 10000,100000,1000000).", "list");
+    parser.addOption(sizes);
+    QCommandLineOption minDuration("min-ms",
+        "Minimum measured time per benchmark in milliseconds (default 1000).", "ms");
+    parser.addOption(minDuration);
+    QCommandLineOption keepData("keep-data",
+        "Keep the seeded catalog so the next run skips seeding.");
+    parser.addOption(keepData);
+    QCommandLineOption circulation("circulation",
+        "Run the concurrent borrow/return benchmark instead of the catalog benchmark.");
+    parser.addOption(circulation);
+    QCommandLineOption config("config",
+        "Storage config file (default: library.ini next to the executable).", "file");
+    parser.addOption(config);
+    parser.process(a);
+
+    if(parser.isSet(config)) {
+        Database::setConfigFile(parser.value(config));
+    }
+
+    if(!Database::instance()->initialize()) {
+        qDebug() << "Failed to initialize database!";
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    if(parser.isSet(circulation)) {
+        Library library;
+        CirculationBenchmark benchmark(&library);
+        bool ok = benchmark.run(CirculationBenchmark::Options(), out);
+        printStatementCache(out);
+        return ok ? 0 : 1;
+    }
+
+    CatalogBenchmark::Options options;
+    if(parser.isSet(sizes)) {
+        options.catalogSizes.clear();
+        foreach (const QString &size, parser.value(sizes).split(',', QString::SkipEmptyParts)) {
+            int value = size.trimmed().toInt();
+            if(value > 0) options.catalogSizes << value;
+        }
+    }
+    if(parser.isSet(minDuration)) {
+        options.minDurationMs = qMax(1, parser.value(minDuration).toInt());
+    }
+    options.keepData = parser.isSet(keepData);
+
+    Library library;
+    CatalogBenchmark benchmark(&library);
+    bool ok = benchmark.run(options, out);
+    printStatementCache(out);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,13 @@
+# 馆藏规模压测工具，只链接核心库，不依赖图形界面
+TEMPLATE = app
+TARGET = corebench
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(core.pri)
+
+SOURCES += \
+    corebench.cpp
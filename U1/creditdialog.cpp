@@ -9,13 +9,8 @@ CreditDialog::CreditDialog(User *user, Library *library, QWidget *parent)
     ui->setupUi(this);
     setWindowTitle("信用分管理");
 
-    // 显示用户信息
-    ui->lblUserName->setText(m_user->name());
-    ui->lblCreditScore->setText(QString::number(m_user->creditScore()));
-
-    // 显示当前罚款
-    double fines = m_library->getUserFines(m_user->id());
-    ui->lblFines->setText(QString::number(fines, 'f', 2));
+    // 显示用户信息、信用分和当前罚款
+    refreshDashboard();
 
     // 连接信号槽
     connect(ui->btnAddCredit, &QPushButton::clicked, this, &CreditDialog::onAddCreditClicked);
@@ -53,13 +48,25 @@ void CreditDialog::onPayWithCreditClicked()
     m_user->payFineWithCredit(amount);
 
     // 更新显示
-    double fines = m_library->getUserFines(m_user->id());
-    ui->lblFines->setText(QString::number(fines, 'f', 2));
-    ui->lblCreditScore->setText(QString::number(m_user->creditScore()));
+    refreshDashboard();
 
     QMessageBox::information(this, "成功",
         QString("罚款支付成功！信用分增加 %1 分").arg(static_cast<int>(amount)));
 }
+// 与主窗口共用读者面板快照，一次查询取回姓名、信用分和罚款
+void CreditDialog::refreshDashboard()
+{
+    Library::UserDashboard dashboard = m_library->loadUserDashboard(m_user->id());
+    if(!dashboard.valid) {
+        ui->lblUserName->setText(m_user->name());
+        ui->lblCreditScore->setText(QString::number(m_user->creditScore()));
+        return;
+    }
+    ui->lblUserName->setText(dashboard.name);
+    ui->lblCreditScore->setText(QString::number(dashboard.creditScore));
+    ui->lblFines->setText(QString::number(dashboard.fines, 'f', 2));
+}
+
 CreditDialog::~CreditDialog()
 {
     delete ui;
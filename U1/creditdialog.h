@@ -25,6 +25,8 @@ private slots:
     void onPayWithCreditClicked();
 
 private:
+    void refreshDashboard();
+
     Ui::CreditDialog *ui;
     User *m_user;
     Library *m_library;
@@ -1,115 +1,107 @@
 // src/database.cpp
 #include "database.h"
+#include "schemamigrator.h"
+#include "storagebackend.h"
+#include "startuptimer.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
 
-Database* Database::m_instance = nullptr;
+QString Database::m_configFile;
 
-Database::Database(QObject *parent) : QObject(parent)
+// 表结构指纹：后端、迁移列表和例程的哈希，程序内置的表结构不变时与库中记录的一致
+static QByteArray schemaFingerprint(StorageBackend *backend)
 {
-    db = QSqlDatabase::addDatabase("QMYSQL");
-    db.setHostName("localhost");
-    db.setDatabaseName("library_system");
-    db.setUserName("root");
-    db.setPassword("123456");
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(backend->name().toUtf8());
+    const QVector<SchemaMigrator::Migration> &migrations = backend->migrations();
+    for(int i = 0; i < migrations.size(); ++i) {
+        hash.addData(QByteArray::number(migrations[i].version));
+        hash.addData(migrations[i].description.toUtf8());
+        foreach (const QString &sql, migrations[i].statements) {
+            hash.addData(sql.toUtf8());
+        }
+    }
+    foreach (const QString &sql, backend->routines()) {
+        hash.addData(sql.toUtf8());
+    }
+    return hash.result().toHex();
+}
+
+Database::Database(QObject *parent) : QObject(parent),
+    m_statementHits(0), m_statementMisses(0), m_cachedStatements(0)
+{
+    m_backend = StorageBackend::create(configFile());
+    qDebug() << "Storage backend:" << m_backend->name();
+    m_pool = new ConnectionPool(m_backend->connectionConfig(), this);
 }
 
 Database::~Database()
 {
-    if(db.isOpen()) db.close();
+    clearStatementCache();
+    releaseConnection();
+    delete m_backend;
+}
+
+void Database::setConfigFile(const QString &path)
+{
+    m_configFile = path;
+}
+
+// 未指定时依次使用环境变量 LIBRARY_CONFIG 和程序目录下的 library.ini
+QString Database::configFile()
+{
+    if(!m_configFile.isEmpty()) return m_configFile;
+    QString fromEnvironment = qEnvironmentVariable("LIBRARY_CONFIG");
+    if(!fromEnvironment.isEmpty()) return fromEnvironment;
+    return QDir(QCoreApplication::applicationDirPath()).filePath("library.ini");
+}
+
+StorageBackend* Database::backend() const
+{
+    return m_backend;
+}
+
+Database::ThreadConnection::~ThreadConnection()
+{
+    // 先释放语句再归还连接，语句不能跟着连接流到别的线程
+    owner->m_cachedStatements.fetchAndAddRelaxed(-statements.size());
+    statements.clear();
+    if(db.isValid()) owner->m_pool->release(db);
 }
 
 bool Database::initialize()
 {
-    if(!db.open()) {
+    if(!m_pool->warmUp()) {
+        qDebug() << "Database connection error: connection pool warm-up failed";
+        return false;
+    }
+
+    QSqlDatabase db = connection();
+    if(!db.isOpen()) {
         qDebug() << "Database connection error:" << db.lastError().text();
         return false;
     }
+    StartupTimer::mark("connect");
 
-    // 创建表结构
-    QStringList tables = {
-        "CREATE TABLE IF NOT EXISTS Users ("
-        "   UserID VARCHAR(6) PRIMARY KEY,"
-        "   Email VARCHAR(50) UNIQUE NOT NULL,"
-        "   Password VARCHAR(255) NOT NULL,"
-        "   Name VARCHAR(50) NOT NULL,"
-        "   Type ENUM('Normal', 'Super') DEFAULT 'Normal',"
-        "   TotalReadingHours FLOAT DEFAULT 0.0,"
-        "   Fines DECIMAL(10,2) DEFAULT 0.0,"
-        "   CreditScore INT DEFAULT 100,"  // 信用分
-        "   HadLowCredit BOOLEAN DEFAULT FALSE" // 是否曾低于90分
-        ");",
-
-        "CREATE TABLE IF NOT EXISTS Books ("
-        "   ISBN VARCHAR(20) PRIMARY KEY,"
-        "   Title VARCHAR(255) NOT NULL,"
-        "   Author VARCHAR(100) NOT NULL,"
-        "   Publisher VARCHAR(100),"
-        "   PublishDate DATE,"
-        "   Price DECIMAL(10,2),"
-        "   Introduction TEXT,"
-        "   TotalCopies INT NOT NULL,"
-        "   AvailableCopies INT NOT NULL"
-        ");",
-
-        "CREATE TABLE IF NOT EXISTS BorrowRecords ("
-        "   RecordID INT AUTO_INCREMENT PRIMARY KEY,"
-        "   UserID VARCHAR(6) NOT NULL,"
-        "   ISBN VARCHAR(20) NOT NULL,"
-        "   BorrowDate DATE NOT NULL,"
-        "   DueDate DATE NOT NULL,"
-        "   ReturnDate DATE,"
-        "   Fine DECIMAL(10,2) DEFAULT 0.0,"
-        "   CreditDeduction INT DEFAULT 0,"  // 信用分扣除
-        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
-        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
-        ");",
-
-        "CREATE TABLE IF NOT EXISTS Comments ("
-        "   CommentID INT AUTO_INCREMENT PRIMARY KEY,"
-        "   UserID VARCHAR(6) NOT NULL,"
-        "   ISBN VARCHAR(20) NOT NULL,"
-        "   Comment TEXT,"
-        "   Rating INT CHECK (Rating BETWEEN 1 AND 5),"
-        "   CommentDate DATETIME NOT NULL,"
-        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
-        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
-        ");",
-
-        "CREATE TABLE IF NOT EXISTS Reservations ("
-        "   ReservationID INT AUTO_INCREMENT PRIMARY KEY,"
-        "   UserID VARCHAR(6) NOT NULL,"
-        "   ISBN VARCHAR(20) NOT NULL,"
-        "   ReserveDate DATETIME NOT NULL,"
-        "   Status ENUM('Pending', 'Fulfilled', 'Cancelled') DEFAULT 'Pending',"
-        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
-        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
-        ");"
-    };
-
-    foreach (const QString &tableSql, tables) {
-        if(!execute(tableSql)) {
-            return false;
-        }
+    // 指纹一致说明迁移、存储过程和管理员账号上次都已就绪，一条查询代替全部 DDL
+    QByteArray fingerprint = schemaFingerprint(m_backend);
+    QSqlQuery stored = executeQuery("SELECT Fingerprint FROM SchemaState WHERE Id = 1");
+    if(stored.next() && stored.value(0).toByteArray() == fingerprint) {
+        StartupTimer::mark("schema");
+        return true;
+    }
+
+    // 表结构按版本迁移，见 SchemaMigrator
+    SchemaMigrator migrator(this);
+    if(!migrator.migrate()) {
+        return false;
     }
 
-    // 确保新字段存在 - 使用更兼容的方式
-    QStringList columnsToAdd = {
-        "ALTER TABLE Users ADD COLUMN CreditScore INT DEFAULT 100",
-        "ALTER TABLE Users ADD COLUMN HadLowCredit BOOLEAN DEFAULT FALSE",
-        "ALTER TABLE Users ADD COLUMN Type VARCHAR(16) DEFAULT 'Normal'", // 新增
-        "ALTER TABLE BorrowRecords ADD COLUMN CreditDeduction INT DEFAULT 0"
-    };
-
-    foreach (const QString &alterSql, columnsToAdd) {
-        QSqlQuery q(db);
-        if (!q.exec(alterSql)) {
-            // 检查是否是"列已存在"的错误
-            if (q.lastError().text().contains("Duplicate column name")) {
-                qDebug() << "Column already exists, skipping:" << alterSql;
-            } else {
-                qDebug() << "Error adding column:" << q.lastError().text();
-                qDebug() << "Query:" << alterSql;
-                // 对于非重复列错误，可以选择记录但继续
-            }
+    // 存储过程等例程：表结构指纹变化时重建，过程体随程序版本更新
+    foreach (const QString &routineSql, m_backend->routines()) {
+        if(!execute(routineSql)) {
+            return false;
         }
     }
 
@@ -125,13 +117,20 @@ bool Database::initialize()
         execute(insertAdmin);
     }
 
+    if(!executePrepared("schema.fingerprint",
+            QString("REPLACE INTO SchemaState (Id, Fingerprint, UpdatedAt) VALUES (1, ?, %1)").arg(m_backend->now()),
+            {QString::fromLatin1(fingerprint)})) {
+        return false;
+    }
+
+    StartupTimer::mark("schema");
     return true;
 }
 
 
 bool Database::execute(const QString &query)
 {
-    QSqlQuery q(db);
+    QSqlQuery q(connection());
     if(!q.exec(query)) {
         qDebug() << "Query error:" << q.lastError().text();
         qDebug() << "Query:" << query;
@@ -142,11 +141,193 @@ bool Database::execute(const QString &query)
 
 QSqlQuery Database::executeQuery(const QString &query)
 {
-    QSqlQuery q(db);
+    QSqlQuery q(connection());
     q.exec(query);
     return q;
 }
 
+QSqlDatabase Database::connection()
+{
+    ThreadConnection *conn = threadConnection();
+    return conn->db;
+}
+
+bool Database::transaction()
+{
+    ThreadConnection *conn = threadConnection();
+    // 由后端决定怎样开启：SQLite 用 BEGIN IMMEDIATE
+    if(!m_backend->beginTransaction(conn->db)) {
+        qDebug() << "Begin transaction error:" << conn->db.lastError().text();
+        return false;
+    }
+    conn->inTransaction = true;
+    return true;
+}
+
+bool Database::commit()
+{
+    ThreadConnection *conn = threadConnection();
+    conn->inTransaction = false;
+    if(!conn->db.commit()) {
+        qDebug() << "Commit error:" << conn->db.lastError().text();
+        conn->db.rollback();
+        return false;
+    }
+    return true;
+}
+
+bool Database::rollback()
+{
+    ThreadConnection *conn = threadConnection();
+    conn->inTransaction = false;
+    return conn->db.rollback();
+}
+
+// 当前线程是否已经开启事务（工作单元据此决定是否并入调用方的事务）
+bool Database::inTransaction()
+{
+    ThreadConnection *conn = threadConnection();
+    return conn->inTransaction;
+}
+
+void Database::releaseConnection()
+{
+    if(m_threadConnections.hasLocalData()) {
+        m_threadConnections.setLocalData(nullptr); // 删除旧数据并归还连接
+    }
+}
+
+ConnectionPool* Database::pool() const
+{
+    return m_pool;
+}
+
+Database::ThreadConnection* Database::threadConnection()
+{
+    ThreadConnection *conn = m_threadConnections.hasLocalData() ? m_threadConnections.localData() : nullptr;
+    if(!conn || !conn->db.isValid()) {
+        if(!conn) {
+            conn = new ThreadConnection;
+            conn->owner = this;
+            conn->inTransaction = false;
+            m_threadConnections.setLocalData(conn);
+        }
+        conn->db = m_pool->acquire();
+    }
+    return conn;
+}
+
+QSqlQuery Database::preparedStatement(const QString &name, const QString &sql)
+{
+    ThreadConnection *conn = threadConnection();
+    if(!m_backend->cachesStatements()) {
+        QSqlQuery q(conn->db);
+        if(!q.prepare(sql)) {
+            qDebug() << "Prepare error:" << q.lastError().text();
+            qDebug() << "Query:" << sql;
+        }
+        return q;
+    }
+
+    QHash<QString, CachedStatement> &statements = conn->statements;
+
+    auto it = statements.find(name);
+    if(it != statements.end()) {
+        const QSqlQuery &cached = it.value().query;
+        if(it.value().sql != sql) {
+            // 同名但SQL不同，说明调用方用错了名称，重新prepare
+            qDebug() << "Prepared statement name reused with different SQL:" << name;
+        } else if(!cached.isActive() || cached.at() == QSql::AfterLastRow) {
+            m_statementHits.fetchAndAddRelaxed(1);
+            return cached;
+        }
+        // 否则上一次的结果集既没读完也没 finish()，调用方可能还在读（例如遍历结果时又调用了同名语句），
+        // 在它上面重新执行会冲掉对方的结果。另 prepare 一条换进缓存，旧的只留给仍持有它的调用方
+        statements.erase(it);
+        m_cachedStatements.fetchAndAddRelaxed(-1);
+    }
+
+    m_statementMisses.fetchAndAddRelaxed(1);
+    QSqlQuery q(conn->db);
+    if(!q.prepare(sql)) {
+        qDebug() << "Prepare error:" << q.lastError().text();
+        qDebug() << "Query:" << sql;
+        return q;
+    }
+
+    CachedStatement stmt;
+    stmt.sql = sql;
+    stmt.query = q;
+    statements.insert(name, stmt);
+    m_cachedStatements.fetchAndAddRelaxed(1);
+    return q;
+}
+
+bool Database::bindAndExec(QSqlQuery &q, const QString &name, const QVariantList &params)
+{
+    // QDate/QDateTime/double 等直接以原生类型绑定，不再拼接字符串
+    for(int i = 0; i < params.size(); ++i) {
+        q.bindValue(i, params.at(i));
+    }
+    if(!q.exec()) {
+        qDebug() << "Prepared query error:" << q.lastError().text();
+        qDebug() << "Statement:" << name;
+        return false;
+    }
+    return true;
+}
+
+bool Database::executePrepared(const QString &name, const QString &sql,
+                               const QVariantList &params, int *rowsAffected)
+{
+    QSqlQuery q = preparedStatement(name, sql);
+    bool ok = bindAndExec(q, name, params);
+    if(rowsAffected) {
+        *rowsAffected = ok ? q.numRowsAffected() : 0;
+    }
+    q.finish(); // 结果不交给调用方，语句马上可以复用
+    return ok;
+}
+
+QSqlQuery Database::executePreparedQuery(const QString &name, const QString &sql,
+                                         const QVariantList &params)
+{
+    QSqlQuery q = preparedStatement(name, sql);
+    bindAndExec(q, name, params);
+    return q;
+}
+
+QSqlRecord Database::executePreparedRow(const QString &name, const QString &sql,
+                                        const QVariantList &params)
+{
+    QSqlQuery q = preparedStatement(name, sql);
+    QSqlRecord row;
+    if(bindAndExec(q, name, params) && q.next()) {
+        row = q.record();
+    }
+    q.finish();
+    return row;
+}
+
+Database::StatementCacheStats Database::statementCacheStats() const
+{
+    StatementCacheStats stats;
+    stats.hits = m_statementHits.loadAcquire();
+    stats.misses = m_statementMisses.loadAcquire();
+    stats.cachedStatements = m_cachedStatements.loadAcquire();
+    return stats;
+}
+
+// 只清理当前线程连接上的语句
+void Database::clearStatementCache()
+{
+    if(!m_threadConnections.hasLocalData()) return;
+    ThreadConnection *conn = m_threadConnections.localData();
+    if(!conn) return;
+    m_cachedStatements.fetchAndAddRelaxed(-conn->statements.size());
+    conn->statements.clear();
+}
+
 QString Database::escapeString( QString input)
 {
     return input.replace("'", "''");
@@ -154,8 +335,7 @@ QString Database::escapeString( QString input)
 
 Database* Database::instance()
 {
-    if(!m_instance) {
-        m_instance = new Database();
-    }
-    return m_instance;
+    // C++11 起函数内静态变量的初始化是线程安全的，不再需要加锁
+    static Database *instance = new Database();
+    return instance;
 }
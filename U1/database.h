@@ -5,8 +5,16 @@
 #include <QObject>
 #include <QSqlDatabase>
 #include <QSqlQuery>
+#include <QSqlRecord>
 #include <QSqlError>
 #include <QDebug>
+#include <QHash>
+#include <QVariantList>
+#include <QThreadStorage>
+#include <QAtomicInteger>
+#include "connectionpool.h"
+
+class StorageBackend;
 
 class Database : public QObject
 {
@@ -20,11 +28,69 @@ public:
     QSqlQuery executeQuery(const QString &query);
     QString escapeString( QString input);
 
+    // 当前线程的连接（首次使用时从连接池取出，线程结束时自动归还）
+    QSqlDatabase connection();
+    void releaseConnection();
+    bool transaction();
+    bool commit();
+    bool rollback();
+    bool inTransaction();
+    ConnectionPool* pool() const;
+    StorageBackend* backend() const;
+
+    // 存储配置文件，须在第一次调用 instance() 之前设置
+    static void setConfigFile(const QString &path);
+    static QString configFile();
+
+    // 预编译语句缓存：按名称复用已 prepare 的 QSqlQuery，参数使用 ? 占位并按顺序绑定。
+    // executePreparedQuery 返回的结果集读到末尾或 finish() 之后语句才回到缓存里复用；
+    // 在此之前再调用同名语句会另 prepare 一条，不会冲掉调用方还在读的结果。
+    // 只读一行的查询用 executePreparedRow：取出第一行后立即 finish()，语句下次直接复用
+    bool executePrepared(const QString &name, const QString &sql,
+                         const QVariantList &params = QVariantList(),
+                         int *rowsAffected = nullptr);
+    QSqlQuery executePreparedQuery(const QString &name, const QString &sql,
+                                   const QVariantList &params = QVariantList());
+    // 没有结果行或执行失败时返回空记录（isEmpty()）
+    QSqlRecord executePreparedRow(const QString &name, const QString &sql,
+                                  const QVariantList &params = QVariantList());
+
+    struct StatementCacheStats {
+        quint64 hits;
+        quint64 misses;
+        int cachedStatements;
+    };
+    StatementCacheStats statementCacheStats() const;
+    void clearStatementCache();
+
     static Database* instance();
 
 private:
-    QSqlDatabase db;
-    static Database* m_instance;
+    struct CachedStatement {
+        QString sql;
+        QSqlQuery query;
+    };
+
+    // 每个线程一份：绑定的池连接以及在该连接上prepare过的语句
+    struct ThreadConnection {
+        Database *owner;
+        QSqlDatabase db;
+        QHash<QString, CachedStatement> statements;
+        bool inTransaction;
+        ~ThreadConnection();
+    };
+
+    ThreadConnection* threadConnection();
+    QSqlQuery preparedStatement(const QString &name, const QString &sql);
+    bool bindAndExec(QSqlQuery &q, const QString &name, const QVariantList &params);
+
+    StorageBackend *m_backend;
+    ConnectionPool *m_pool;
+    QThreadStorage<ThreadConnection*> m_threadConnections;
+    QAtomicInteger<quint64> m_statementHits;
+    QAtomicInteger<quint64> m_statementMisses;
+    QAtomicInt m_cachedStatements;
+    static QString m_configFile;
 };
 
 #endif // DATABASE_H
@@ -0,0 +1,304 @@
+// src/entitycache.cpp
+#include "entitycache.h"
+#include <QElapsedTimer>
+#include <QMutexLocker>
+
+// 缓存容量与存活时间
+static const int BookCacheCapacity = 10000;
+static const int UserCacheCapacity = 5000;
+static const qint64 EntryMaxAgeMs = 60 * 1000;
+
+static qint64 nowMs()
+{
+    static QElapsedTimer clock = []() {
+        QElapsedTimer timer;
+        timer.start();
+        return timer;
+    }();
+    return clock.elapsed();
+}
+
+// ---- Stats ----
+
+TinyLfuCache::Stats::Stats()
+    : hits(0), misses(0), evictions(0), size(0), capacity(0)
+{
+}
+
+double TinyLfuCache::Stats::hitRate() const
+{
+    quint64 total = hits + misses;
+    return total > 0 ? static_cast<double>(hits) / total : 0.0;
+}
+
+// ---- FrequencySketch ----
+
+TinyLfuCache::FrequencySketch::FrequencySketch(int capacity)
+    : m_width(16), m_additions(0)
+{
+    while(m_width < capacity) m_width <<= 1;
+    m_table.fill(0, m_width * 4);
+    m_sampleSize = qMax(10 * capacity, 160);
+}
+
+int TinyLfuCache::FrequencySketch::indexOf(uint hash, int row) const
+{
+    static const uint Seeds[4] = { 0x97CB3127u, 0xB7A2F6A5u, 0x5A3CC2B7u, 0xE1F2A3D9u };
+    uint h = (hash + Seeds[row]) * 0x9E3779B1u;
+    h ^= h >> 16;
+    return row * m_width + int(h & uint(m_width - 1));
+}
+
+void TinyLfuCache::FrequencySketch::increment(const QString &key)
+{
+    uint hash = qHash(key);
+    for(int row = 0; row < 4; ++row) {
+        quint8 &counter = m_table[indexOf(hash, row)];
+        if(counter < 15) ++counter;
+    }
+    if(++m_additions >= m_sampleSize) {
+        reset();
+    }
+}
+
+int TinyLfuCache::FrequencySketch::frequency(const QString &key) const
+{
+    uint hash = qHash(key);
+    int result = 15;
+    for(int row = 0; row < 4; ++row) {
+        result = qMin(result, int(m_table.at(indexOf(hash, row))));
+    }
+    return result;
+}
+
+// 老化：计数减半，让过去的热点逐渐让位
+void TinyLfuCache::FrequencySketch::reset()
+{
+    for(int i = 0; i < m_table.size(); ++i) {
+        m_table[i] >>= 1;
+    }
+    m_additions /= 2;
+}
+
+void TinyLfuCache::FrequencySketch::clear()
+{
+    m_table.fill(0);
+    m_additions = 0;
+}
+
+// ---- TinyLfuCache ----
+
+TinyLfuCache::TinyLfuCache(int capacity, qint64 maxAgeMs)
+    : m_sketch(capacity), m_capacity(qMax(capacity, 2)), m_maxAgeMs(maxAgeMs),
+      m_generation(0), m_hits(0), m_misses(0), m_evictions(0)
+{
+    m_windowCapacity = qMax(1, m_capacity / 100);
+    m_protectedCapacity = (m_capacity - m_windowCapacity) * 80 / 100;
+}
+
+TinyLfuCache::~TinyLfuCache()
+{
+    qDeleteAll(m_nodes);
+}
+
+TinyLfuCache::List &TinyLfuCache::listFor(Segment segment)
+{
+    switch(segment) {
+    case Window:
+        return m_window;
+    case Probation:
+        return m_probation;
+    default:
+        return m_protected;
+    }
+}
+
+void TinyLfuCache::unlink(Node *node)
+{
+    List &list = listFor(node->segment);
+    if(node->prev) node->prev->next = node->next;
+    else list.head = node->next;
+    if(node->next) node->next->prev = node->prev;
+    else list.tail = node->prev;
+    node->prev = node->next = nullptr;
+    --list.size;
+}
+
+void TinyLfuCache::pushFront(Node *node, Segment segment)
+{
+    List &list = listFor(segment);
+    node->segment = segment;
+    node->prev = nullptr;
+    node->next = list.head;
+    if(list.head) list.head->prev = node;
+    else list.tail = node;
+    list.head = node;
+    ++list.size;
+}
+
+void TinyLfuCache::erase(Node *node)
+{
+    unlink(node);
+    m_nodes.remove(node->key);
+    delete node;
+}
+
+// 命中：试用段的条目晋升到保护段，保护段满了把最久未用的降回试用段
+void TinyLfuCache::onHit(Node *node)
+{
+    Segment segment = node->segment;
+    unlink(node);
+    if(segment == Probation) {
+        pushFront(node, Protected);
+        if(m_protected.size > m_protectedCapacity) {
+            Node *demoted = m_protected.tail;
+            unlink(demoted);
+            pushFront(demoted, Probation);
+        }
+    } else {
+        pushFront(node, segment);
+    }
+}
+
+// 窗口溢出：主区未满直接进试用段，否则与试用段末尾比较频率决定去留
+void TinyLfuCache::evictFromWindow()
+{
+    Node *candidate = m_window.tail;
+    unlink(candidate);
+
+    if(m_probation.size + m_protected.size < m_capacity - m_windowCapacity) {
+        pushFront(candidate, Probation);
+        return;
+    }
+
+    Node *victim = m_probation.tail ? m_probation.tail : m_protected.tail;
+    ++m_evictions;
+    if(victim && m_sketch.frequency(candidate->key) > m_sketch.frequency(victim->key)) {
+        erase(victim);
+        pushFront(candidate, Probation);
+    } else {
+        m_nodes.remove(candidate->key);
+        delete candidate;
+    }
+}
+
+bool TinyLfuCache::get(const QString &key, QSqlRecord *value, quint64 *generation)
+{
+    QMutexLocker lock(&m_mutex);
+    m_sketch.increment(key);
+
+    Node *node = m_nodes.value(key, nullptr);
+    if(node && m_maxAgeMs > 0 && nowMs() - node->loadedAt > m_maxAgeMs) {
+        erase(node);
+        node = nullptr;
+    }
+    if(!node) {
+        ++m_misses;
+        if(generation) *generation = m_generation;
+        return false;
+    }
+
+    ++m_hits;
+    onHit(node);
+    if(value) *value = node->value;
+    return true;
+}
+
+void TinyLfuCache::put(const QString &key, const QSqlRecord &value, quint64 generation)
+{
+    QMutexLocker lock(&m_mutex);
+    if(generation != m_generation) return; // 读取期间有过失效
+
+    Node *node = m_nodes.value(key, nullptr);
+    if(node) {
+        node->value = value;
+        node->loadedAt = nowMs();
+        return;
+    }
+
+    node = new Node;
+    node->key = key;
+    node->value = value;
+    node->loadedAt = nowMs();
+    node->prev = node->next = nullptr;
+    pushFront(node, Window);
+    m_nodes.insert(key, node);
+
+    if(m_window.size > m_windowCapacity) {
+        evictFromWindow();
+    }
+}
+
+void TinyLfuCache::remove(const QString &key)
+{
+    QMutexLocker lock(&m_mutex);
+    ++m_generation;
+    Node *node = m_nodes.value(key, nullptr);
+    if(node) erase(node);
+}
+
+void TinyLfuCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    ++m_generation;
+    qDeleteAll(m_nodes);
+    m_nodes.clear();
+    m_window = List();
+    m_probation = List();
+    m_protected = List();
+}
+
+TinyLfuCache::Stats TinyLfuCache::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    Stats stats;
+    stats.hits = m_hits;
+    stats.misses = m_misses;
+    stats.evictions = m_evictions;
+    stats.size = m_nodes.size();
+    stats.capacity = m_capacity;
+    return stats;
+}
+
+// ---- EntityCache ----
+
+EntityCache::EntityCache()
+    : m_books(BookCacheCapacity, EntryMaxAgeMs), m_users(UserCacheCapacity, EntryMaxAgeMs)
+{
+}
+
+EntityCache* EntityCache::instance()
+{
+    static EntityCache *instance = new EntityCache();
+    return instance;
+}
+
+TinyLfuCache *EntityCache::books()
+{
+    return &m_books;
+}
+
+TinyLfuCache *EntityCache::users()
+{
+    return &m_users;
+}
+
+void EntityCache::invalidateBook(const QString &isbn)
+{
+    m_books.remove(isbn);
+}
+
+void EntityCache::invalidateUser(const QString &userId)
+{
+    m_users.remove(userId);
+}
+
+void EntityCache::invalidateAllBooks()
+{
+    m_books.clear();
+}
+
+void EntityCache::invalidateAllUsers()
+{
+    m_users.clear();
+}
@@ -0,0 +1,122 @@
+// include/entitycache.h
+#ifndef ENTITYCACHE_H
+#define ENTITYCACHE_H
+
+#include <QString>
+#include <QHash>
+#include <QVector>
+#include <QMutex>
+#include <QSqlRecord>
+
+// 有界缓存，W-TinyLFU 准入策略
+// 新条目先进入 1% 的窗口 LRU；被挤出窗口时，与主区（分段 LRU：试用段 + 保护段）的淘汰候选
+// 比较 Count-Min Sketch 估计的访问频率，频率更高者留下。偶发的扫描式访问因此冲不掉热门条目。
+class TinyLfuCache
+{
+public:
+    struct Stats {
+        quint64 hits;
+        quint64 misses;
+        quint64 evictions;
+        int size;
+        int capacity;
+        Stats();
+        double hitRate() const;
+    };
+
+    TinyLfuCache(int capacity, qint64 maxAgeMs);
+    ~TinyLfuCache();
+
+    // 未命中时 generation 返回当前失效代数，put 时带回；期间有过失效则丢弃这次写入，
+    // 避免把失效之前读到的旧行放回缓存
+    bool get(const QString &key, QSqlRecord *value, quint64 *generation);
+    void put(const QString &key, const QSqlRecord &value, quint64 generation);
+    void remove(const QString &key);
+    void clear();
+    Stats stats() const;
+
+private:
+    enum Segment { Window, Probation, Protected };
+
+    struct Node {
+        QString key;
+        QSqlRecord value;
+        qint64 loadedAt;
+        Segment segment;
+        Node *prev;
+        Node *next;
+    };
+
+    struct List {
+        Node *head; // 最近使用
+        Node *tail; // 最久未用
+        int size;
+        List() : head(nullptr), tail(nullptr), size(0) {}
+    };
+
+    // 4 行 Count-Min Sketch，每格 4 位计数（存成一字节），累计 10 倍容量次访问后全部减半
+    class FrequencySketch
+    {
+    public:
+        explicit FrequencySketch(int capacity);
+        void increment(const QString &key);
+        int frequency(const QString &key) const;
+        void clear();
+
+    private:
+        int indexOf(uint hash, int row) const;
+        void reset();
+
+        QVector<quint8> m_table;
+        int m_width;
+        int m_additions;
+        int m_sampleSize;
+    };
+
+    List &listFor(Segment segment);
+    void unlink(Node *node);
+    void pushFront(Node *node, Segment segment);
+    void onHit(Node *node);
+    void evictFromWindow();
+    void erase(Node *node);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Node*> m_nodes;
+    List m_window;
+    List m_probation;
+    List m_protected;
+    FrequencySketch m_sketch;
+    int m_capacity;
+    int m_windowCapacity;
+    int m_protectedCapacity;
+    qint64 m_maxAgeMs;
+    quint64 m_generation;
+    quint64 m_hits;
+    quint64 m_misses;
+    quint64 m_evictions;
+};
+
+// Users/Books 按主键缓存的查询行
+// 缓存的是数据库行而不是对象，取出后照旧构造 User/Book，调用方的所有权不变。
+// 所有改动这两张表的写操作都要调用 invalidate*；条目另有存活时间，兼顾其他客户端的修改。
+class EntityCache
+{
+public:
+    static EntityCache* instance();
+
+    TinyLfuCache *books();
+    TinyLfuCache *users();
+
+    void invalidateBook(const QString &isbn);
+    void invalidateUser(const QString &userId);
+    void invalidateAllBooks();
+    void invalidateAllUsers();
+
+private:
+    EntityCache();
+
+    TinyLfuCache m_books;
+    TinyLfuCache m_users;
+};
+
+#endif // ENTITYCACHE_H
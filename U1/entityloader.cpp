@@ -0,0 +1,63 @@
+// src/entityloader.cpp
+#include "entityloader.h"
+#include "database.h"
+#include <QSqlQuery>
+#include <QVariantList>
+
+// 每条 IN 查询的最大键数；更小的批次向上取到 2 的幂，占位符个数固定，预编译语句才能复用
+static const int MaxBatchSize = 256;
+
+static const char *BooksSelect =
+    "SELECT b.*, s.RatingCount, s.RatingSum, s.Rating1, s.Rating2, s.Rating3, s.Rating4, s.Rating5 "
+    "FROM Books b LEFT JOIN BookRatingStats s ON s.ISBN = b.ISBN WHERE b.ISBN IN (%1)";
+static const char *UsersSelect = "SELECT * FROM Users WHERE UserID IN (%1)";
+
+QHash<QString, QSqlRecord> EntityLoader::fetchBooks(const QStringList &isbns)
+{
+    return fetch("Books", BooksSelect, "ISBN", isbns);
+}
+
+QHash<QString, QSqlRecord> EntityLoader::fetchUsers(const QStringList &userIds)
+{
+    return fetch("Users", UsersSelect, "UserID", userIds);
+}
+
+QHash<QString, QSqlRecord> EntityLoader::fetch(const QString &name, const QString &selectSql,
+                                               const QString &keyColumn, const QStringList &keys)
+{
+    QHash<QString, QSqlRecord> rows;
+
+    // 去重，保持首次出现的顺序
+    QStringList unique;
+    QSet<QString> seen;
+    foreach (const QString &key, keys) {
+        if(key.isEmpty() || seen.contains(key)) continue;
+        seen.insert(key);
+        unique.append(key);
+    }
+
+    for(int offset = 0; offset < unique.size(); offset += MaxBatchSize) {
+        QStringList chunk = unique.mid(offset, MaxBatchSize);
+
+        int bucket = 1;
+        while(bucket < chunk.size()) bucket *= 2;
+
+        QStringList placeholders;
+        QVariantList params;
+        for(int i = 0; i < bucket; ++i) {
+            placeholders << "?";
+            // 不足的位置重复最后一个键，结果不变
+            params << chunk.at(qMin(i, chunk.size() - 1));
+        }
+
+        QSqlQuery q = Database::instance()->executePreparedQuery(
+            QString("loader.%1.in%2").arg(name).arg(bucket),
+            selectSql.arg(placeholders.join(", ")),
+            params);
+        while(q.next()) {
+            QSqlRecord record = q.record();
+            rows.insert(record.value(keyColumn).toString(), record);
+        }
+    }
+    return rows;
+}
@@ -0,0 +1,31 @@
+// include/entityloader.h
+#ifndef ENTITYLOADER_H
+#define ENTITYLOADER_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QSet>
+#include <QSqlRecord>
+
+// 批量实体加载器
+// 对 Books/Users 的按主键查找合并成 WHERE key IN (...) 查询，图书行带回 BookRatingStats 评分汇总，
+// 同一批里重复的键只查一次。
+// 列表查询（热门图书、在借图书、检索、一起借、分页表格）先收齐键再一次性取行，不再逐行查找。
+// 借还在存储过程里完成，操作中不再按主键取实体，所以不设按事件循环轮次或按操作收集查找的作用域。
+// 仍是单个查找的只有 findBookByIsbn（图书详情，每次点击一本）和 findUserById，
+// 两者先查实体缓存，未命中才各发一条 IN 查询。
+class EntityLoader
+{
+public:
+    // 找不到的键不出现在结果里
+    static QHash<QString, QSqlRecord> fetchBooks(const QStringList &isbns);
+    static QHash<QString, QSqlRecord> fetchUsers(const QStringList &userIds);
+
+private:
+    EntityLoader();
+    static QHash<QString, QSqlRecord> fetch(const QString &name, const QString &selectSql,
+                                            const QString &keyColumn, const QStringList &keys);
+};
+
+#endif // ENTITYLOADER_H
@@ -0,0 +1,22 @@
+// include/futurecontinuation.h
+#ifndef FUTURECONTINUATION_H
+#define FUTURECONTINUATION_H
+
+#include <QObject>
+#include <QFuture>
+#include <QFutureWatcher>
+
+// QFuture 的延续：任务完成后在 context 所在线程（通常是GUI线程）里调用 callback(result)。
+// context 被销毁时 watcher 一并销毁，回调不会再执行。
+template<typename T, typename Callback>
+void whenFinished(const QFuture<T> &future, QObject *context, Callback callback)
+{
+    QFutureWatcher<T> *watcher = new QFutureWatcher<T>(context);
+    QObject::connect(watcher, &QFutureWatcher<T>::finished, context, [watcher, callback]() {
+        callback(watcher->future().result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(future);
+}
+
+#endif // FUTURECONTINUATION_H
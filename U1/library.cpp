@@ -1,16 +1,123 @@
 // src/library.cpp
 #include "library.h"
 #include "database.h"
+#include "storagebackend.h"
+#include "entityloader.h"
+#include "entitycache.h"
+#include "unitofwork.h"
+#include "catalogindex.h"
+#include "completiontrie.h"
+#include "overdueengine.h"
+#include "reservationqueue.h"
+#include "copyinventory.h"
+#include "circulationstore.h"
+#include "coborrowindex.h"
 #include <QSqlQuery>
+#include <QSqlRecord>
+#include <QSqlError>
 #include <QDate>
-#include <QMessageBox>
 #include <QDebug>
 #include <QTimer>
+#include <QtConcurrent>
+
+// 从查询结果行构造对象（列名与 SELECT * 一致）
+static User* userFromRecord(const QSqlRecord &q)
+{
+    return new User(
+        q.value("UserID").toString(),
+        q.value("Email").toString(),
+        q.value("Password").toString(),
+        q.value("Name").toString(),
+        q.value("Type").toString() == "Super" ? User::Super : User::Normal,
+        q.value("TotalReadingHours").toFloat(),
+        q.value("Fines").toDouble(),
+        q.value("CreditScore").toInt(),
+        q.value("HadLowCredit").toBool()
+    );
+}
+
+static Book* bookFromRecord(const QSqlRecord &q)
+{
+    Book *book = new Book(
+        q.value("ISBN").toString(),
+        q.value("Title").toString(),
+        q.value("Author").toString(),
+        q.value("TotalCopies").toInt(),
+        q.value("Publisher").toString(),
+        q.value("PublishDate").toDate(),
+        q.value("Price").toDouble(),
+        q.value("Introduction").toString()
+    );
+
+    // 联查了 BookRatingStats 时顺带带回评分汇总
+    if(q.contains("RatingCount")) {
+        Book::RatingStats stats;
+        stats.count = q.value("RatingCount").toInt();
+        stats.sum = q.value("RatingSum").toInt();
+        for(int i = 0; i < 5; ++i) {
+            stats.histogram[i] = q.value(QString("Rating%1").arg(i + 1)).toInt();
+        }
+        book->setRatingStats(stats);
+    }
+    return book;
+}
+
+// 评分汇总的列，和图书行一起查询
+static const char *RatingStatsColumns =
+    "s.RatingCount, s.RatingSum, s.Rating1, s.Rating2, s.Rating3, s.Rating4, s.Rating5";
+
+// 重建一个分片（按 ISBN 哈希取模）的评分汇总
+static bool rebuildRatingStatsPartition(int partitions, int index)
+{
+    Database *db = Database::instance();
+    QString bucket = db->backend()->hashBucket("ISBN");
+    if(!db->transaction()) return false;
+
+    bool ok = db->executePrepared("ratingStats.rebuildDelete",
+        QString("DELETE FROM BookRatingStats WHERE %1 = ?").arg(bucket),
+        {partitions, index});
+    ok = ok && db->executePrepared("ratingStats.rebuildInsert",
+        "INSERT INTO BookRatingStats (ISBN, RatingCount, RatingSum, Rating1, Rating2, Rating3, Rating4, Rating5) "
+        "SELECT ISBN, COUNT(Rating), COALESCE(SUM(Rating), 0), "
+        "COALESCE(SUM(Rating = 1), 0), COALESCE(SUM(Rating = 2), 0), COALESCE(SUM(Rating = 3), 0), "
+        "COALESCE(SUM(Rating = 4), 0), COALESCE(SUM(Rating = 5), 0) "
+        "FROM Comments WHERE " + bucket + " = ? GROUP BY ISBN",
+        {partitions, index});
+
+    if(!ok) {
+        db->rollback();
+        return false;
+    }
+    return db->commit();
+}
+
+// 按给定顺序批量取图书，一次 IN 查询代替逐本查找
+static BookRecordList booksForIsbns(const QStringList &isbns)
+{
+    QHash<QString, QSqlRecord> rows = EntityLoader::fetchBooks(isbns);
+
+    BookRecordBuilder builder(isbns.size());
+    foreach (const QString &isbn, isbns) {
+        auto it = rows.constFind(isbn);
+        if(it != rows.constEnd()) builder.append(it.value());
+    }
+    return builder.finish();
+}
 
 Library::Library(QObject *parent) : QObject(parent)
 {
+    // 工作线程数不超过连接池上限，留一个连接给GUI线程
+    m_workers.setMaxThreadCount(qMax(1, Database::instance()->pool()->config().maxSize - 1));
+
     // 启动定时检查逾期图书
     QTimer::singleShot(0, this, &Library::checkOverdueBooks);
+
+    // 合并后的阅读时长每分钟在工作线程写一次库
+    QTimer *writeBehindTimer = new QTimer(this);
+    connect(writeBehindTimer, &QTimer::timeout, this, [this]() {
+        QtConcurrent::run(&m_workers, &UnitOfWork::flushWriteBehind);
+    });
+    writeBehindTimer->start(60 * 1000);
 }
 
 User* Library::registerUser(const QString &email, const QString &password,
@@ -62,118 +169,92 @@ User* Library::authenticateUser(const QString &identifier, const QString &passwo
 
     QSqlQuery q = Database::instance()->executeQuery(query);
     if(q.next()) {
-        return new User(
-            q.value("UserID").toString(),
-            q.value("Email").toString(),
-            q.value("Password").toString(),
-            q.value("Name").toString(),
-            q.value("Type").toString() == "Super" ? User::Super : User::Normal,
-            q.value("TotalReadingHours").toFloat(),
-            q.value("Fines").toDouble(),
-            q.value("CreditScore").toInt(),
-            q.value("HadLowCredit").toBool()
-        );
+        return userFromRecord(q.record());
     }
     return nullptr;
 }
 
 bool Library::borrowBook(const QString &userId, const QString &isbn)
 {
-    // 检查用户和图书是否存在
-    User* user = findUserById(userId);
-    Book* book = findBookByIsbn(isbn);
-    if(!user || !book) return false;
-
-    // 检查用户信用分
-    if(!user->canBorrow()) {
-        QMessageBox::warning(nullptr, "借阅失败",
+    CirculationResult result = executeBorrow(userId, isbn);
+    switch(result.status) {
+    case CirculationOk:
+        emit information("借阅成功", result.copyId.isEmpty()
+            ? QString("借阅成功！请于 %1 前归还").arg(result.dueDate.toString("yyyy年MM月dd日"))
+            : QString("借阅成功！副本编号 %1，请于 %2 前归还")
+                  .arg(result.copyId, result.dueDate.toString("yyyy年MM月dd日")));
+        return true;
+    case CreditTooLow:
+        emit warning("借阅失败",
             "您的信用分低于90分，暂时无法借书\n"
             "请通过缴费提升信用分");
         return false;
-    }
-
-    // 检查用户当前借阅数量
-    int currentBorrowCount = getCurrentBorrowCount(userId);
-    if(currentBorrowCount >= user->maxBorrowCount()) {
-        QMessageBox::warning(nullptr, "借阅失败",
-            QString("您已达到最大借阅数量 (%1 本)").arg(user->maxBorrowCount()));
+    case BorrowLimitReached:
+        emit warning("借阅失败",
+            QString("您已达到最大借阅数量 (%1 本)").arg(result.borrowLimit));
         return false;
-    }
-
-    // 检查是否有可借副本
-    if(book->availableCopies() <= 0) {
-        QMessageBox::warning(nullptr, "借阅失败", "该图书已无可用副本");
+    case NoCopiesAvailable:
+        emit warning("借阅失败", "该图书已无可用副本");
+        return false;
+    default:
         return false;
     }
-
-    // 借阅图书
-    if(!book->borrow()) return false;
-
-    // 创建借阅记录
-    QDate borrowDate = QDate::currentDate();
-    QDate dueDate = borrowDate.addDays(user->borrowDays()); // 根据用户类型设置借阅期限
-
-    QString query = QString(
-        "INSERT INTO BorrowRecords (UserID, ISBN, BorrowDate, DueDate) "
-        "VALUES ('%1', '%2', '%3', '%4')"
-    ).arg(userId, isbn, borrowDate.toString("yyyy-MM-dd"), dueDate.toString("yyyy-MM-dd"));
-
-    if(Database::instance()->execute(query)) {
-        QMessageBox::information(nullptr, "借阅成功",
-            QString("借阅成功！请于 %1 前归还").arg(dueDate.toString("yyyy年MM月dd日")));
-        return true;
-    }
-    return false;
 }
 
 bool Library::returnBook(const QString &userId, const QString &isbn)
 {
-    // 获取借阅记录
-    BorrowRecord record = getBorrowRecord(userId, isbn);
-    if(record.recordId == -1) {
+    CirculationResult result = executeReturn(userId, isbn);
+    if(result.status != CirculationOk) {
         return false;
     }
 
-    // 更新归还日期
-    QDate returnDate = QDate::currentDate();
-    QString query = QString(
-        "UPDATE BorrowRecords SET ReturnDate = '%1' "
-        "WHERE RecordID = %2"
-    ).arg(returnDate.toString("yyyy-MM-dd")).arg(record.recordId);
-
-    if(!Database::instance()->execute(query)) {
-        return false;
+    if(result.creditDeduction > 0) {
+        emit warning("信用分扣除",
+            QString("逾期归还，信用分扣除 %1 分\n当前信用分: %2")
+            .arg(result.creditDeduction).arg(result.creditScore));
     }
+    return true;
+}
 
-    // 增加图书可用副本
-    Book* book = findBookByIsbn(isbn);
-    if(book) {
-        book->returnBook();
+// 借阅：存储后端在一个事务里锁定读者、检查信用分和借阅上限、
+// 条件扣减可借数（AvailableCopies > 0）并写借阅记录，两个终端不可能同时借走最后一本。
+// 借出哪一册由副本位图先选，后端确认仍可借后写进借阅记录
+Library::CirculationResult Library::executeBorrow(const QString &userId, const QString &isbn)
+{
+    CopyInventory *inventory = CopyInventory::instance();
+    CirculationResult result = Database::instance()->backend()->borrow(
+        userId, isbn, QDate::currentDate(), inventory->pickAvailable(isbn));
+
+    if(result.status == CirculationOk) {
+        inventory->markBorrowed(isbn, result.copyId);
+        EntityCache::instance()->invalidateBook(isbn);
+        ReservationQueue::instance()->fulfilled(userId, isbn);
+        CirculationStore::instance()->appendBorrow(userId, isbn, QDate::currentDate(), result.dueDate);
+        CoBorrowIndex::instance()->recordBorrow(userId, isbn);
     }
+    return result;
+}
 
-    // 计算逾期罚款和信用分扣除
-    if(returnDate > record.dueDate) {
-        int daysOverdue = record.dueDate.daysTo(returnDate);
-        double fine = daysOverdue * 0.5; // 每天0.5元罚款
-
-        // 更新罚款
-        query = QString(
-            "UPDATE BorrowRecords SET Fine = %1 "
-            "WHERE RecordID = %2"
-        ).arg(fine).arg(record.recordId);
-        Database::instance()->execute(query);
-
-        // 更新用户罚款总额
-        User* user = findUserById(userId);
-        if(user) {
-            user->addFine(fine);
+// 归还：存储后端在一个事务里结清借阅记录、归还副本，逾期时同时记罚款和扣信用分；
+// 有人预约时副本直接保留给队首
+Library::CirculationResult Library::executeReturn(const QString &userId, const QString &isbn)
+{
+    CirculationResult result =
+        Database::instance()->backend()->giveBack(userId, isbn, QDate::currentDate());
+
+    if(result.status == CirculationOk) {
+        CopyInventory::instance()->markAvailable(isbn, result.copyId);
+        CirculationStore::instance()->appendReturn(userId, isbn, QDate::currentDate(),
+                                                   qint32(qRound64(result.fine * 100)));
+        EntityCache::instance()->invalidateBook(isbn);
+        if(result.fine > 0) {
+            EntityCache::instance()->invalidateUser(userId);
+        }
+        if(result.heldReservation > 0) {
+            ReservationQueue::instance()->applyPromotions({{result.heldReservation, result.pickupDeadline}});
         }
-
-        // 计算信用分扣除
-        calculateCreditDeduction(userId, record.dueDate);
     }
-
-    return true;
+    return result;
 }
 
 void Library::calculateCreditDeduction(const QString &userId, const QDate &dueDate)
@@ -190,17 +271,16 @@ void Library::calculateCreditDeduction(const QString &userId, const QDate &dueDa
 
     if(deduction > 0) {
         // 更新借阅记录的信用分扣除
-        QString query = QString(
-            "UPDATE BorrowRecords SET CreditDeduction = %1 "
-            "WHERE UserID = '%2' AND DueDate = '%3' AND ReturnDate IS NOT NULL"
-        ).arg(deduction).arg(userId).arg(dueDate.toString("yyyy-MM-dd"));
-        Database::instance()->execute(query);
+        Database::instance()->executePrepared("return.setCreditDeduction",
+            "UPDATE BorrowRecords SET CreditDeduction = ? "
+            "WHERE UserID = ? AND DueDate = ? AND ReturnDate IS NOT NULL",
+            {deduction, userId, dueDate});
 
         // 更新用户信用分
         User* user = findUserById(userId);
         if(user) {
             user->deductCreditScore(deduction);
-            QMessageBox::warning(nullptr, "信用分扣除",
+            emit warning("信用分扣除",
                 QString("逾期归还，信用分扣除 %1 分\n当前信用分: %2")
                 .arg(deduction).arg(user->creditScore()));
         }
@@ -209,45 +289,24 @@ void Library::calculateCreditDeduction(const QString &userId, const QDate &dueDa
 
 void Library::checkOverdueBooks()
 {
-    // 每天检查一次逾期图书
-    QTimer::singleShot(24 * 3600 * 1000, this, &Library::checkOverdueBooks);
-
-    QString query = QString(
-        "SELECT * FROM BorrowRecords "
-        "WHERE ReturnDate IS NULL AND DueDate < '%1'"
-    ).arg(QDate::currentDate().toString("yyyy-MM-dd"));
-
-    QSqlQuery q = Database::instance()->executeQuery(query);
-    while(q.next()) {
-        QString userId = q.value("UserID").toString();
-        QDate dueDate = q.value("DueDate").toDate();
-
-        // 计算逾期天数
-        int daysOverdue = dueDate.daysTo(QDate::currentDate());
-
-        // 超过30天未还，额外扣信用分
-        if(daysOverdue > 30) {
-            User* user = findUserById(userId);
-            if(user) {
-                user->deductCreditScore(5);
-                QMessageBox::warning(nullptr, "严重逾期",
-                    QString("图书严重逾期超过30天，信用分扣除5分\n当前信用分: %1")
-                    .arg(user->creditScore()));
-            }
-        }
-    }
+    // 每小时检查一次：当天已处理过时只是一次插入被忽略，跨零点后第一次检查会处理新的一天
+    QTimer::singleShot(3600 * 1000, this, &Library::checkOverdueBooks);
+
+    // 整批 SQL 在工作线程完成，结果汇总写入 OverdueRuns，不再逐条弹窗
+    QtConcurrent::run(&m_workers, &OverdueEngine::run, QDate::currentDate(), false);
+    // 过了取书期限的预约保留转给下一位，排队镜像随之增量更新
+    QtConcurrent::run(&m_workers, []() {
+        ReservationQueue::instance()->expireHolds(QDateTime::currentDateTime());
+    });
 }
 
 int Library::getCurrentBorrowCount(const QString &userId)
 {
-    QString query = QString(
-        "SELECT COUNT(*) FROM BorrowRecords "
-        "WHERE UserID = '%1' AND ReturnDate IS NULL"
-    ).arg(userId);
-
-    QSqlQuery q = Database::instance()->executeQuery(query);
-    if(q.next()) {
-        return q.value(0).toInt();
+    QSqlRecord count = Database::instance()->executePreparedRow("borrow.currentCount",
+        "SELECT COUNT(*) FROM BorrowRecords WHERE UserID = ? AND ReturnDate IS NULL",
+        {userId});
+    if(!count.isEmpty()) {
+        return count.value(0).toInt();
     }
     return 0;
 }
@@ -267,55 +326,52 @@ int Library::getUserCreditScore(const QString &userId)
 // 查找用户
 User* Library::findUserById(const QString &userId)
 {
-    QString query = QString("SELECT * FROM Users WHERE UserID = '%1'").arg(userId);
-    QSqlQuery q = Database::instance()->executeQuery(query);
-    if(q.next()) {
-        return new User(
-            q.value("UserID").toString(),
-            q.value("Email").toString(),
-            q.value("Password").toString(),
-            q.value("Name").toString(),
-            q.value("Type").toString() == "Super" ? User::Super : User::Normal,
-            q.value("TotalReadingHours").toFloat(),
-            q.value("Fines").toDouble(),
-            q.value("CreditScore").toInt(),
-            q.value("HadLowCredit").toBool()
-        );
+    // 先查实体缓存，未命中时按主键查
+    TinyLfuCache *cache = EntityCache::instance()->users();
+    QSqlRecord record;
+    quint64 generation = 0;
+    if(!cache->get(userId, &record, &generation)) {
+        record = EntityLoader::fetchUsers(QStringList() << userId).value(userId);
+        if(record.isEmpty()) {
+            return nullptr;
+        }
+        cache->put(userId, record, generation);
     }
-    return nullptr;
+    return userFromRecord(record);
 }
 
 // 查找图书
 Book* Library::findBookByIsbn(const QString &isbn)
 {
-    QString query = QString("SELECT * FROM Books WHERE ISBN = '%1'").arg(isbn);
-    QSqlQuery q = Database::instance()->executeQuery(query);
-    if(q.next()) {
-        return new Book(
-            q.value("ISBN").toString(),
-            q.value("Title").toString(),
-            q.value("Author").toString(),
-            q.value("TotalCopies").toInt(),
-            q.value("Publisher").toString(),
-            q.value("PublishDate").toDate(),
-            q.value("Price").toDouble(),
-            q.value("Introduction").toString()
-        );
+    TinyLfuCache *cache = EntityCache::instance()->books();
+    QSqlRecord record;
+    quint64 generation = 0;
+    if(!cache->get(isbn, &record, &generation)) {
+        record = EntityLoader::fetchBooks(QStringList() << isbn).value(isbn);
+        if(record.isEmpty()) {
+            return nullptr;
+        }
+        cache->put(isbn, record, generation);
     }
-    return nullptr;
+    return bookFromRecord(record);
 }
 
 // 删除用户
 bool Library::deleteUser(const QString &userId)
 {
     QString query = QString("DELETE FROM Users WHERE UserID = '%1'").arg(userId);
-    return Database::instance()->execute(query);
+    bool ok = Database::instance()->execute(query);
+    EntityCache::instance()->invalidateUser(userId);
+    return ok;
 }
 
 // 添加图书
 bool Library::addBook(const QString &isbn, const QString &title, const QString &author, int totalCopies,
                       const QString &publisher, const QDate &publishDate, double price, const QString &introduction)
 {
+    // 入库、生成副本和分给预约排队在同一个事务里
+    if(!Database::instance()->transaction()) return false;
+
     // 1. 检查Books表是否已存在该ISBN
     QString checkSql = QString("SELECT COUNT(*) FROM Books WHERE ISBN='%1'").arg(isbn);
     QSqlQuery q = Database::instance()->executeQuery(checkSql);
@@ -331,44 +387,118 @@ bool Library::addBook(const QString &isbn, const QString &title, const QString &
                 .arg(publishDate.toString("yyyy-MM-dd"))
                 .arg(price)
                 .arg(introduction);
-        if (!Database::instance()->execute(sql)) return false;
+        if (!Database::instance()->execute(sql)) {
+            Database::instance()->rollback();
+            return false;
+        }
     } else {
         // 已有该书，更新总数和可借数
         QString updateSql = QString("UPDATE Books SET TotalCopies = TotalCopies + %1, AvailableCopies = AvailableCopies + %1 WHERE ISBN = '%2'")
                 .arg(totalCopies).arg(isbn);
-        if (!Database::instance()->execute(updateSql)) return false;
+        if (!Database::instance()->execute(updateSql)) {
+            Database::instance()->rollback();
+            return false;
+        }
+        EntityCache::instance()->invalidateBook(isbn);
     }
 
     // 2. 为每个副本生成唯一编号并插入BookCopies表
-    // 查询当前已有多少副本
-    QString countSql = QString("SELECT COUNT(*) FROM BookCopies WHERE ISBN='%1'").arg(isbn);
-    QSqlQuery countQ = Database::instance()->executeQuery(countSql);
+    // 从已有编号的最大值往后编；按数量编号时，中间的副本被删过就会和现有编号重复
+    QString maxSql = QString("SELECT MAX(SUBSTR(CopyID, LENGTH(ISBN) + 2) + 0) FROM BookCopies WHERE ISBN='%1'").arg(isbn);
+    QSqlQuery maxQ = Database::instance()->executeQuery(maxSql);
+    if (!maxQ.isActive()) {
+        Database::instance()->rollback();
+        return false;
+    }
     int start = 0;
-    if (countQ.next()) start = countQ.value(0).toInt();
+    if (maxQ.next()) start = maxQ.value(0).toInt();
 
     for (int i = 1; i <= totalCopies; ++i) {
         QString copyNum = QString("%1").arg(start + i, 3, 10, QChar('0')); // 001, 002, ...
         QString copyID = QString("%1-%2").arg(isbn).arg(copyNum);
         QString insertCopy = QString("INSERT INTO BookCopies (CopyID, ISBN, Status) VALUES ('%1', '%2', 'Available')")
                 .arg(copyID, isbn);
-        Database::instance()->execute(insertCopy);
+        if (!Database::instance()->execute(insertCopy)) {
+            Database::instance()->rollback();
+            return false;
+        }
     }
 
+    // 3. 新副本先分给排队的读者
+    QList<ReservationQueue::Promotion> promoted;
+    if(!ReservationQueue::promoteWaiting(isbn, &promoted) || !Database::instance()->commit()) {
+        Database::instance()->rollback();
+        return false;
+    }
+    ReservationQueue::instance()->applyPromotions(promoted);
+    CopyInventory::instance()->invalidate(isbn);
+
+    // 提交成功后才进检索索引，回滚的新书不会被搜到
+    if(!exists) {
+        CatalogIndex::Document doc;
+        doc.isbn = isbn;
+        doc.title = title;
+        doc.author = author;
+        doc.publisher = publisher;
+        doc.introduction = introduction;
+        CatalogIndex::instance()->addOrUpdate(doc);
+
+        // 新书没有借阅记录，热度为0；增量表攒够一批后在后台并入前缀树
+        CompletionTrie *trie = CompletionTrie::instance();
+        trie->add({isbn, 0});
+        trie->add({title, 0});
+        trie->add({author, 0});
+    }
     return true;
 }
 
 // 移除图书
 bool Library::removeBook(const QString &isbn)
 {
+    // 排队和已保留的预约与删书在同一个事务里取消，删除失败时一并回滚
+    Database *db = Database::instance();
+    if(!db->transaction()) return false;
+
     QString check = QString("SELECT COUNT(*) FROM BorrowRecords WHERE ISBN='%1' AND ReturnDate IS NULL").arg(isbn);
-    QSqlQuery q = Database::instance()->executeQuery(check);
+    QSqlQuery q = db->executeQuery(check);
     if(q.next()) {
         int cnt = q.value(0).toInt();
         qDebug() << "未归还数量:" << cnt;
-        if(cnt > 0) return false;
+        if(cnt > 0) {
+            db->rollback();
+            return false;
+        }
+    }
+    // 书名和作者留给输入联想扣减
+    QString title, author;
+    QSqlRecord book = db->executePreparedRow("book.titleAuthor",
+        "SELECT Title, Author FROM Books WHERE ISBN = ?", {isbn});
+    bool found = !book.isEmpty();
+    if(found) {
+        title = book.value(0).toString();
+        author = book.value(1).toString();
     }
+
     QString del = QString("DELETE FROM Books WHERE ISBN='%1'").arg(isbn);
-    return Database::instance()->execute(del);
+    if(!db->executePrepared("book.cancelReservations",
+            "UPDATE Reservations SET Status = 'Cancelled' WHERE ISBN = ? AND Status IN ('Pending', 'Ready')",
+            {isbn})
+            || !db->execute(del) || !db->commit()) {
+        db->rollback();
+        return false;
+    }
+
+    ReservationQueue::instance()->removeTitle(isbn);
+    EntityCache::instance()->invalidateBook(isbn);
+    CopyInventory::instance()->invalidate(isbn);
+    CatalogIndex::instance()->remove(isbn);
+    if(found) {
+        CompletionTrie *trie = CompletionTrie::instance();
+        trie->remove(isbn);
+        trie->remove(title);
+        trie->remove(author);
+    }
+    return true;
 }
 
 // 续借图书
@@ -385,94 +515,142 @@ bool Library::renewBook(const QString &userId, const QString &isbn)
     return Database::instance()->execute(query);
 }
 
-// 预约图书
+// 预约图书：进入该书的排队，有可借副本时立即保留给他
 bool Library::reserveBook(const QString &userId, const QString &isbn)
 {
-    QString query = QString(
-        "INSERT INTO Reservations (UserID, ISBN, ReserveDate) VALUES ('%1', '%2', '%3')"
-    ).arg(userId, isbn, QDate::currentDate().toString("yyyy-MM-dd"));
-    return Database::instance()->execute(query);
+    return ReservationQueue::instance()->reserve(userId, isbn) > 0;
 }
 
-// 取消预约
+// 取消预约：已保留的副本转给下一位
 bool Library::cancelReservation(const QString &userId, const QString &isbn)
 {
-    QString query = QString(
-        "DELETE FROM Reservations WHERE UserID = '%1' AND ISBN = '%2'"
-    ).arg(userId, isbn);
-    return Database::instance()->execute(query);
+    return ReservationQueue::instance()->cancel(userId, isbn);
 }
 
 // 添加评论
 bool Library::addComment(const QString &userId, const QString &isbn,
                         const QString &comment, int rating)
 {
-    QString query = QString(
-        "INSERT INTO Comments (UserID, ISBN, Comment, Rating, CommentDate) VALUES ('%1', '%2', '%3', %4, '%5')"
-    ).arg(
-        Database::instance()->escapeString(userId),
-        Database::instance()->escapeString(isbn),
-        Database::instance()->escapeString(comment),
-        QString::number(rating),
-        QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")
-    );
-    return Database::instance()->execute(query);
+    // 评论和评分汇总统一由 Comment 写入
+    return Comment::addCommentToDatabase(userId, isbn, comment, rating);
 }
 
 // 搜索图书
-QList<Book*> Library::searchBooks(const QString &keyword)
+BookRecordList Library::searchBooks(const QString &keyword)
 {
-    QList<Book*> books;
-    QString query = QString(
-        "SELECT * FROM Books WHERE Title LIKE '%%1%' OR Author LIKE '%%1%' OR ISBN LIKE '%%1%'"
-    ).arg(keyword);
 
-    QSqlQuery q = Database::instance()->executeQuery(query);
+    // 优先走倒排索引，按相关度排序；索引未就绪或无结果时退回 LIKE 扫描
+    CatalogIndex *index = CatalogIndex::instance();
+    if(index->isReady()) {
+        QStringList isbns;
+        foreach (const CatalogIndex::Hit &hit, index->search(keyword)) {
+            isbns << hit.isbn;
+        }
+        if(!isbns.isEmpty()) {
+            return booksForIsbns(isbns);
+        }
+    }
+
+    QString pattern = QString("%%1%").arg(keyword);
+    QSqlQuery q = Database::instance()->executePreparedQuery("books.search",
+        QString("SELECT b.*, %1 FROM Books b LEFT JOIN BookRatingStats s ON s.ISBN = b.ISBN "
+                "WHERE b.Title LIKE ? OR b.Author LIKE ? OR b.ISBN LIKE ?").arg(QLatin1String(RatingStatsColumns)),
+        {pattern, pattern, pattern});
+    BookRecordBuilder builder;
     while(q.next()) {
-        books.append(new Book(
-            q.value("ISBN").toString(),
-            q.value("Title").toString(),
-            q.value("Author").toString(),
-            q.value("TotalCopies").toInt(),
-            q.value("Publisher").toString(),
-            q.value("PublishDate").toDate(),
-            q.value("Price").toDouble(),
-            q.value("Introduction").toString()
-        ));
+        builder.append(q.record());
     }
-    return books;
+    return builder.finish();
 }
 
 // 获取高评分图书
-QList<Book*> Library::getTopRatedBooks(int limit)
+BookRecordList Library::getTopRatedBooks(int limit)
 {
-    QList<Book*> books;
-    QString query = QString(
-        "SELECT ISBN, AVG(Rating) as AvgRating FROM Comments GROUP BY ISBN ORDER BY AvgRating DESC LIMIT %1"
-    ).arg(limit);
-
-    QSqlQuery q = Database::instance()->executeQuery(query);
+    QSqlQuery q = Database::instance()->executePreparedQuery("books.topRated",
+        QString("SELECT b.*, %1 FROM BookRatingStats s JOIN Books b ON b.ISBN = s.ISBN "
+                "WHERE s.RatingCount > 0 ORDER BY s.RatingSum * 1.0 / s.RatingCount DESC LIMIT ?")
+            .arg(QLatin1String(RatingStatsColumns)),
+        {limit});
+    BookRecordBuilder builder(limit);
     while(q.next()) {
-        Book* book = findBookByIsbn(q.value("ISBN").toString());
-        if(book) books.append(book);
+        builder.append(q.record());
     }
-    return books;
+    return builder.finish();
+}
+
+BookRecordList Library::getBorrowedTogether(const QString &isbn, int limit)
+{
+    QStringList isbns;
+    foreach (const CoBorrowIndex::Hit &hit, CoBorrowIndex::instance()->similar(isbn, limit)) {
+        isbns << hit.isbn;
+    }
+    if(isbns.isEmpty()) return BookRecordList();
+    return booksForIsbns(isbns);
 }
 
 // 获取用户借阅的所有图书
-QList<Book*> Library::getBooksBorrowedByUser(const QString &userId)
+BookRecordList Library::getBooksBorrowedByUser(const QString &userId)
 {
-    QList<Book*> books;
     QString query = QString(
         "SELECT ISBN FROM BorrowRecords WHERE UserID = '%1' AND ReturnDate IS NULL"
     ).arg(userId);
 
+    QStringList isbns;
     QSqlQuery q = Database::instance()->executeQuery(query);
     while(q.next()) {
-        Book* book = findBookByIsbn(q.value("ISBN").toString());
-        if(book) books.append(book);
+        isbns << q.value("ISBN").toString();
     }
-    return books;
+    return booksForIsbns(isbns);
+}
+
+Library::UserDashboard::UserDashboard()
+    : valid(false), type(User::Normal), readingHours(0.0f), fines(0.0),
+      creditScore(100), hadLowCredit(false), maxBorrowCount(5)
+{
+}
+
+Library::CirculationResult::CirculationResult()
+    : status(CirculationError), borrowLimit(0), fine(0.0), creditDeduction(0), creditScore(0),
+      heldReservation(0)
+{
+}
+
+// 读者面板：用户行、在借图书（含书名和到期日）、罚款和信用分一次查询
+Library::UserDashboard Library::loadUserDashboard(const QString &userId)
+{
+    UserDashboard dashboard;
+    QSqlQuery q = Database::instance()->executePreparedQuery("users.dashboard",
+        "SELECT u.UserID, u.Name, u.Type, u.TotalReadingHours, u.Fines, u.CreditScore, u.HadLowCredit, "
+        "r.ISBN, b.Title, r.BorrowDate, r.DueDate "
+        "FROM Users u "
+        "LEFT JOIN BorrowRecords r ON r.UserID = u.UserID AND r.ReturnDate IS NULL "
+        "LEFT JOIN Books b ON b.ISBN = r.ISBN "
+        "WHERE u.UserID = ? ORDER BY r.DueDate",
+        {userId});
+
+    while(q.next()) {
+        if(!dashboard.valid) {
+            dashboard.valid = true;
+            dashboard.userId = q.value(0).toString();
+            dashboard.name = q.value(1).toString();
+            dashboard.type = q.value(2).toString() == "Super" ? User::Super : User::Normal;
+            dashboard.readingHours = q.value(3).toFloat();
+            dashboard.fines = q.value(4).toDouble();
+            dashboard.creditScore = q.value(5).toInt();
+            dashboard.hadLowCredit = q.value(6).toBool();
+            dashboard.maxBorrowCount = dashboard.type == User::Super ? 8 : 5;
+        }
+
+        // 没有在借图书时左连接只返回一行，借阅列为 NULL
+        if(q.value(7).isNull()) continue;
+        DashboardLoan loan;
+        loan.isbn = q.value(7).toString();
+        loan.title = q.value(8).toString();
+        loan.borrowDate = q.value(9).toDate();
+        loan.dueDate = q.value(10).toDate();
+        dashboard.loans.append(loan);
+    }
+    return dashboard;
 }
 
 // 获取用户罚款
@@ -495,28 +673,36 @@ bool Library::payFines(const QString &userId, double amount)
     QString query = QString(
         "UPDATE Users SET Fines = Fines - %1 WHERE UserID = '%2'"
     ).arg(amount).arg(userId);
-    return Database::instance()->execute(query);
+    bool ok = Database::instance()->execute(query);
+    EntityCache::instance()->invalidateUser(userId);
+    return ok;
 }
 
 // 获取所有用户
-QList<User*> Library::getAllUsers()
+UserRecordList Library::getAllUsers()
 {
-    QList<User*> users;
-    QSqlQuery q = Database::instance()->executeQuery("SELECT * FROM Users");
+    QSqlQuery q = Database::instance()->executeQuery(
+        "SELECT UserID, Email, Name, Type, TotalReadingHours, Fines, CreditScore, HadLowCredit FROM Users");
+    UserRecordBuilder builder(q.size());
     while(q.next()) {
-        users.append(new User(
-            q.value("UserID").toString(),
-            q.value("Email").toString(),
-            q.value("Password").toString(),
-            q.value("Name").toString(),
-            q.value("Type").toString() == "Super" ? User::Super : User::Normal,
-            q.value("CreditScore").toInt(),
-            q.value("HadLowCredit").toBool(),
-            q.value("TotalReadingHours").toFloat(),
-            q.value("Fines").toDouble()
-        ));
+        builder.append(q.record());
     }
-    return users;
+    return builder.finish();
+}
+
+static Library::BorrowRecord borrowRecordFromQuery(const QSqlQuery &q)
+{
+    Library::BorrowRecord record;
+    record.recordId = q.value("RecordID").toInt();
+    record.userId = q.value("UserID").toString();
+    record.isbn = q.value("ISBN").toString();
+    record.borrowDate = q.value("BorrowDate").toDate();
+    record.dueDate = q.value("DueDate").toDate();
+    record.returnDate = q.value("ReturnDate").toDate();
+    record.fine = q.value("Fine").toDouble();
+    record.creditDeduction = q.value("CreditDeduction").toInt();
+    record.copyId = q.value("CopyID").toString();
+    return record;
 }
 
 // 获取借阅记录
@@ -531,27 +717,177 @@ QList<Library::BorrowRecord> Library::getBorrowRecords(const QString &isbn)
     }
     QSqlQuery q = Database::instance()->executeQuery(query);
     while(q.next()) {
-        BorrowRecord record;
-        record.recordId = q.value("RecordID").toInt();
-        record.userId = q.value("UserID").toString();
-        record.isbn = q.value("ISBN").toString();
-        record.borrowDate = q.value("BorrowDate").toDate();
-        record.dueDate = q.value("DueDate").toDate();
-        record.returnDate = q.value("ReturnDate").toDate();
-        record.fine = q.value("Fine").toDouble();
-        record.creditDeduction = q.value("CreditDeduction").toInt();
-        records.append(record);
+        records.append(borrowRecordFromQuery(q));
     }
     return records;
 }
 
+// 流式读取用只进游标，驱动不为回滚保留已读过的行；每块单独执行，不进预编译语句缓存
+static bool execForwardOnly(QSqlQuery &q, const QString &sql, const QVariantList &params)
+{
+    q.setForwardOnly(true);
+    if(!q.prepare(sql)) {
+        qDebug() << "Prepare error:" << q.lastError().text();
+        return false;
+    }
+    foreach (const QVariant &param, params) {
+        q.addBindValue(param);
+    }
+    if(!q.exec()) {
+        qDebug() << "Stream query error:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+RecordStream<Library::BorrowRecord> Library::streamBorrowRecords(const QString &isbn, int fetchSize)
+{
+    auto loader = [isbn](const QVariant &afterKey, int limit,
+                         QVector<BorrowRecord> *rows, QVariant *nextKey) {
+        QSqlQuery q(Database::instance()->connection());
+        QVariantList params;
+        params << afterKey;
+        if(!isbn.isEmpty()) params << isbn;
+        params << limit;
+        QString sql = QString("SELECT RecordID, UserID, ISBN, CopyID, BorrowDate, DueDate, ReturnDate, Fine, "
+                              "CreditDeduction FROM BorrowRecords WHERE RecordID > ? %1"
+                              "ORDER BY RecordID LIMIT ?")
+                          .arg(isbn.isEmpty() ? "" : "AND ISBN = ? ");
+        if(!execForwardOnly(q, sql, params)) return false;
+        rows->reserve(limit);
+        while(q.next()) {
+            rows->append(borrowRecordFromQuery(q));
+        }
+        if(rows->size() == limit) *nextKey = rows->last().recordId;
+        return true;
+    };
+    return RecordStream<BorrowRecord>(loader, 0, fetchSize);
+}
+
+RecordStream<UserRecord> Library::streamUsers(int fetchSize)
+{
+    auto loader = [](const QVariant &afterKey, int limit, QVector<UserRecord> *rows, QVariant *nextKey) {
+        QSqlQuery q(Database::instance()->connection());
+        if(!execForwardOnly(q,
+                "SELECT UserID, Email, Name, Type, TotalReadingHours, Fines, CreditScore, HadLowCredit "
+                "FROM Users WHERE UserID > ? ORDER BY UserID LIMIT ?",
+                {afterKey, limit})) {
+            return false;
+        }
+        UserRecordBuilder builder(limit);
+        while(q.next()) {
+            builder.append(q.record());
+        }
+        *rows = builder.finish();
+        if(rows->size() == limit) *nextKey = rows->last().id();
+        return true;
+    };
+    return RecordStream<UserRecord>(loader, QString(""), fetchSize);
+}
+
+// 与 searchBooks 相同：索引命中时按相关度分块取书，否则按 ISBN 分块做 LIKE 扫描
+RecordStream<BookRecord> Library::streamSearchBooks(const QString &keyword, int fetchSize)
+{
+    CatalogIndex *index = CatalogIndex::instance();
+    if(index->isReady()) {
+        QStringList isbns;
+        foreach (const CatalogIndex::Hit &hit, index->search(keyword)) {
+            isbns << hit.isbn;
+        }
+        if(!isbns.isEmpty()) {
+            auto loader = [isbns](const QVariant &afterKey, int limit,
+                                  QVector<BookRecord> *rows, QVariant *nextKey) {
+                int offset = afterKey.toInt();
+                *rows = booksForIsbns(isbns.mid(offset, limit));
+                if(offset + limit < isbns.size()) *nextKey = offset + limit;
+                return true;
+            };
+            return RecordStream<BookRecord>(loader, 0, fetchSize);
+        }
+    }
+
+    QString pattern = QString("%%1%").arg(keyword);
+    auto loader = [pattern](const QVariant &afterKey, int limit,
+                            QVector<BookRecord> *rows, QVariant *nextKey) {
+        QSqlQuery q(Database::instance()->connection());
+        if(!execForwardOnly(q,
+                QString("SELECT b.*, %1 FROM Books b LEFT JOIN BookRatingStats s ON s.ISBN = b.ISBN "
+                        "WHERE (b.Title LIKE ? OR b.Author LIKE ? OR b.ISBN LIKE ?) AND b.ISBN > ? "
+                        "ORDER BY b.ISBN LIMIT ?").arg(QLatin1String(RatingStatsColumns)),
+                {pattern, pattern, pattern, afterKey, limit})) {
+            return false;
+        }
+        BookRecordBuilder builder(limit);
+        while(q.next()) {
+            builder.append(q.record());
+        }
+        *rows = builder.finish();
+        if(rows->size() == limit) *nextKey = rows->last().isbn();
+        return true;
+    };
+    return RecordStream<BookRecord>(loader, QString(""), fetchSize);
+}
+
+template<typename T, typename Visitor>
+static int visitStream(const RecordStream<T> &stream, const Visitor &visitor)
+{
+    int visited = 0;
+    for(const T &row : stream) {
+        ++visited;
+        if(!visitor(row)) break;
+    }
+    return stream.failed() ? -1 : visited;
+}
+
+int Library::visitBorrowRecords(const std::function<bool(const BorrowRecord &)> &visitor,
+                                const QString &isbn, int fetchSize)
+{
+    return visitStream(streamBorrowRecords(isbn, fetchSize), visitor);
+}
+
+int Library::visitUsers(const std::function<bool(const UserRecord &)> &visitor, int fetchSize)
+{
+    return visitStream(streamUsers(fetchSize), visitor);
+}
+
+int Library::visitSearchBooks(const QString &keyword,
+                              const std::function<bool(const BookRecord &)> &visitor, int fetchSize)
+{
+    return visitStream(streamSearchBooks(keyword, fetchSize), visitor);
+}
+
+// 全量重建评分汇总：按 ISBN 哈希分片，各分片在工作线程中用各自的连接并行重建
+bool Library::rebuildRatingStats(int partitions)
+{
+    if(partitions <= 0) partitions = m_workers.maxThreadCount();
+
+    QList<QFuture<bool>> futures;
+    for(int i = 0; i < partitions; ++i) {
+        futures.append(QtConcurrent::run(&m_workers, [partitions, i]() {
+            return rebuildRatingStatsPartition(partitions, i);
+        }));
+    }
+
+    bool ok = true;
+    for(int i = 0; i < futures.size(); ++i) {
+        if(!futures[i].result()) {
+            qDebug() << "Rating stats rebuild failed for partition" << i;
+            ok = false;
+        }
+    }
+    EntityCache::instance()->invalidateAllBooks(); // 缓存的图书行带有评分汇总
+    return ok;
+}
+
 // 更新用户信用分
 bool Library::updateCreditScore(const QString &userId, int score)
 {
     QString query = QString(
         "UPDATE Users SET CreditScore = %1 WHERE UserID = '%2'"
     ).arg(score).arg(userId);
-    return Database::instance()->execute(query);
+    bool ok = Database::instance()->execute(query);
+    EntityCache::instance()->invalidateUser(userId);
+    return ok;
 }
 
 
@@ -561,21 +897,112 @@ Library::BorrowRecord Library::getBorrowRecord(const QString &userId, const QStr
 {
     BorrowRecord record;
     record.recordId = -1;
-    QString query = QString(
-        "SELECT * FROM BorrowRecords WHERE UserID = '%1' AND ISBN = '%2' AND ReturnDate IS NULL"
-    ).arg(userId, isbn);
-    QSqlQuery q = Database::instance()->executeQuery(query);
+    QSqlQuery q = Database::instance()->executePreparedQuery("borrow.openRecord",
+        "SELECT * FROM BorrowRecords WHERE UserID = ? AND ISBN = ? AND ReturnDate IS NULL",
+        {userId, isbn});
     if(q.next()) {
-        record.recordId = q.value("RecordID").toInt();
-        record.userId = q.value("UserID").toString();
-        record.isbn = q.value("ISBN").toString();
-        record.borrowDate = q.value("BorrowDate").toDate();
-        record.dueDate = q.value("DueDate").toDate();
-        record.returnDate = q.value("ReturnDate").toDate();
-        record.fine = q.value("Fine").toDouble();
-        record.creditDeduction = q.value("CreditDeduction").toInt();
+        record = borrowRecordFromQuery(q);
     }
+    q.finish(); // 最多一行，读完交还语句缓存
     return record;
 }
 
+Library::~Library()
+{
+    // 等待仍在执行的异步任务，避免其访问已销毁的对象
+    m_workers.waitForDone();
+    UnitOfWork::flushWriteBehind();
+
+    TinyLfuCache::Stats books = EntityCache::instance()->books()->stats();
+    TinyLfuCache::Stats users = EntityCache::instance()->users()->stats();
+    qDebug() << "Entity cache books: hit rate" << books.hitRate() << "size" << books.size
+             << "evictions" << books.evictions;
+    qDebug() << "Entity cache users: hit rate" << users.hitRate() << "size" << users.size
+             << "evictions" << users.evictions;
+    Database::StatementCacheStats statements = Database::instance()->statementCacheStats();
+    qDebug() << "Statement cache: hits" << statements.hits << "misses" << statements.misses
+             << "cached" << statements.cachedStatements;
+}
+
+QThreadPool* Library::workerPool()
+{
+    return &m_workers;
+}
+
+QFuture<BookRecordList> Library::searchBooksAsync(const QString &keyword)
+{
+    return QtConcurrent::run(&m_workers, [this, keyword]() { return searchBooks(keyword); });
+}
+
+QFuture<BookRecordList> Library::getTopRatedBooksAsync(int limit)
+{
+    return QtConcurrent::run(&m_workers, [this, limit]() { return getTopRatedBooks(limit); });
+}
+
+QFuture<BookRecordList> Library::getBooksBorrowedByUserAsync(const QString &userId)
+{
+    return QtConcurrent::run(&m_workers, [this, userId]() { return getBooksBorrowedByUser(userId); });
+}
+
+QFuture<bool> Library::borrowBookAsync(const QString &userId, const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn]() { return borrowBook(userId, isbn); });
+}
+
+QFuture<bool> Library::returnBookAsync(const QString &userId, const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn]() { return returnBook(userId, isbn); });
+}
+
+QFuture<bool> Library::renewBookAsync(const QString &userId, const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn]() { return renewBook(userId, isbn); });
+}
+
+QFuture<bool> Library::reserveBookAsync(const QString &userId, const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn]() { return reserveBook(userId, isbn); });
+}
+
+QFuture<bool> Library::addCommentAsync(const QString &userId, const QString &isbn,
+                                       const QString &comment, int rating)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn, comment, rating]() {
+        return addComment(userId, isbn, comment, rating);
+    });
+}
+
+QFuture<bool> Library::payFinesAsync(const QString &userId, double amount)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, amount]() { return payFines(userId, amount); });
+}
+
+QFuture<bool> Library::removeBookAsync(const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, isbn]() { return removeBook(isbn); });
+}
+
+QFuture<int> Library::getCurrentBorrowCountAsync(const QString &userId)
+{
+    return QtConcurrent::run(&m_workers, [this, userId]() { return getCurrentBorrowCount(userId); });
+}
+
+QFuture<double> Library::getUserFinesAsync(const QString &userId)
+{
+    return QtConcurrent::run(&m_workers, [this, userId]() { return getUserFines(userId); });
+}
 
+QFuture<Library::BorrowRecord> Library::getBorrowRecordAsync(const QString &userId, const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, userId, isbn]() { return getBorrowRecord(userId, isbn); });
+}
+
+QFuture<Book*> Library::findBookByIsbnAsync(const QString &isbn)
+{
+    return QtConcurrent::run(&m_workers, [this, isbn]() { return findBookByIsbn(isbn); });
+}
+
+QFuture<Library::UserDashboard> Library::loadUserDashboardAsync(const QString &userId)
+{
+    return QtConcurrent::run(&m_workers, [this, userId]() { return loadUserDashboard(userId); });
+}
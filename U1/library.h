@@ -4,10 +4,18 @@
 
 #include <QObject>
 #include <QList>
+#include <QHash>
+#include <QStringList>
 #include <QDate>
+#include <QDateTime>
+#include <QFuture>
+#include <QThreadPool>
 #include "user.h"
 #include "book.h"
 #include "comment.h"
+#include "records.h"
+#include "recordstream.h"
+#include <functional>
 
 class Library : public QObject
 {
@@ -17,6 +25,7 @@ public:
         int recordId;
         QString userId;
         QString isbn;
+        QString copyId;     // 借出的副本，副本级流通之前的记录为空
         QDate borrowDate;
         QDate dueDate;
         QDate returnDate;
@@ -24,7 +33,56 @@ public:
         int creditDeduction;
     };
 
+    // 读者面板中的一条在借记录
+    struct DashboardLoan {
+        QString isbn;
+        QString title;
+        QDate borrowDate;
+        QDate dueDate;
+    };
+
+    // 读者面板快照：用户信息、在借图书、罚款和信用分
+    struct UserDashboard {
+        bool valid;
+        QString userId;
+        QString name;
+        User::UserType type;
+        float readingHours;
+        double fines;
+        int creditScore;
+        bool hadLowCredit;
+        int maxBorrowCount;
+        QList<DashboardLoan> loans;
+        UserDashboard();
+    };
+
+    // 借还结果，状态码与存储过程 BorrowBook/ReturnBook 的 p_status 一致
+    enum CirculationStatus {
+        CirculationError = -1,
+        CirculationOk = 0,
+        UserNotFound = 1,
+        CreditTooLow = 2,
+        BorrowLimitReached = 3,
+        NoCopiesAvailable = 4,
+        BookNotFound = 5,
+        NoOpenLoan = 6
+    };
+
+    struct CirculationResult {
+        CirculationStatus status;
+        QDate dueDate;       // 借阅：应还日期
+        int borrowLimit;     // 借阅：该读者的借阅上限
+        double fine;         // 归还：逾期罚款
+        int creditDeduction; // 归还：扣除的信用分
+        int creditScore;     // 归还：扣分后的信用分
+        QString copyId;      // 借出或归还的副本，没有副本记录的旧书为空
+        int heldReservation; // 归还：副本保留给了这条预约，0 表示放回可借
+        QDateTime pickupDeadline;
+        CirculationResult();
+    };
+
     explicit Library(QObject *parent = nullptr);
+    ~Library();
 
     // 用户管理
     User* registerUser(const QString &email, const QString &password,
@@ -43,6 +101,9 @@ public:
     // 借阅管理
     bool borrowBook(const QString &userId, const QString &isbn);
     bool returnBook(const QString &userId, const QString &isbn);
+    // 一次存储过程调用完成检查、扣减和记录，不弹任何提示
+    CirculationResult executeBorrow(const QString &userId, const QString &isbn);
+    CirculationResult executeReturn(const QString &userId, const QString &isbn);
     bool renewBook(const QString &userId, const QString &isbn);
     bool reserveBook(const QString &userId, const QString &isbn);
     bool cancelReservation(const QString &userId, const QString &isbn);
@@ -53,17 +114,37 @@ public:
                    const QString &comment, int rating);
 
     // 查询功能
-    QList<Book*> searchBooks(const QString &keyword);
-    QList<Book*> getTopRatedBooks(int limit = 10);
-    QList<Book*> getBooksBorrowedByUser(const QString &userId);
+    BookRecordList searchBooks(const QString &keyword);
+    BookRecordList getTopRatedBooks(int limit = 10);
+    // 借过这本书的读者也借了（共同借阅推荐），按相似度排序
+    BookRecordList getBorrowedTogether(const QString &isbn, int limit = 5);
+    BookRecordList getBooksBorrowedByUser(const QString &userId);
     double getUserFines(const QString &userId);
     bool payFines(const QString &userId, double amount);
     int getUserCreditScore(const QString &userId);
+    UserDashboard loadUserDashboard(const QString &userId);
 
     // 管理员功能
-    QList<User*> getAllUsers();
+    UserRecordList getAllUsers();
     QList<BorrowRecord> getBorrowRecords(const QString &isbn = "");
     bool updateCreditScore(const QString &userId, int score);
+    bool rebuildRatingStats(int partitions = 0);
+
+    // 流式查询：按主键分块读取，每块 fetchSize 行，只持有当前块，可以边读边处理
+    static const int DefaultFetchSize = 1000;
+    RecordStream<BorrowRecord> streamBorrowRecords(const QString &isbn = "",
+                                                   int fetchSize = DefaultFetchSize);
+    RecordStream<UserRecord> streamUsers(int fetchSize = DefaultFetchSize);
+    RecordStream<BookRecord> streamSearchBooks(const QString &keyword,
+                                               int fetchSize = DefaultFetchSize);
+    // 逐行回调，回调返回 false 时提前结束；返回回调过的行数，查询出错时返回 -1
+    int visitBorrowRecords(const std::function<bool(const BorrowRecord &)> &visitor,
+                           const QString &isbn = "", int fetchSize = DefaultFetchSize);
+    int visitUsers(const std::function<bool(const UserRecord &)> &visitor,
+                   int fetchSize = DefaultFetchSize);
+    int visitSearchBooks(const QString &keyword,
+                         const std::function<bool(const BookRecord &)> &visitor,
+                         int fetchSize = DefaultFetchSize);
 
     // 信用分管理
     void checkOverdueBooks();
@@ -73,10 +154,35 @@ public:
       User* findUserById(const QString &userId);
       Book* findBookByIsbn(const QString &isbn);
 
+    // 异步接口：在工作线程池中执行，不阻塞GUI线程
+    QFuture<BookRecordList> searchBooksAsync(const QString &keyword);
+    QFuture<BookRecordList> getTopRatedBooksAsync(int limit = 10);
+    QFuture<BookRecordList> getBooksBorrowedByUserAsync(const QString &userId);
+    QFuture<bool> borrowBookAsync(const QString &userId, const QString &isbn);
+    QFuture<bool> returnBookAsync(const QString &userId, const QString &isbn);
+    QFuture<bool> renewBookAsync(const QString &userId, const QString &isbn);
+    QFuture<bool> reserveBookAsync(const QString &userId, const QString &isbn);
+    QFuture<bool> addCommentAsync(const QString &userId, const QString &isbn,
+                                  const QString &comment, int rating);
+    QFuture<bool> payFinesAsync(const QString &userId, double amount);
+    QFuture<bool> removeBookAsync(const QString &isbn);
+    QFuture<int> getCurrentBorrowCountAsync(const QString &userId);
+    QFuture<double> getUserFinesAsync(const QString &userId);
+    QFuture<BorrowRecord> getBorrowRecordAsync(const QString &userId, const QString &isbn);
+    QFuture<UserDashboard> loadUserDashboardAsync(const QString &userId);
+    QFuture<Book*> findBookByIsbnAsync(const QString &isbn);
+
+    // 线程数为连接池上限减一，每个线程占一个数据库连接，留一个给GUI线程。
+    // 会访问数据库的后台任务（索引构建、快照加载、分页加载）都放在这里，连接数才不会超出连接池
+    QThreadPool* workerPool();
+
+signals:
+    // 业务提示，可能从工作线程发出，由界面在GUI线程中展示
+    void warning(const QString &title, const QString &message);
+    void information(const QString &title, const QString &message);
 
 private:
-
-
+    QThreadPool m_workers;
 };
 
 #endif // LIBRARY_H
@@ -0,0 +1,15 @@
+# 顶层工程：核心静态库、图形界面程序、命令行压测工具和 QtTest 测试
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    core \
+    app \
+    corebench \
+    tests
+
+core.file = core.pro
+app.file = U1.pro
+app.depends = core
+corebench.file = corebench.pro
+corebench.depends = core
+tests.depends = core
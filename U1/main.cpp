@@ -1,12 +1,76 @@
 #include <QApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
 #include "library.h"
-#include "mainwindow.h"
+#include "mainwindows.h"
 #include "database.h"
+#include "catalogimporter.h"
+#include "catalogindex.h"
+#include "completiontrie.h"
+#include "circulationbenchmark.h"
+#include "circulationstore.h"
+#include "coborrowindex.h"
+#include "copyinventory.h"
+#include "reservationqueue.h"
+#include "startuptimer.h"
+#include "streamingexporter.h"
 
 int main(int argc, char *argv[])
 {
+    StartupTimer::start();
     QApplication a(argc, argv);
 
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption rebuildRatingStats("rebuild-rating-stats",
+        "Rebuild BookRatingStats from Comments and exit.");
+    parser.addOption(rebuildRatingStats);
+    QCommandLineOption circulationBenchmark("circulation-benchmark",
+        "Run the concurrent borrow/return benchmark against test data and exit.");
+    parser.addOption(circulationBenchmark);
+    QCommandLineOption circulationReport("circulation-report",
+        "Load the columnar circulation snapshot, aggregate loans between --from and --to, and exit.");
+    parser.addOption(circulationReport);
+    QCommandLineOption reportFrom("from",
+        "First borrow date of --circulation-report (default: one year before --to).", "yyyy-MM-dd");
+    parser.addOption(reportFrom);
+    QCommandLineOption reportTo("to",
+        "Last borrow date of --circulation-report (default: today).", "yyyy-MM-dd");
+    parser.addOption(reportTo);
+    QCommandLineOption importCatalog("import-catalog",
+        "Bulk import books from a CSV or ISO 2709 MARC file and exit.", "file");
+    parser.addOption(importCatalog);
+    QCommandLineOption rejectReport("reject-report",
+        "Where --import-catalog writes rejected rows (default: <file>.rejects.csv).", "file");
+    parser.addOption(rejectReport);
+    QCommandLineOption exportData("export",
+        "Stream a table (borrows, users or books) to --output and exit.", "dataset");
+    parser.addOption(exportData);
+    QCommandLineOption exportFormat("export-format",
+        "Export format: csv (default) or jsonl.", "format", "csv");
+    parser.addOption(exportFormat);
+    QCommandLineOption output("output",
+        "Export target file (default: standard output).", "file", "-");
+    parser.addOption(output);
+    QCommandLineOption verifyInventory("verify-inventory",
+        "Check Books.AvailableCopies against copy-level status and exit.");
+    parser.addOption(verifyInventory);
+    QCommandLineOption repairInventory("repair-inventory",
+        "Like --verify-inventory, but rewrite mismatched AvailableCopies from copy status.");
+    parser.addOption(repairInventory);
+    QCommandLineOption startupReport("startup-report",
+        "Print per-phase startup timings (connect, schema, first query, first paint).");
+    parser.addOption(startupReport);
+    QCommandLineOption config("config",
+        "Storage config file (default: library.ini next to the executable).", "file");
+    parser.addOption(config);
+    parser.process(a);
+    if(parser.isSet(config)) {
+        Database::setConfigFile(parser.value(config));
+    }
+    StartupTimer::setEnabled(parser.isSet(startupReport));
+    StartupTimer::mark("application");
+
     // 先初始化数据库（在任何窗口创建之前）
     Database* db = Database::instance();
     if(!db->initialize()) {
@@ -14,11 +78,122 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // 维护命令：不启动界面
+    if(parser.isSet(rebuildRatingStats)) {
+        Library library;
+        bool ok = library.rebuildRatingStats();
+        qDebug() << "Rating stats rebuild" << (ok ? "finished" : "failed");
+        return ok ? 0 : 1;
+    }
+    if(parser.isSet(circulationBenchmark)) {
+        Library library;
+        QTextStream out(stdout);
+        CirculationBenchmark benchmark(&library);
+        return benchmark.run(CirculationBenchmark::Options(), out) ? 0 : 1;
+    }
+    if(parser.isSet(circulationReport)) {
+        QTextStream out(stdout);
+        QDate today = QDate::currentDate();
+        QDate to = parser.isSet(reportTo) ? QDate::fromString(parser.value(reportTo), Qt::ISODate) : today;
+        QDate from = parser.isSet(reportFrom) ? QDate::fromString(parser.value(reportFrom), Qt::ISODate)
+                                              : to.addYears(-1).addDays(1);
+        CirculationStore *store = CirculationStore::instance();
+        if(!from.isValid() || !to.isValid() || to < from || !store->load()) {
+            out << "Circulation report failed" << endl;
+            return 1;
+        }
+        CirculationStore::Report report = store->report(from, to, today);
+        foreach (const CirculationStore::MonthRow &row, report.months) {
+            out << "month=" << QString("%1-%2").arg(row.year).arg(row.month, 2, 10, QChar('0'))
+                << " loans=" << row.totals.loans << " overdue=" << row.totals.overdue
+                << " fine_cents=" << row.totals.fineCents << "\n";
+        }
+        foreach (const CirculationStore::AuthorRow &row, report.topAuthors) {
+            out << "author=" << row.author << " loans=" << row.totals.loans
+                << " overdue=" << row.totals.overdue << "\n";
+        }
+        out << "rows=" << report.rows << "\n"
+            << "loans=" << report.loans << "\n"
+            << "open=" << report.openLoans << "\n"
+            << "overdue=" << report.overdueLoans << "\n"
+            << "overdue_rate=" << QString::number(report.overdueRate, 'f', 4) << "\n"
+            << "fine_cents=" << report.fineCents << "\n"
+            << "normal_loans=" << report.normalReaders.loans << "\n"
+            << "super_loans=" << report.superReaders.loans << "\n"
+            << "load_ms=" << store->lastLoadMs() << "\n"
+            << "aggregate_ms=" << report.aggregateMs << endl;
+        return 0;
+    }
+    if(parser.isSet(importCatalog)) {
+        QTextStream out(stdout);
+        CatalogImporter::Options options;
+        options.rejectReportPath = parser.value(rejectReport);
+        CatalogImporter importer(options);
+        importer.setProgressCallback([&out](int done, int total) {
+            out << "progress=" << done << "/" << total << endl;
+        });
+        CatalogImporter::Report report = importer.importFile(parser.value(importCatalog));
+        out << "parsed=" << report.parsed << "\n"
+            << "imported=" << report.imported << "\n"
+            << "merged=" << report.merged << "\n"
+            << "copies=" << report.copies << "\n"
+            << "held=" << report.held << "\n"
+            << "rejected=" << report.rejected << "\n"
+            << "parse_ms=" << report.parseMs << "\n"
+            << "validate_ms=" << report.validateMs << "\n"
+            << "write_ms=" << report.writeMs << "\n"
+            << "total_ms=" << report.totalMs << "\n"
+            << "titles_per_minute=" << qRound(report.titlesPerMinute) << "\n";
+        if(!report.rejectReportPath.isEmpty()) {
+            out << "reject_report=" << report.rejectReportPath << "\n";
+        }
+        return report.ok ? 0 : 1;
+    }
+    if(parser.isSet(verifyInventory) || parser.isSet(repairInventory)) {
+        QTextStream out(stdout);
+        CopyInventory::VerifyReport report = CopyInventory::instance()->verify(parser.isSet(repairInventory));
+        foreach (const QString &sample, report.samples) {
+            out << "mismatch=" << sample << "\n";
+        }
+        out << "titles=" << report.titles << "\n"
+            << "mismatched=" << report.mismatched << "\n"
+            << "repaired=" << report.repaired << endl;
+        return report.ok && report.mismatched == report.repaired ? 0 : 1;
+    }
+    if(parser.isSet(exportData)) {
+        // 数据可能写到标准输出，统计信息写到标准错误
+        QTextStream err(stderr);
+        StreamingExporter::Dataset dataset;
+        StreamingExporter::Options options;
+        if(!StreamingExporter::parseDataset(parser.value(exportData), &dataset)
+                || !StreamingExporter::parseFormat(parser.value(exportFormat), &options.format)) {
+            err << "Unknown export dataset or format" << endl;
+            return 1;
+        }
+        StreamingExporter exporter(options);
+        StreamingExporter::Summary summary = exporter.exportToFile(dataset, parser.value(output));
+        err << "rows=" << summary.rows << "\n"
+            << "bytes=" << summary.bytes << "\n"
+            << "duration_ms=" << summary.durationMs << "\n"
+            << "rows_per_second=" << qRound64(summary.rowsPerSecond) << endl;
+        return summary.ok ? 0 : 1;
+    }
+
     // 创建图书馆系统
     Library library;
 
+    // 在工作线程池上后台构建检索索引，完成前搜索退回数据库扫描
+    CatalogIndex::instance()->rebuildAsync(library.workerPool());
+    CompletionTrie::instance()->rebuildAsync(library.workerPool());
+    CoBorrowIndex::instance()->rebuildAsync(library.workerPool());
+    // 借阅统计的列式快照同样后台加载，加载期间的借还会补进去
+    CirculationStore::instance()->loadAsync(library.workerPool());
+    // 预约排队镜像也在后台加载，期间的预约、取消和分配换入后重放
+    ReservationQueue::instance()->loadAsync(library.workerPool());
+
     // 显示主窗口
     MainWindow w(&library);
+    StartupTimer::watchFirstPaint(&w);
     w.show();
 
     return a.exec();
@@ -6,14 +6,25 @@
 #include "creditdialog.h"
 #include "addbookdialog.h"
 #include "usermanagerdialog.h"
+#include "futurecontinuation.h"
+#include "completiontrie.h"
+#include "booktablemodel.h"
+#include "startuptimer.h"
+#include "reservationqueue.h"
+#include "circulationstore.h"
+#include <QApplication>
 #include <QMessageBox>
 #include <QTableWidgetItem>
+#include <QHeaderView>
 #include <QDateTime>
 #include <QTimer>
+#include <QtConcurrent>
 #include <QDebug>
 
 MainWindow::MainWindow(Library *library, QWidget *parent)
-    : QMainWindow(parent), ui(new Ui::MainWindow), m_library(library), m_currentUser(nullptr)
+    : QMainWindow(parent), ui(new Ui::MainWindow), m_library(library), m_currentUser(nullptr),
+      m_busyIndicator(nullptr), m_busyCount(0), m_bookModel(nullptr),
+      m_completer(nullptr), m_suggestionModel(nullptr), m_suggestTimer(nullptr)
 {
     qDebug() << "MainWindow constructor start";
 
@@ -21,14 +32,6 @@ MainWindow::MainWindow(Library *library, QWidget *parent)
     ui->setupUi(this);  // 确保UI对象树先构建完成
     qDebug() << "UI setup complete";
 
-    // 再初始化数据库
-    qDebug() << "Initializing database...";
-    if (!Database::instance()->initialize()) {
-        QMessageBox::critical(this, "错误", "数据库初始化失败");
-        exit(1);
-    }
-    qDebug() << "Database initialized";
-
     // 设置UI初始状态（延迟到showEvent中执行）
     qDebug() << "Deferring initial UI setup";
 
@@ -47,9 +50,65 @@ MainWindow::MainWindow(Library *library, QWidget *parent)
         connect(ui->btnRemoveBook, &QPushButton::clicked, this, &MainWindow::onRemoveBook);
         connect(ui->btnManageUsers, &QPushButton::clicked, this, &MainWindow::onManageUsers);
         connect(ui->btnViewTopBooks, &QPushButton::clicked, this, &MainWindow::onViewTopBooks);
+        connect(ui->btnCirculationReport, &QPushButton::clicked, this, &MainWindow::onCirculationReport);
+        connect(ui->btnDetails, &QPushButton::clicked, this, &MainWindow::onBookDetails);
+
+    // 图书馆业务提示可能来自工作线程，这里统一在GUI线程弹出
+    connect(m_library, &Library::warning, this, [this](const QString &title, const QString &message) {
+        QMessageBox::warning(this, title, message);
+    });
+    connect(m_library, &Library::information, this, [this](const QString &title, const QString &message) {
+        QMessageBox::information(this, title, message);
+    });
 
     qDebug() << "Signals connected";
 
+    // 忙碌指示器：有异步请求在执行时显示在状态栏
+    m_busyIndicator = new QProgressBar(this);
+    m_busyIndicator->setRange(0, 0);
+    m_busyIndicator->setMaximumWidth(120);
+    m_busyIndicator->setTextVisible(false);
+    m_busyIndicator->hide();
+    ui->statusbar->addPermanentWidget(m_busyIndicator);
+
+    // 图书列表：模型按页加载，排序交给数据库
+    m_bookModel = new BookTableModel(m_library->workerPool(), this);
+    ui->tblBooks->setModel(m_bookModel);
+    ui->tblBooks->horizontalHeader()->setStretchLastSection(true);
+    ui->tblBooks->horizontalHeader()->setSectionsClickable(true);
+    ui->tblBooks->horizontalHeader()->setSortIndicatorShown(true);
+    connect(ui->tblBooks->horizontalHeader(), &QHeaderView::sortIndicatorChanged,
+            m_bookModel, &BookTableModel::sort);
+    connect(m_bookModel, &BookTableModel::sortChanged, this, [this](int column, Qt::SortOrder order) {
+        QSignalBlocker blocker(ui->tblBooks->horizontalHeader());
+        ui->tblBooks->horizontalHeader()->setSortIndicator(column, order);
+    });
+    connect(m_bookModel, &BookTableModel::loadingChanged, this, [this](bool loading) {
+        if(loading) {
+            beginBusy();
+        } else {
+            endBusy();
+        }
+    });
+
+    // 输入联想：停止输入150毫秒后再查前缀树，候选已按热度排好，不让QCompleter再过滤
+    m_suggestionModel = new QStringListModel(this);
+    m_completer = new QCompleter(m_suggestionModel, this);
+    m_completer->setCompletionMode(QCompleter::UnfilteredPopupCompletion);
+    m_completer->setMaxVisibleItems(CompletionTrie::TopK);
+    ui->txtSearch->setCompleter(m_completer);
+    connect(m_completer, QOverload<const QString &>::of(&QCompleter::activated), this, [this](const QString &text) {
+        m_suggestTimer->stop();
+        ui->txtSearch->setText(text);
+        onSearchBooks();
+    });
+
+    m_suggestTimer = new QTimer(this);
+    m_suggestTimer->setSingleShot(true);
+    m_suggestTimer->setInterval(150);
+    connect(m_suggestTimer, &QTimer::timeout, this, &MainWindow::updateSuggestions);
+    connect(ui->txtSearch, &QLineEdit::textEdited, this, &MainWindow::onSearchTextChanged);
+
     // 创建升级检查定时器
     QTimer *upgradeTimer = new QTimer(this);
     connect(upgradeTimer, &QTimer::timeout, this, &MainWindow::checkForUpgrade);
@@ -69,6 +128,16 @@ void MainWindow::showLoginDialog()
 
         // 转移所有权
         m_currentUser = dlg.getAuthenticatedUser();
+        if (m_currentUser) {
+            connect(m_currentUser, &User::upgraded, this, [this]() {
+                QMessageBox::information(this, "升级成功",
+                    "恭喜您已升级为超级读者！\n"
+                    "新的借阅权限：最多可借8本书，借期4周\n"
+                    "信用分已提升至120");
+                updateUI();
+                updateUserInfo();
+            });
+        }
         updateUI();
         updateUserInfo();
         checkForUpgrade();
@@ -121,6 +190,7 @@ void MainWindow::updateUI()
     ui->btnAddBook->setEnabled(isAdmin);
     ui->btnRemoveBook->setEnabled(isAdmin);
     ui->btnManageUsers->setEnabled(isAdmin);
+    ui->btnCirculationReport->setEnabled(isAdmin);
 
     if(loggedIn && m_currentUser) {
         setWindowTitle(tr("图书管理系统 - 用户: %1").arg(m_currentUser->name()));
@@ -129,6 +199,27 @@ void MainWindow::updateUI()
     }
 }
 
+void MainWindow::onSearchTextChanged()
+{
+    // 每次按键只重启定时器，连续输入时不反复查询
+    m_suggestTimer->start();
+}
+
+void MainWindow::updateSuggestions()
+{
+    QString prefix = ui->txtSearch->text();
+    if(prefix.trimmed().isEmpty() || !CompletionTrie::instance()->isReady()) {
+        m_suggestionModel->setStringList(QStringList());
+        return;
+    }
+
+    QStringList suggestions = CompletionTrie::instance()->complete(prefix);
+    m_suggestionModel->setStringList(suggestions);
+    if(!suggestions.isEmpty() && ui->txtSearch->hasFocus()) {
+        m_completer->complete();
+    }
+}
+
 void MainWindow::onSearchBooks()
 {
     // 添加UI元素空指针检查
@@ -137,47 +228,30 @@ void MainWindow::onSearchBooks()
         return;
     }
 
-    QString keyword = ui->txtSearch->text();
-    if(keyword.isEmpty()) {
-        // 确保表格有效
-        if (ui->tblBooks->rowCount() == 0) {
-            ui->tblBooks->setRowCount(1);
-        }
+    // 关键词为空时浏览全部图书，行随滚动分页加载
+    m_bookModel->search(ui->txtSearch->text());
+}
 
-        // 安全设置表格项
-        QTableWidgetItem* item = new QTableWidgetItem("请输入搜索关键词");
-        if (ui->tblBooks->item(0, 0) == nullptr) {
-            ui->tblBooks->setItem(0, 0, item);
-        } else {
-            ui->tblBooks->item(0, 0)->setText("请输入搜索关键词");
-        }
-        return;
-    }
+QString MainWindow::selectedIsbn() const
+{
+    QModelIndex current = ui->tblBooks->currentIndex();
+    if(!current.isValid()) return QString();
+    return m_bookModel->isbnAt(current.row());
+}
 
-    if (!m_library) {
-        qWarning() << "Library system not available for search";
-        return;
+void MainWindow::beginBusy()
+{
+    if(m_busyCount++ == 0) {
+        m_busyIndicator->show();
+        QApplication::setOverrideCursor(Qt::BusyCursor);
     }
-
-    QList<Book*> books = m_library->searchBooks(keyword);
-    updateBookList(books);
 }
 
-void MainWindow::updateBookList(const QList<Book*>& books)
+void MainWindow::endBusy()
 {
-    ui->tblBooks->clearContents();
-    ui->tblBooks->setRowCount(books.size());
-
-    for(int i = 0; i < books.size(); ++i) {
-        Book *book = books[i];
-        ui->tblBooks->setItem(i, 0, new QTableWidgetItem(book->isbn()));
-        ui->tblBooks->setItem(i, 1, new QTableWidgetItem(book->title()));
-        ui->tblBooks->setItem(i, 2, new QTableWidgetItem(book->author()));
-        ui->tblBooks->setItem(i, 3, new QTableWidgetItem(QString::number(book->availableCopies())));
-
-        // 显示评分
-        double rating = Book::calculateAverageRating(book->isbn());
-        ui->tblBooks->setItem(i, 4, new QTableWidgetItem(QString::number(rating, 'f', 1)));
+    if(m_busyCount > 0 && --m_busyCount == 0) {
+        m_busyIndicator->hide();
+        QApplication::restoreOverrideCursor();
     }
 }
 
@@ -190,21 +264,24 @@ void MainWindow::onBorrowBook()
     if(!m_currentUser) return;
     if (!m_library) return;
 
-    int row = ui->tblBooks->currentRow();
-    if(row < 0 || row >= ui->tblBooks->rowCount()) {
+    QString isbn = selectedIsbn();
+    if(isbn.isEmpty()) {
         QMessageBox::information(this, "提示", "请选择有效的图书");
         return;
     }
-
-    QString isbn = ui->tblBooks->item(row, 0)->text();
-    if(m_library->borrowBook(m_currentUser->id(), isbn)) {
-        QMessageBox::information(this, "成功", "图书借阅成功");
-        onSearchBooks(); // 刷新列表
-        updateUserInfo(); // 更新用户信息
-    } else {
-        QMessageBox::warning(this, "失败", "图书借阅失败");
-    }
-    
+    ui->btnBorrow->setEnabled(false); // 防止重复提交
+    beginBusy();
+    whenFinished(m_library->borrowBookAsync(m_currentUser->id(), isbn), this, [this](bool ok) {
+        endBusy();
+        ui->btnBorrow->setEnabled(m_currentUser != nullptr);
+        if(ok) {
+            QMessageBox::information(this, "成功", "图书借阅成功");
+            m_bookModel->refresh(); // 刷新列表
+            updateUserInfo(); // 更新用户信息
+        } else {
+            QMessageBox::warning(this, "失败", "图书借阅失败");
+        }
+    });
 }
 
 void MainWindow::updateUserInfo()
@@ -222,42 +299,52 @@ void MainWindow::updateUserInfo()
     ui->lblUserName->setText(m_currentUser->name());
     ui->lblUserID->setText(m_currentUser->id());
 
-    // 显示用户类型和信用分
-    QString userType = (m_currentUser->type() == User::Super) ? "超级读者" : "普通读者";
-    QString creditInfo = QString::number(m_currentUser->creditScore());
+    // 用户信息、在借图书、罚款和信用分一次查询取回
+    QString userId = m_currentUser->id();
+    beginBusy();
+    whenFinished(m_library->loadUserDashboardAsync(userId), this,
+                 [this, userId](const Library::UserDashboard &dashboard) {
+        endBusy();
+        // 期间可能已注销或切换用户
+        if(!m_currentUser || m_currentUser->id() != userId) return;
+        applyUserDashboard(dashboard);
+    });
+}
 
+void MainWindow::applyUserDashboard(const Library::UserDashboard &dashboard)
+{
+    if(!dashboard.valid) return;
+
+    ui->lblUserName->setText(dashboard.name);
+
+    // 显示用户类型和信用分
+    QString userType = (dashboard.type == User::Super) ? "超级读者" : "普通读者";
     ui->lblUserType->setText(userType);
-    ui->lblCreditScore->setText(creditInfo);
+    ui->lblCreditScore->setText(QString::number(dashboard.creditScore));
 
-    ui->lblReadingHours->setText(QString::number(m_currentUser->readingHours(), 'f', 1) + "小时");
-    ui->lblFines->setText(QString::number(m_currentUser->fines(), 'f', 2) + "元");
+    ui->lblReadingHours->setText(QString::number(dashboard.readingHours, 'f', 1) + "小时");
+    ui->lblFines->setText(QString::number(dashboard.fines, 'f', 2) + "元");
 
     // 显示当前借阅数量
-    int currentBorrow = m_library->getCurrentBorrowCount(m_currentUser->id());
     ui->lblCurrentBorrow->setText(QString("%1 / %2")
-                                 .arg(currentBorrow)
-                                 .arg(m_currentUser->maxBorrowCount()));
-
-    // 显示借阅记录
-    QList<Book*> borrowedBooks = m_library->getBooksBorrowedByUser(m_currentUser->id());
+                                 .arg(dashboard.loans.size())
+                                 .arg(dashboard.maxBorrowCount));
 
     // 安全处理表格更新
     if (ui->tblBorrowedBooks) {
         ui->tblBorrowedBooks->clearContents();
-        ui->tblBorrowedBooks->setRowCount(borrowedBooks.size());
+        ui->tblBorrowedBooks->setRowCount(dashboard.loans.size());
 
-        for(int i = 0; i < borrowedBooks.size(); ++i) {
-            Book *book = borrowedBooks[i];
-            // 获取借阅记录详情
-            Library::BorrowRecord record = m_library->getBorrowRecord(m_currentUser->id(), book->isbn());
+        for(int i = 0; i < dashboard.loans.size(); ++i) {
+            const Library::DashboardLoan &loan = dashboard.loans[i];
 
-            ui->tblBorrowedBooks->setItem(i, 0, new QTableWidgetItem(book->isbn()));
-            ui->tblBorrowedBooks->setItem(i, 1, new QTableWidgetItem(book->title()));
-            ui->tblBorrowedBooks->setItem(i, 2, new QTableWidgetItem(record.borrowDate.toString("yyyy-MM-dd")));
-            ui->tblBorrowedBooks->setItem(i, 3, new QTableWidgetItem(record.dueDate.toString("yyyy-MM-dd")));
+            ui->tblBorrowedBooks->setItem(i, 0, new QTableWidgetItem(loan.isbn));
+            ui->tblBorrowedBooks->setItem(i, 1, new QTableWidgetItem(loan.title));
+            ui->tblBorrowedBooks->setItem(i, 2, new QTableWidgetItem(loan.borrowDate.toString("yyyy-MM-dd")));
+            ui->tblBorrowedBooks->setItem(i, 3, new QTableWidgetItem(loan.dueDate.toString("yyyy-MM-dd")));
 
             // 显示剩余天数
-            int daysLeft = QDate::currentDate().daysTo(record.dueDate);
+            int daysLeft = QDate::currentDate().daysTo(loan.dueDate);
             QTableWidgetItem *daysItem = new QTableWidgetItem(QString::number(daysLeft));
             if(daysLeft <= 3) {
                 daysItem->setForeground(Qt::red); // 即将到期显示为红色
@@ -314,13 +401,19 @@ void MainWindow::onReturnBook()
     }
 
     QString isbn = ui->tblBorrowedBooks->item(row, 0)->text();
-    if(m_library->returnBook(m_currentUser->id(), isbn)) {
-        QMessageBox::information(this, "成功", "图书归还成功");
-        updateUserInfo();
-        onSearchBooks();
-    } else {
-        QMessageBox::warning(this, "失败", "图书归还失败");
-    }
+    ui->btnReturn->setEnabled(false); // 防止重复提交
+    beginBusy();
+    whenFinished(m_library->returnBookAsync(m_currentUser->id(), isbn), this, [this](bool ok) {
+        endBusy();
+        ui->btnReturn->setEnabled(m_currentUser != nullptr);
+        if(ok) {
+            QMessageBox::information(this, "成功", "图书归还成功");
+            updateUserInfo();
+            m_bookModel->refresh();
+        } else {
+            QMessageBox::warning(this, "失败", "图书归还失败");
+        }
+    });
 }
 
 void MainWindow::onRenewBook()
@@ -348,13 +441,11 @@ void MainWindow::onAddComment()
     if(!m_currentUser) return;
     if (!m_library) return;
 
-    int row = ui->tblBooks->currentRow();
-    if(row < 0 || row >= ui->tblBooks->rowCount()) {
+    QString isbn = selectedIsbn();
+    if(isbn.isEmpty()) {
         QMessageBox::information(this, "提示", "请选择有效的图书");
         return;
     }
-
-    QString isbn = ui->tblBooks->item(row, 0)->text();
     QString comment = ui->txtComment->toPlainText();
     int rating = ui->spinRating->value();
 
@@ -367,7 +458,7 @@ void MainWindow::onAddComment()
         QMessageBox::information(this, "成功", "评论成功");
         ui->txtComment->clear(); // 清空评论框
         ui->spinRating->setValue(3); // 重置评分
-        onSearchBooks();
+        m_bookModel->refresh();
     } else {
         QMessageBox::warning(this, "失败", "评论失败");
     }
@@ -397,16 +488,14 @@ void MainWindow::onRemoveBook()
 {
     if (!m_library) return;
 
-    int row = ui->tblBooks->currentRow();
-    if(row < 0 || row >= ui->tblBooks->rowCount()) {
+    QString isbn = selectedIsbn();
+    if(isbn.isEmpty()) {
         QMessageBox::information(this, "提示", "请选择有效的图书");
         return;
     }
-
-    QString isbn = ui->tblBooks->item(row, 0)->text();
     if(m_library->removeBook(isbn)) {
         QMessageBox::information(this, "成功", "图书删除成功");
-        onSearchBooks();
+        m_bookModel->refresh();
     } else {
         QMessageBox::warning(this, "失败", "删除失败");
     }
@@ -425,6 +514,14 @@ void MainWindow::showBookDetails(Book *book)
         .arg(book->publishDate().toString("yyyy-MM-dd"))
         .arg(book->introduction());
 
+    BookRecordList together = m_library->getBorrowedTogether(book->isbn());
+    if(!together.isEmpty()) {
+        info += "\n\n借过这本书的读者也借了：";
+        foreach (const BookRecord &record, together) {
+            info += QString("\n  《%1》 %2").arg(record.title()).arg(record.author());
+        }
+    }
+
     QMessageBox::information(this, "图书详情", info);
 }
 
@@ -450,6 +547,50 @@ void MainWindow::onManageUsers()
     UserManagerDialog dlg(m_library, this);
     dlg.exec();
 }
+
+// 近12个月的借阅统计，取自启动时后台加载的列式快照
+void MainWindow::onCirculationReport()
+{
+    if (!m_library) return;
+    CirculationStore *store = CirculationStore::instance();
+    if(!store->isLoaded()) {
+        QMessageBox::information(this, "提示", "借阅统计数据正在加载，请稍后再试");
+        return;
+    }
+
+    QDate today = QDate::currentDate();
+    QDate from = today.addYears(-1).addDays(1);
+    beginBusy();
+    whenFinished(QtConcurrent::run(m_library->workerPool(), [store, from, today]() {
+        return store->report(from, today, today, 5);
+    }), this, [this](const CirculationStore::Report &report) {
+        endBusy();
+        QString info = QString("统计区间：%1 至 %2\n借出：%3（未还 %4）\n逾期：%5（%6%）\n罚款：%7 元\n"
+                               "普通读者借出：%8\n高级读者借出：%9")
+            .arg(report.from.toString("yyyy-MM-dd"))
+            .arg(report.to.toString("yyyy-MM-dd"))
+            .arg(report.loans)
+            .arg(report.openLoans)
+            .arg(report.overdueLoans)
+            .arg(report.overdueRate * 100, 0, 'f', 1)
+            .arg(report.fineCents / 100.0, 0, 'f', 2)
+            .arg(report.normalReaders.loans)
+            .arg(report.superReaders.loans);
+        info += "\n\n按月：";
+        foreach (const CirculationStore::MonthRow &row, report.months) {
+            info += QString("\n  %1-%2  借出 %3  逾期 %4")
+                .arg(row.year).arg(row.month, 2, 10, QChar('0'))
+                .arg(row.totals.loans).arg(row.totals.overdue);
+        }
+        if(!report.topAuthors.isEmpty()) {
+            info += "\n\n借阅最多的作者：";
+            foreach (const CirculationStore::AuthorRow &row, report.topAuthors) {
+                info += QString("\n  %1  借出 %2").arg(row.author).arg(row.totals.loans);
+            }
+        }
+        QMessageBox::information(this, "借阅统计", info);
+    });
+}
 void MainWindow::showEvent(QShowEvent *event)
 {
     QMainWindow::showEvent(event);
@@ -459,7 +600,7 @@ void MainWindow::showEvent(QShowEvent *event)
         firstShow = false;
 
         // 使用单次定时器延迟初始化
-        QTimer::singleShot(100, this, [this]() {
+        QTimer::singleShot(0, this, [this]() {
             qDebug() << "Performing delayed initial UI setup";
 
             // 添加空指针检查
@@ -492,13 +633,12 @@ MainWindow::~MainWindow()
 }
 void MainWindow::on_btnRemoveBook_clicked()
 {
-    int row = ui->tblBooks->currentRow();
-    if (row < 0) return;
-    QString isbn = ui->tblBooks->item(row, 0)->text();
+    QString isbn = selectedIsbn();
+    if (isbn.isEmpty()) return;
 
     if (m_library->removeBook(isbn)) {
         QMessageBox::information(this, "提示", "删除成功");
-        onSearchBooks(); // 删除后刷新
+        m_bookModel->refresh(); // 删除后刷新
     } else {
         QMessageBox::warning(this, "提示", "删除失败，可能有未归还的借阅记录");
     }
@@ -506,32 +646,38 @@ void MainWindow::on_btnRemoveBook_clicked()
 void MainWindow::onReserveBook()
 {
     if(!m_currentUser || !m_library) return;
-    int row = ui->tblBooks->currentRow();
-    if(row < 0 || row >= ui->tblBooks->rowCount()) {
+    QString isbn = selectedIsbn();
+    if(isbn.isEmpty()) {
         QMessageBox::information(this, "提示", "请选择有效的图书");
         return;
     }
-    QString isbn = ui->tblBooks->item(row, 0)->text();
     if(m_library->reserveBook(m_currentUser->id(), isbn)) {
-        QMessageBox::information(this, "成功", "预约成功");
+        ReservationQueue *queue = ReservationQueue::instance();
+        QDateTime deadline = queue->pickupDeadline(m_currentUser->id(), isbn);
+        if(deadline.isValid()) {
+            QMessageBox::information(this, "成功",
+                QString("预约成功，已为您保留一册，请于 %1 前借阅")
+                    .arg(deadline.toString("yyyy年MM月dd日 HH:mm")));
+        } else {
+            QMessageBox::information(this, "成功",
+                QString("预约成功，您排在第 %1 位").arg(queue->position(m_currentUser->id(), isbn)));
+        }
     } else {
         QMessageBox::warning(this, "失败", "预约失败");
     }
 }
 void MainWindow::onBookDetails()
 {
-    int row = ui->tblBooks->currentRow();
-    if(row < 0 || row >= ui->tblBooks->rowCount()) {
+    QString isbn = selectedIsbn();
+    if(isbn.isEmpty()) {
         QMessageBox::information(this, "提示", "请选择有效的图书");
         return;
     }
-    QString isbn = ui->tblBooks->item(row, 0)->text();
     Book* book = m_library->findBookByIsbn(isbn);
     showBookDetails(book);
 }
 void MainWindow::onViewTopBooks()
 {
     if (!m_library) return;
-    QList<Book*> books = m_library->getTopRatedBooks();
-    updateBookList(books);
+    m_bookModel->browse(BookTableModel::RatingColumn, Qt::DescendingOrder);
 }
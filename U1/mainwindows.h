@@ -3,9 +3,14 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QProgressBar>
+#include <QCompleter>
+#include <QStringListModel>
+#include <QTimer>
 #include "library.h"
 #include "user.h"
 #include "creditdialog.h"
+#include "booktablemodel.h"
 
 namespace Ui {
 class MainWindow;
@@ -31,9 +36,12 @@ private slots:
     void onRemoveBook();
     void onManageUsers();
     void onViewTopBooks();
+    void onCirculationReport();
     void onManageCredit();
     void onReserveBook();
     void onBookDetails();
+    void onSearchTextChanged();
+    void updateSuggestions();
 
     void logout();
     void on_btnRemoveBook_clicked();
@@ -44,11 +52,20 @@ private:
     Ui::MainWindow *ui;
     Library *m_library;
     User *m_currentUser;
+    QProgressBar *m_busyIndicator;
+    int m_busyCount;
+    BookTableModel *m_bookModel;
+    QCompleter *m_completer;
+    QStringListModel *m_suggestionModel;
+    QTimer *m_suggestTimer;
 
+    void beginBusy();
+    void endBusy();
+    void applyUserDashboard(const Library::UserDashboard &dashboard);
     void updateUI();
     void showLoginDialog();
     void showBookDetails(Book *book);
-    void updateBookList(const QList<Book*> &books);
+    QString selectedIsbn() const;
     void updateUserInfo();
     void checkForUpgrade();
 protected:
@@ -0,0 +1,486 @@
+// src/mysqlbackend.cpp
+#include "mysqlbackend.h"
+#include "database.h"
+#include "reservationqueue.h"
+#include <QThread>
+#include <QSqlQuery>
+#include <QDebug>
+
+// 借阅：锁定读者行后检查信用分和借阅上限，条件扣减可借数并写借阅记录，全部在一个事务内。
+// 读者有为该书保留的副本（预约 Ready）时直接借走保留的那一册，不占可借数。
+// 借出的副本优先用调用方从内存位图选出的 p_hint，已不可借时按 (ISBN, Status) 索引另取一册
+static const char *BorrowProcedure =
+    "CREATE PROCEDURE BorrowBook(IN p_user VARCHAR(6), IN p_isbn VARCHAR(20), IN p_today DATE, "
+    "                            IN p_hint VARCHAR(32), OUT p_status INT, OUT p_due DATE, "
+    "                            OUT p_limit INT, OUT p_copy VARCHAR(32)) "
+    "BEGIN "
+    "    DECLARE v_credit INT DEFAULT NULL; "
+    "    DECLARE v_type VARCHAR(16); "
+    "    DECLARE v_open INT DEFAULT 0; "
+    "    DECLARE v_days INT; "
+    "    DECLARE CONTINUE HANDLER FOR NOT FOUND SET v_credit = NULL; "
+    "    DECLARE EXIT HANDLER FOR SQLEXCEPTION BEGIN ROLLBACK; RESIGNAL; END; "
+    "    SET p_status = 0, p_due = NULL, p_limit = 0, p_copy = NULL; "
+    "    START TRANSACTION; "
+    "    SELECT CreditScore, Type INTO v_credit, v_type FROM Users WHERE UserID = p_user FOR UPDATE; "
+    "    IF v_credit IS NULL THEN "
+    "        SET p_status = 1; "
+    "    ELSEIF v_credit < 90 THEN "
+    "        SET p_status = 2; "
+    "    ELSE "
+    "        SET p_limit = IF(v_type = 'Super', 8, 5); "
+    "        SET v_days = IF(v_type = 'Super', 28, 14); "
+    "        SELECT COUNT(*) INTO v_open FROM BorrowRecords WHERE UserID = p_user AND ReturnDate IS NULL; "
+    "        IF v_open >= p_limit THEN "
+    "            SET p_status = 3; "
+    "        ELSE "
+    "            UPDATE Reservations SET Status = 'Fulfilled' "
+    "             WHERE UserID = p_user AND ISBN = p_isbn AND Status = 'Ready' "
+    "             ORDER BY ReservationID LIMIT 1; "
+    "            IF ROW_COUNT() = 0 THEN "
+    "                UPDATE Books SET AvailableCopies = AvailableCopies - 1 "
+    "                 WHERE ISBN = p_isbn AND AvailableCopies > 0; "
+    "                IF ROW_COUNT() = 0 THEN "
+    "                    SET p_status = IF(EXISTS(SELECT 1 FROM Books WHERE ISBN = p_isbn), 4, 5); "
+    "                END IF; "
+    "            END IF; "
+    "            IF p_status = 0 THEN "
+    "                UPDATE BookCopies SET Status = 'Borrowed' "
+    "                 WHERE CopyID = p_hint AND ISBN = p_isbn AND Status = 'Available'; "
+    "                IF ROW_COUNT() > 0 THEN "
+    "                    SET p_copy = p_hint; "
+    "                ELSE "
+    "                    BEGIN "
+    "                        DECLARE CONTINUE HANDLER FOR NOT FOUND SET p_copy = NULL; "
+    "                        SELECT CopyID INTO p_copy FROM BookCopies "
+    "                         WHERE ISBN = p_isbn AND Status = 'Available' "
+    "                         ORDER BY CopyID LIMIT 1 FOR UPDATE; "
+    "                    END; "
+    "                    UPDATE BookCopies SET Status = 'Borrowed' WHERE CopyID = p_copy; "
+    "                END IF; "
+    "                SET p_due = DATE_ADD(p_today, INTERVAL v_days DAY); "
+    "                INSERT INTO BorrowRecords (UserID, ISBN, CopyID, BorrowDate, DueDate) "
+    "                VALUES (p_user, p_isbn, p_copy, p_today, p_due); "
+    "            END IF; "
+    "        END IF; "
+    "    END IF; "
+    "    IF p_status = 0 THEN COMMIT; ELSE ROLLBACK; END IF; "
+    "END";
+
+// 归还：结清最早的一条在借记录、归还副本；逾期时按天记罚款并扣信用分。
+// 该书有人排队时副本不放回可借，而是按 (ISBN, Status, Priority, ReservationID) 索引取队首保留给他，
+// 取书期限为 %1 天。单表 UPDATE 从左到右赋值，HadLowCredit 判断用的是扣分之后的 CreditScore
+static const char *ReturnProcedure =
+    "CREATE PROCEDURE ReturnBook(IN p_user VARCHAR(6), IN p_isbn VARCHAR(20), IN p_today DATE, "
+    "                            OUT p_status INT, OUT p_fine DECIMAL(10,2), OUT p_deduction INT, "
+    "                            OUT p_credit INT, OUT p_hold INT, OUT p_deadline DATETIME, "
+    "                            OUT p_copy VARCHAR(32)) "
+    "BEGIN "
+    "    DECLARE v_record INT DEFAULT NULL; "
+    "    DECLARE v_due DATE; "
+    "    DECLARE v_overdue INT DEFAULT 0; "
+    "    DECLARE CONTINUE HANDLER FOR NOT FOUND SET v_record = NULL; "
+    "    DECLARE EXIT HANDLER FOR SQLEXCEPTION BEGIN ROLLBACK; RESIGNAL; END; "
+    "    SET p_status = 0, p_fine = 0, p_deduction = 0, p_credit = NULL, p_hold = NULL, p_deadline = NULL, "
+    "        p_copy = NULL; "
+    "    START TRANSACTION; "
+    "    SELECT RecordID, DueDate, CopyID INTO v_record, v_due, p_copy FROM BorrowRecords "
+    "     WHERE UserID = p_user AND ISBN = p_isbn AND ReturnDate IS NULL "
+    "     ORDER BY BorrowDate, RecordID LIMIT 1 FOR UPDATE; "
+    "    IF v_record IS NULL THEN "
+    "        SET p_status = 6; "
+    "        ROLLBACK; "
+    "    ELSE "
+    "        SET v_overdue = GREATEST(DATEDIFF(p_today, v_due), 0); "
+    "        IF v_overdue > 0 THEN "
+    "            SET p_fine = v_overdue * 0.5; "
+    "            SET p_deduction = IF(v_overdue <= 7, 2, 5); "
+    "        END IF; "
+    "        UPDATE BorrowRecords SET ReturnDate = p_today, Fine = p_fine, CreditDeduction = p_deduction "
+    "         WHERE RecordID = v_record; "
+    "        IF p_copy IS NULL THEN "
+    "            BEGIN "
+    "                DECLARE CONTINUE HANDLER FOR NOT FOUND SET p_copy = NULL; "
+    "                SELECT CopyID INTO p_copy FROM BookCopies "
+    "                 WHERE ISBN = p_isbn AND Status = 'Borrowed' ORDER BY CopyID LIMIT 1 FOR UPDATE; "
+    "            END; "
+    "        END IF; "
+    "        UPDATE BookCopies SET Status = 'Available' WHERE CopyID = p_copy AND Status = 'Borrowed'; "
+    "        BEGIN "
+    "            DECLARE CONTINUE HANDLER FOR NOT FOUND SET p_hold = NULL; "
+    "            SELECT ReservationID INTO p_hold FROM Reservations "
+    "             WHERE ISBN = p_isbn AND Status = 'Pending' "
+    "             ORDER BY Priority DESC, ReservationID LIMIT 1 FOR UPDATE; "
+    "        END; "
+    "        IF p_hold IS NULL THEN "
+    "            UPDATE Books SET AvailableCopies = AvailableCopies + 1 "
+    "             WHERE ISBN = p_isbn AND AvailableCopies < TotalCopies; "
+    "        ELSE "
+    "            SET p_deadline = DATE_ADD(NOW(), INTERVAL %1 DAY); "
+    "            UPDATE Reservations SET Status = 'Ready', ReadyAt = NOW(), PickupDeadline = p_deadline "
+    "             WHERE ReservationID = p_hold; "
+    "        END IF; "
+    "        IF v_overdue > 0 THEN "
+    "            UPDATE Users SET Fines = Fines + p_fine, "
+    "                             CreditScore = GREATEST(CreditScore - p_deduction, 0), "
+    "                             HadLowCredit = HadLowCredit OR CreditScore < 90 "
+    "             WHERE UserID = p_user; "
+    "            SELECT CreditScore INTO p_credit FROM Users WHERE UserID = p_user; "
+    "        END IF; "
+    "        COMMIT; "
+    "    END IF; "
+    "END";
+
+static QVector<SchemaMigrator::Migration> buildMigrations()
+{
+    QVector<SchemaMigrator::Migration> list;
+
+    // 1. 引入迁移前的表结构：旧库已有这些表，逐条补齐缺失的列和索引
+    SchemaMigrator::Migration baseline;
+    baseline.version = 1;
+    baseline.description = "baseline tables";
+    baseline.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS Users ("
+        "   UserID VARCHAR(6) PRIMARY KEY,"
+        "   Email VARCHAR(50) UNIQUE NOT NULL,"
+        "   Password VARCHAR(255) NOT NULL,"
+        "   Name VARCHAR(50) NOT NULL,"
+        "   Type ENUM('Normal', 'Super') DEFAULT 'Normal',"
+        "   TotalReadingHours FLOAT DEFAULT 0.0,"
+        "   Fines DECIMAL(10,2) DEFAULT 0.0,"
+        "   CreditScore INT DEFAULT 100,"  // 信用分
+        "   HadLowCredit BOOLEAN DEFAULT FALSE" // 是否曾低于90分
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS Books ("
+        "   ISBN VARCHAR(20) PRIMARY KEY,"
+        "   Title VARCHAR(255) NOT NULL,"
+        "   Author VARCHAR(100) NOT NULL,"
+        "   Publisher VARCHAR(100),"
+        "   PublishDate DATE,"
+        "   Price DECIMAL(10,2),"
+        "   Introduction TEXT,"
+        "   TotalCopies INT NOT NULL,"
+        "   AvailableCopies INT NOT NULL"
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS BorrowRecords ("
+        "   RecordID INT AUTO_INCREMENT PRIMARY KEY,"
+        "   UserID VARCHAR(6) NOT NULL,"
+        "   ISBN VARCHAR(20) NOT NULL,"
+        "   BorrowDate DATE NOT NULL,"
+        "   DueDate DATE NOT NULL,"
+        "   ReturnDate DATE,"
+        "   Fine DECIMAL(10,2) DEFAULT 0.0,"
+        "   CreditDeduction INT DEFAULT 0,"  // 信用分扣除
+        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
+        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS Comments ("
+        "   CommentID INT AUTO_INCREMENT PRIMARY KEY,"
+        "   UserID VARCHAR(6) NOT NULL,"
+        "   ISBN VARCHAR(20) NOT NULL,"
+        "   Comment TEXT,"
+        "   Rating INT CHECK (Rating BETWEEN 1 AND 5),"
+        "   CommentDate DATETIME NOT NULL,"
+        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
+        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
+        ");",
+
+        // 每本书的评分汇总，随评论增量维护，避免每次对 Comments 做 AVG
+        "CREATE TABLE IF NOT EXISTS BookRatingStats ("
+        "   ISBN VARCHAR(20) PRIMARY KEY,"
+        "   RatingCount INT NOT NULL DEFAULT 0,"
+        "   RatingSum INT NOT NULL DEFAULT 0,"
+        "   Rating1 INT NOT NULL DEFAULT 0,"
+        "   Rating2 INT NOT NULL DEFAULT 0,"
+        "   Rating3 INT NOT NULL DEFAULT 0,"
+        "   Rating4 INT NOT NULL DEFAULT 0,"
+        "   Rating5 INT NOT NULL DEFAULT 0,"
+        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN) ON DELETE CASCADE"
+        ");",
+
+        "CREATE TABLE IF NOT EXISTS Reservations ("
+        "   ReservationID INT AUTO_INCREMENT PRIMARY KEY,"
+        "   UserID VARCHAR(6) NOT NULL,"
+        "   ISBN VARCHAR(20) NOT NULL,"
+        "   ReserveDate DATETIME NOT NULL,"
+        "   Status ENUM('Pending', 'Fulfilled', 'Cancelled') DEFAULT 'Pending',"
+        "   FOREIGN KEY (UserID) REFERENCES Users(UserID),"
+        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN)"
+        ");",
+
+        // 逾期批处理每天一行，主键保证同一天只处理一次
+        "CREATE TABLE IF NOT EXISTS OverdueRuns ("
+        "   RunDate DATE PRIMARY KEY,"
+        "   StartedAt DATETIME NOT NULL,"
+        "   FinishedAt DATETIME,"
+        "   OverdueLoans INT NOT NULL DEFAULT 0,"
+        "   SevereLoans INT NOT NULL DEFAULT 0,"
+        "   UsersPenalized INT NOT NULL DEFAULT 0,"
+        "   CreditDeducted INT NOT NULL DEFAULT 0,"
+        "   DurationMs BIGINT NOT NULL DEFAULT 0,"
+        "   RowsPerSecond DOUBLE NOT NULL DEFAULT 0"
+        ");",
+
+        "ALTER TABLE Users ADD COLUMN CreditScore INT DEFAULT 100",
+        "ALTER TABLE Users ADD COLUMN HadLowCredit BOOLEAN DEFAULT FALSE",
+        "ALTER TABLE Users ADD COLUMN Type VARCHAR(16) DEFAULT 'Normal'",
+        "ALTER TABLE BorrowRecords ADD COLUMN CreditDeduction INT DEFAULT 0",
+
+        // 图书列表按书名/可借数量排序翻页时使用的索引（InnoDB 二级索引自带主键 ISBN）
+        "ALTER TABLE Books ADD INDEX idx_books_title (Title)",
+        "ALTER TABLE Books ADD INDEX idx_books_available (AvailableCopies)"
+    };
+    list.append(baseline);
+
+    // 2. 借还热点查询的索引：
+    //    读者在借/已还记录、某书的在借记录、逾期扫描、某书的评论按时间、某书的待处理预约
+    SchemaMigrator::Migration circulationIndexes;
+    circulationIndexes.version = 2;
+    circulationIndexes.description = "circulation indexes";
+    circulationIndexes.statements = QStringList{
+        "ALTER TABLE BorrowRecords ADD INDEX idx_borrow_user_return (UserID, ReturnDate)",
+        "ALTER TABLE BorrowRecords ADD INDEX idx_borrow_isbn_return (ISBN, ReturnDate)",
+        "ALTER TABLE BorrowRecords ADD INDEX idx_borrow_return_due (ReturnDate, DueDate)",
+        "ALTER TABLE Comments ADD INDEX idx_comments_isbn_date (ISBN, CommentDate)",
+        "ALTER TABLE Reservations ADD INDEX idx_reservations_isbn_status (ISBN, Status)"
+    };
+    list.append(circulationIndexes);
+
+    // 3. 副本表（Library::addBook 按 ISBN-序号 生成副本编号），已有图书按库存补齐副本：
+    //    前 AvailableCopies 个可借，其余视为借出
+    SchemaMigrator::Migration bookCopies;
+    bookCopies.version = 3;
+    bookCopies.description = "book copies";
+    bookCopies.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS BookCopies ("
+        "   CopyID VARCHAR(32) PRIMARY KEY,"
+        "   ISBN VARCHAR(20) NOT NULL,"
+        "   Status ENUM('Available', 'Borrowed', 'Lost') NOT NULL DEFAULT 'Available',"
+        "   INDEX idx_copies_isbn_status (ISBN, Status),"
+        "   FOREIGN KEY (ISBN) REFERENCES Books(ISBN) ON DELETE CASCADE"
+        ");",
+
+        "INSERT IGNORE INTO BookCopies (CopyID, ISBN, Status) "
+        "WITH RECURSIVE Seq (N) AS ("
+        "   SELECT 1 UNION ALL SELECT N + 1 FROM Seq "
+        "   WHERE N < (SELECT COALESCE(MAX(TotalCopies), 0) FROM Books)"
+        ") "
+        "SELECT CONCAT(b.ISBN, '-', LPAD(s.N, 3, '0')), b.ISBN, "
+        "       IF(s.N <= b.AvailableCopies, 'Available', 'Borrowed') "
+        "FROM Books b JOIN Seq s ON s.N <= b.TotalCopies"
+    };
+    list.append(bookCopies);
+
+    // 4. 表结构指纹：与程序内置的迁移和存储过程一致时启动跳过全部 DDL（见 Database::initialize）
+    SchemaMigrator::Migration schemaState;
+    schemaState.version = 4;
+    schemaState.description = "schema fingerprint";
+    schemaState.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS SchemaState ("
+        "   Id TINYINT PRIMARY KEY,"
+        "   Fingerprint CHAR(40) NOT NULL,"
+        "   UpdatedAt DATETIME NOT NULL"
+        ");"
+    };
+    list.append(schemaState);
+
+    // 5. 预约排队：Super 读者优先，同优先级先到先得；归还的副本保留给队首（Ready），
+    //    过了取书期限改为 Expired 并转给下一位。队首和到期扫描各有一个索引
+    SchemaMigrator::Migration reservationQueue;
+    reservationQueue.version = 5;
+    reservationQueue.description = "reservation queue";
+    reservationQueue.statements = QStringList{
+        "UPDATE Reservations SET Status = 'Pending' WHERE Status IS NULL",
+        "ALTER TABLE Reservations MODIFY Status "
+        "   ENUM('Pending', 'Ready', 'Fulfilled', 'Cancelled', 'Expired') NOT NULL DEFAULT 'Pending'",
+        "ALTER TABLE Reservations ADD COLUMN Priority TINYINT NOT NULL DEFAULT 0",
+        "ALTER TABLE Reservations ADD COLUMN ReadyAt DATETIME NULL",
+        "ALTER TABLE Reservations ADD COLUMN PickupDeadline DATETIME NULL",
+        "UPDATE Reservations r JOIN Users u ON u.UserID = r.UserID SET r.Priority = 1 "
+        "WHERE u.Type = 'Super'",
+        "ALTER TABLE Reservations ADD INDEX idx_reservations_queue (ISBN, Status, Priority DESC, ReservationID)",
+        "ALTER TABLE Reservations ADD INDEX idx_reservations_pickup (Status, PickupDeadline)"
+    };
+    list.append(reservationQueue);
+
+    // 6. 副本级流通：借阅记录指向具体副本。之前借还只改 AvailableCopies，副本状态不可信：
+    //    先全部置为可借，再把每本书的在借记录按 RecordID 顺序对应到按 CopyID 排序的副本上
+    SchemaMigrator::Migration copyCirculation;
+    copyCirculation.version = 6;
+    copyCirculation.description = "copy-level circulation";
+    copyCirculation.statements = QStringList{
+        "ALTER TABLE BorrowRecords ADD COLUMN CopyID VARCHAR(32) NULL",
+        "ALTER TABLE BorrowRecords ADD INDEX idx_borrow_copy (CopyID)",
+        "UPDATE BookCopies SET Status = 'Available' WHERE Status = 'Borrowed'",
+        "UPDATE BorrowRecords br "
+        "JOIN (SELECT RecordID, ISBN, ROW_NUMBER() OVER (PARTITION BY ISBN ORDER BY RecordID) AS Seq "
+        "      FROM BorrowRecords WHERE ReturnDate IS NULL) l ON l.RecordID = br.RecordID "
+        "JOIN (SELECT CopyID, ISBN, ROW_NUMBER() OVER (PARTITION BY ISBN ORDER BY CopyID) AS Seq "
+        "      FROM BookCopies WHERE Status = 'Available') c ON c.ISBN = l.ISBN AND c.Seq = l.Seq "
+        "SET br.CopyID = c.CopyID",
+        "UPDATE BookCopies c JOIN BorrowRecords br ON br.CopyID = c.CopyID AND br.ReturnDate IS NULL "
+        "SET c.Status = 'Borrowed'"
+    };
+    list.append(copyCirculation);
+
+    return list;
+}
+
+MySqlBackend::MySqlBackend(const ConnectionPool::Config &config)
+    : m_config(config), m_migrations(buildMigrations())
+{
+}
+
+ConnectionPool::Config MySqlBackend::defaultConfig()
+{
+    ConnectionPool::Config config;
+    config.driver = "QMYSQL";
+    config.hostName = "localhost";
+    config.databaseName = "library_system";
+    config.userName = "root";
+    config.password = "123456";
+    config.minSize = 2;
+    config.maxSize = qMax(4, QThread::idealThreadCount() + 1); // 每个工作线程一个，外加GUI线程
+    return config;
+}
+
+QString MySqlBackend::name() const {
+    return "mysql";
+}
+
+ConnectionPool::Config MySqlBackend::connectionConfig() const {
+    return m_config;
+}
+
+const QVector<SchemaMigrator::Migration> &MySqlBackend::migrations() const {
+    return m_migrations;
+}
+
+// 借还存储过程：表结构指纹变化时重建，过程体随程序版本更新
+QStringList MySqlBackend::routines() const
+{
+    return QStringList{
+        "DROP PROCEDURE IF EXISTS BorrowBook",
+        BorrowProcedure,
+        "DROP PROCEDURE IF EXISTS ReturnBook",
+        QString(ReturnProcedure).arg(ReservationQueue::PickupDays)
+    };
+}
+
+bool MySqlBackend::cachesStatements() const {
+    return true;
+}
+
+int MySqlBackend::maxBindValues() const {
+    return 65535;
+}
+
+// InnoDB 的行锁由 SELECT ... FOR UPDATE 在事务内按需加，普通 BEGIN 即可
+bool MySqlBackend::beginTransaction(QSqlDatabase &db)
+{
+    return db.transaction();
+}
+
+bool MySqlBackend::lockSchema()
+{
+    QSqlQuery lock = Database::instance()->executeQuery("SELECT GET_LOCK('library_schema_migration', 60)");
+    return lock.next() && lock.value(0).toInt() == 1;
+}
+
+void MySqlBackend::unlockSchema()
+{
+    Database::instance()->executeQuery("SELECT RELEASE_LOCK('library_schema_migration')");
+}
+
+// 存储过程在一个事务里锁定读者行、检查信用分和借阅上限、
+// 条件扣减可借数（AvailableCopies > 0）并写借阅记录，两个终端不可能同时借走最后一本
+Library::CirculationResult MySqlBackend::borrow(const QString &userId, const QString &isbn,
+                                                const QDate &today, const QString &copyHint)
+{
+    Library::CirculationResult result;
+    Database *db = Database::instance();
+    if(!db->executePrepared("borrow.call",
+            "CALL BorrowBook(?, ?, ?, ?, @borrow_status, @borrow_due, @borrow_limit, @borrow_copy)",
+            {userId, isbn, today, copyHint})) {
+        return result;
+    }
+
+    QSqlRecord q = db->executePreparedRow("borrow.result",
+        "SELECT @borrow_status, @borrow_due, @borrow_limit, @borrow_copy");
+    if(q.isEmpty()) {
+        return result;
+    }
+    result.status = static_cast<Library::CirculationStatus>(q.value(0).toInt());
+    result.dueDate = q.value(1).toDate();
+    result.borrowLimit = q.value(2).toInt();
+    result.copyId = q.value(3).toString();
+    return result;
+}
+
+// 存储过程在一个事务里结清借阅记录、归还副本，逾期时同时记罚款和扣信用分
+Library::CirculationResult MySqlBackend::giveBack(const QString &userId, const QString &isbn,
+                                                  const QDate &today)
+{
+    Library::CirculationResult result;
+    Database *db = Database::instance();
+    if(!db->executePrepared("return.call",
+            "CALL ReturnBook(?, ?, ?, @return_status, @return_fine, @return_deduction, @return_credit, "
+            "@return_hold, @return_deadline, @return_copy)",
+            {userId, isbn, today})) {
+        return result;
+    }
+
+    QSqlRecord q = db->executePreparedRow("return.result",
+        "SELECT @return_status, @return_fine, @return_deduction, @return_credit, "
+        "@return_hold, @return_deadline, @return_copy");
+    if(q.isEmpty()) {
+        return result;
+    }
+    result.status = static_cast<Library::CirculationStatus>(q.value(0).toInt());
+    result.fine = q.value(1).toDouble();
+    result.creditDeduction = q.value(2).toInt();
+    result.creditScore = q.value(3).toInt();
+    result.heldReservation = q.value(4).toInt();
+    result.pickupDeadline = q.value(5).toDateTime();
+    result.copyId = q.value(6).toString();
+    return result;
+}
+
+QString MySqlBackend::insertIgnore() const {
+    return "INSERT IGNORE";
+}
+
+QString MySqlBackend::now() const {
+    return "NOW()";
+}
+
+QString MySqlBackend::greatest() const {
+    return "GREATEST";
+}
+
+QString MySqlBackend::daysBetween(const QString &later, const QString &earlier) const
+{
+    return QString("DATEDIFF(%1, %2)").arg(later, earlier);
+}
+
+QString MySqlBackend::hashBucket(const QString &column) const
+{
+    return QString("MOD(CRC32(%1), ?)").arg(column);
+}
+
+QString MySqlBackend::upsertAdding(const QString &keyColumn, const QStringList &columns) const
+{
+    Q_UNUSED(keyColumn);
+    QStringList assignments;
+    foreach (const QString &column, columns) {
+        assignments << QString("%1 = %1 + VALUES(%1)").arg(column);
+    }
+    return "ON DUPLICATE KEY UPDATE " + assignments.join(", ");
+}
+
+QString MySqlBackend::forUpdate() const {
+    return " FOR UPDATE";
+}
@@ -0,0 +1,46 @@
+// include/mysqlbackend.h
+#ifndef MYSQLBACKEND_H
+#define MYSQLBACKEND_H
+
+#include "storagebackend.h"
+
+// MySQL 后端：借还走存储过程 BorrowBook/ReturnBook，迁移期间用命名锁互斥
+class MySqlBackend : public StorageBackend
+{
+public:
+    explicit MySqlBackend(const ConnectionPool::Config &config);
+
+    // 未配置时的连接参数（本机 library_system 库）
+    static ConnectionPool::Config defaultConfig();
+
+    QString name() const override;
+    ConnectionPool::Config connectionConfig() const override;
+
+    const QVector<SchemaMigrator::Migration> &migrations() const override;
+    QStringList routines() const override;
+    bool cachesStatements() const override;
+    int maxBindValues() const override;
+    bool beginTransaction(QSqlDatabase &db) override;
+
+    bool lockSchema() override;
+    void unlockSchema() override;
+
+    Library::CirculationResult borrow(const QString &userId, const QString &isbn,
+                                      const QDate &today, const QString &copyHint) override;
+    Library::CirculationResult giveBack(const QString &userId, const QString &isbn,
+                                        const QDate &today) override;
+
+    QString insertIgnore() const override;
+    QString now() const override;
+    QString greatest() const override;
+    QString daysBetween(const QString &later, const QString &earlier) const override;
+    QString hashBucket(const QString &column) const override;
+    QString upsertAdding(const QString &keyColumn, const QStringList &columns) const override;
+    QString forUpdate() const override;
+
+private:
+    ConnectionPool::Config m_config;
+    QVector<SchemaMigrator::Migration> m_migrations;
+};
+
+#endif // MYSQLBACKEND_H
@@ -0,0 +1,110 @@
+// src/overdueengine.cpp
+#include "overdueengine.h"
+#include "database.h"
+#include "storagebackend.h"
+#include "entitycache.h"
+#include <QSqlRecord>
+#include <QElapsedTimer>
+#include <QDebug>
+
+constexpr double OverdueEngine::FinePerDay;
+
+OverdueEngine::RunSummary::RunSummary()
+    : ok(false), skipped(false), overdueLoans(0), severeLoans(0), usersPenalized(0),
+      creditDeducted(0), durationMs(0), rowsPerSecond(0.0)
+{
+}
+
+OverdueEngine::RunSummary OverdueEngine::run(const QDate &today, bool dryRun)
+{
+    RunSummary summary;
+    summary.runDate = today;
+    QElapsedTimer timer;
+    timer.start();
+
+    Database *db = Database::instance();
+    StorageBackend *backend = db->backend();
+    if(!db->transaction()) return summary;
+
+    // 占住当天：已有记录时插入被忽略，说明今天处理过（或另一个客户端正在处理并已提交）
+    int claimed = 1;
+    if(!dryRun && !db->executePrepared("overdue.claim",
+            QString("%1 INTO OverdueRuns (RunDate, StartedAt) VALUES (?, %2)")
+                .arg(backend->insertIgnore(), backend->now()),
+            {today}, &claimed)) {
+        db->rollback();
+        return summary;
+    }
+    if(claimed == 0) {
+        db->rollback();
+        summary.ok = true;
+        summary.skipped = true;
+        return summary;
+    }
+
+    QDate severeBefore = today.addDays(-SevereOverdueDays);
+    QSqlRecord counts = db->executePreparedRow("overdue.count",
+        "SELECT COUNT(*), COALESCE(SUM(DueDate < ?), 0), "
+        "COUNT(DISTINCT CASE WHEN DueDate < ? THEN UserID END) "
+        "FROM BorrowRecords WHERE ReturnDate IS NULL AND DueDate < ?",
+        {severeBefore, severeBefore, today});
+    if(counts.isEmpty()) {
+        db->rollback();
+        return summary;
+    }
+    summary.overdueLoans = counts.value(0).toInt();
+    summary.severeLoans = counts.value(1).toInt();
+    summary.usersPenalized = counts.value(2).toInt();
+    summary.creditDeducted = summary.severeLoans * SevereCreditPenalty;
+
+    // 在借记录的累计罚款按天数重算，重复执行结果不变
+    bool ok = db->executePrepared("overdue.accrueFines",
+        QString("UPDATE BorrowRecords SET Fine = %1 * ? "
+                "WHERE ReturnDate IS NULL AND DueDate < ?").arg(backend->daysBetween("?", "DueDate")),
+        {today, FinePerDay, today});
+
+    // 严重逾期每本每天扣信用分；HadLowCredit 单独一条语句按扣分后的分数判断，
+    // 不依赖各库 UPDATE 内多列赋值的先后顺序
+    ok = ok && db->executePrepared("overdue.penalize",
+        QString("UPDATE Users SET CreditScore = %1(CreditScore - ? * ("
+                "    SELECT COUNT(*) FROM BorrowRecords r "
+                "    WHERE r.UserID = Users.UserID AND r.ReturnDate IS NULL AND r.DueDate < ?), 0) "
+                "WHERE UserID IN (SELECT UserID FROM BorrowRecords WHERE ReturnDate IS NULL AND DueDate < ?)")
+            .arg(backend->greatest()),
+        {SevereCreditPenalty, severeBefore, severeBefore});
+    ok = ok && db->executePrepared("overdue.lowCredit",
+        "UPDATE Users SET HadLowCredit = 1 "
+        "WHERE CreditScore < 90 AND NOT HadLowCredit "
+        "AND UserID IN (SELECT UserID FROM BorrowRecords WHERE ReturnDate IS NULL AND DueDate < ?)",
+        {severeBefore});
+
+    summary.durationMs = timer.elapsed();
+    summary.rowsPerSecond = summary.durationMs > 0
+        ? summary.overdueLoans * 1000.0 / summary.durationMs
+        : summary.overdueLoans;
+
+    ok = ok && (dryRun || db->executePrepared("overdue.finish",
+        QString("UPDATE OverdueRuns SET FinishedAt = %1, OverdueLoans = ?, SevereLoans = ?, "
+                "UsersPenalized = ?, CreditDeducted = ?, DurationMs = ?, RowsPerSecond = ? WHERE RunDate = ?")
+            .arg(backend->now()),
+        {summary.overdueLoans, summary.severeLoans, summary.usersPenalized, summary.creditDeducted,
+         summary.durationMs, summary.rowsPerSecond, today}));
+
+    if(!ok || dryRun) {
+        db->rollback();
+        summary.ok = ok;
+        return summary;
+    }
+    if(!db->commit()) return summary;
+
+    if(summary.usersPenalized > 0) {
+        EntityCache::instance()->invalidateAllUsers();
+    }
+
+    summary.ok = true;
+    qDebug() << "Overdue run" << today.toString("yyyy-MM-dd") << ":"
+             << summary.overdueLoans << "overdue," << summary.severeLoans << "severe,"
+             << summary.usersPenalized << "users penalized in" << summary.durationMs << "ms ("
+             << summary.rowsPerSecond << "rows/s)";
+    return summary;
+}
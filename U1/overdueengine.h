@@ -0,0 +1,34 @@
+// include/overdueengine.h
+#ifndef OVERDUEENGINE_H
+#define OVERDUEENGINE_H
+
+#include <QDate>
+
+// 逾期处理：整批 SQL 完成，不逐行查用户、不逐行提示，在工作线程执行
+// 每天只处理一次：先在 OverdueRuns 表中占住当天的行，与处理本身在同一事务中；
+// 多个客户端同时启动时只有一个会真正执行，其余看到当天已处理直接跳过。
+class OverdueEngine
+{
+public:
+    struct RunSummary {
+        QDate runDate;
+        bool ok;
+        bool skipped;        // 当天已处理过
+        int overdueLoans;    // 逾期未还的借阅
+        int severeLoans;     // 逾期超过30天的借阅
+        int usersPenalized;  // 被扣信用分的读者数
+        int creditDeducted;  // 扣除的信用分合计
+        qint64 durationMs;
+        double rowsPerSecond;
+        RunSummary();
+    };
+
+    static const int SevereOverdueDays = 30;
+    static const int SevereCreditPenalty = 5;
+    static constexpr double FinePerDay = 0.5;
+
+    // dryRun：不占用当天、完整执行后回滚，用于压测和预览，不改变任何数据
+    static RunSummary run(const QDate &today, bool dryRun = false);
+};
+
+#endif // OVERDUEENGINE_H
@@ -0,0 +1,218 @@
+// src/records.cpp
+#include "records.h"
+#include <QVariant>
+
+RecordSpan RecordArena::store(const QString &value)
+{
+    RecordSpan span;
+    span.offset = m_text.size();
+    span.length = value.size();
+    m_text.append(value);
+    return span;
+}
+
+QString RecordArena::string(const RecordSpan &span) const
+{
+    return m_text.mid(span.offset, span.length);
+}
+
+void RecordArena::squeeze()
+{
+    m_text.squeeze();
+}
+
+// ---- BookRecord ----
+
+BookRecord::BookRecord()
+    : m_index(-1)
+{
+}
+
+BookRecord::BookRecord(const QExplicitlySharedDataPointer<BookArena> &arena, int index)
+    : m_arena(arena), m_index(index)
+{
+}
+
+bool BookRecord::isNull() const
+{
+    return !m_arena;
+}
+
+const BookRow &BookRecord::row() const
+{
+    return m_arena->rows.at(m_index);
+}
+
+QString BookRecord::isbn() const {
+    return isNull() ? QString() : m_arena->string(row().isbn);
+}
+
+QString BookRecord::title() const {
+    return isNull() ? QString() : m_arena->string(row().title);
+}
+
+QString BookRecord::author() const {
+    return isNull() ? QString() : m_arena->string(row().author);
+}
+
+QString BookRecord::publisher() const {
+    return isNull() ? QString() : m_arena->string(row().publisher);
+}
+
+QDate BookRecord::publishDate() const {
+    return isNull() ? QDate() : row().publishDate;
+}
+
+double BookRecord::price() const {
+    return isNull() ? 0.0 : row().price;
+}
+
+QString BookRecord::introduction() const {
+    return isNull() ? QString() : m_arena->string(row().introduction);
+}
+
+int BookRecord::totalCopies() const {
+    return isNull() ? 0 : row().totalCopies;
+}
+
+int BookRecord::availableCopies() const {
+    return isNull() ? 0 : row().availableCopies;
+}
+
+Book::RatingStats BookRecord::ratingStats() const {
+    return isNull() ? Book::RatingStats() : row().ratingStats;
+}
+
+// ---- UserRecord ----
+
+UserRecord::UserRecord()
+    : m_index(-1)
+{
+}
+
+UserRecord::UserRecord(const QExplicitlySharedDataPointer<UserArena> &arena, int index)
+    : m_arena(arena), m_index(index)
+{
+}
+
+bool UserRecord::isNull() const
+{
+    return !m_arena;
+}
+
+const UserRow &UserRecord::row() const
+{
+    return m_arena->rows.at(m_index);
+}
+
+QString UserRecord::id() const {
+    return isNull() ? QString() : m_arena->string(row().id);
+}
+
+QString UserRecord::email() const {
+    return isNull() ? QString() : m_arena->string(row().email);
+}
+
+QString UserRecord::name() const {
+    return isNull() ? QString() : m_arena->string(row().name);
+}
+
+User::UserType UserRecord::type() const {
+    return isNull() ? User::Normal : row().type;
+}
+
+float UserRecord::readingHours() const {
+    return isNull() ? 0.0f : row().readingHours;
+}
+
+double UserRecord::fines() const {
+    return isNull() ? 0.0 : row().fines;
+}
+
+int UserRecord::creditScore() const {
+    return isNull() ? 0 : row().creditScore;
+}
+
+bool UserRecord::hadLowCredit() const {
+    return isNull() ? false : row().hadLowCredit;
+}
+
+// ---- 构造器 ----
+
+BookRecordBuilder::BookRecordBuilder(int expectedRows)
+    : m_arena(new BookArena)
+{
+    if(expectedRows > 0) m_arena->rows.reserve(expectedRows);
+}
+
+void BookRecordBuilder::append(const QSqlRecord &record)
+{
+    BookRow row;
+    row.isbn = m_arena->store(record.value("ISBN").toString());
+    row.title = m_arena->store(record.value("Title").toString());
+    row.author = m_arena->store(record.value("Author").toString());
+    row.publisher = m_arena->store(record.value("Publisher").toString());
+    row.introduction = m_arena->store(record.value("Introduction").toString());
+    row.publishDate = record.value("PublishDate").toDate();
+    row.price = record.value("Price").toDouble();
+    row.totalCopies = record.value("TotalCopies").toInt();
+    row.availableCopies = record.value("AvailableCopies").toInt();
+
+    // 联查了 BookRatingStats 时顺带带回评分汇总
+    if(record.contains("RatingCount")) {
+        row.ratingStats.count = record.value("RatingCount").toInt();
+        row.ratingStats.sum = record.value("RatingSum").toInt();
+        for(int i = 0; i < 5; ++i) {
+            row.ratingStats.histogram[i] = record.value(QString("Rating%1").arg(i + 1)).toInt();
+        }
+    }
+    m_arena->rows.append(row);
+}
+
+BookRecordList BookRecordBuilder::finish()
+{
+    m_arena->squeeze();
+    m_arena->rows.squeeze();
+
+    BookRecordList records;
+    records.reserve(m_arena->rows.size());
+    for(int i = 0; i < m_arena->rows.size(); ++i) {
+        records.append(BookRecord(m_arena, i));
+    }
+    m_arena = new BookArena;
+    return records;
+}
+
+UserRecordBuilder::UserRecordBuilder(int expectedRows)
+    : m_arena(new UserArena)
+{
+    if(expectedRows > 0) m_arena->rows.reserve(expectedRows);
+}
+
+void UserRecordBuilder::append(const QSqlRecord &record)
+{
+    UserRow row;
+    row.id = m_arena->store(record.value("UserID").toString());
+    row.email = m_arena->store(record.value("Email").toString());
+    row.name = m_arena->store(record.value("Name").toString());
+    row.type = record.value("Type").toString() == "Super" ? User::Super : User::Normal;
+    row.readingHours = record.value("TotalReadingHours").toFloat();
+    row.fines = record.value("Fines").toDouble();
+    row.creditScore = record.value("CreditScore").toInt();
+    row.hadLowCredit = record.value("HadLowCredit").toBool();
+    m_arena->rows.append(row);
+}
+
+UserRecordList UserRecordBuilder::finish()
+{
+    m_arena->squeeze();
+    m_arena->rows.squeeze();
+
+    UserRecordList records;
+    records.reserve(m_arena->rows.size());
+    for(int i = 0; i < m_arena->rows.size(); ++i) {
+        records.append(UserRecord(m_arena, i));
+    }
+    m_arena = new UserArena;
+    return records;
+}
@@ -0,0 +1,149 @@
+// include/records.h
+#ifndef RECORDS_H
+#define RECORDS_H
+
+#include <QString>
+#include <QDate>
+#include <QVector>
+#include <QSharedData>
+#include <QExplicitlySharedDataPointer>
+#include <QSqlRecord>
+#include "book.h"
+#include "user.h"
+
+// 查询结果的值类型
+// 一次查询的所有行放在同一个 arena 里：字符串字段首尾相接存进一个缓冲区，各行只记偏移。
+// 记录对象只是"arena 引用 + 行号"，拷贝和移动都很廉价；最后一个引用释放时整块内存一起归还。
+
+struct RecordSpan {
+    int offset;
+    int length;
+};
+
+class RecordArena : public QSharedData
+{
+public:
+    RecordSpan store(const QString &value);
+    QString string(const RecordSpan &span) const;
+    void squeeze();
+
+private:
+    QString m_text;
+};
+
+struct BookRow {
+    RecordSpan isbn;
+    RecordSpan title;
+    RecordSpan author;
+    RecordSpan publisher;
+    RecordSpan introduction;
+    QDate publishDate;
+    double price;
+    int totalCopies;
+    int availableCopies;
+    Book::RatingStats ratingStats;
+};
+
+struct UserRow {
+    RecordSpan id;
+    RecordSpan email;
+    RecordSpan name;
+    User::UserType type;
+    float readingHours;
+    double fines;
+    int creditScore;
+    bool hadLowCredit;
+};
+
+class BookArena : public RecordArena
+{
+public:
+    QVector<BookRow> rows;
+};
+
+class UserArena : public RecordArena
+{
+public:
+    QVector<UserRow> rows;
+};
+
+class BookRecord
+{
+public:
+    BookRecord();
+
+    bool isNull() const;
+    QString isbn() const;
+    QString title() const;
+    QString author() const;
+    QString publisher() const;
+    QDate publishDate() const;
+    double price() const;
+    QString introduction() const;
+    int totalCopies() const;
+    int availableCopies() const;
+    Book::RatingStats ratingStats() const;
+
+private:
+    friend class BookRecordBuilder;
+    BookRecord(const QExplicitlySharedDataPointer<BookArena> &arena, int index);
+    const BookRow &row() const;
+
+    QExplicitlySharedDataPointer<BookArena> m_arena;
+    int m_index;
+};
+Q_DECLARE_TYPEINFO(BookRecord, Q_MOVABLE_TYPE);
+
+// 列表里的用户不带密码
+class UserRecord
+{
+public:
+    UserRecord();
+
+    bool isNull() const;
+    QString id() const;
+    QString email() const;
+    QString name() const;
+    User::UserType type() const;
+    float readingHours() const;
+    double fines() const;
+    int creditScore() const;
+    bool hadLowCredit() const;
+
+private:
+    friend class UserRecordBuilder;
+    UserRecord(const QExplicitlySharedDataPointer<UserArena> &arena, int index);
+    const UserRow &row() const;
+
+    QExplicitlySharedDataPointer<UserArena> m_arena;
+    int m_index;
+};
+Q_DECLARE_TYPEINFO(UserRecord, Q_MOVABLE_TYPE);
+
+typedef QVector<BookRecord> BookRecordList;
+typedef QVector<UserRecord> UserRecordList;
+
+// 逐行追加查询结果，finish() 之后 arena 不再改动
+class BookRecordBuilder
+{
+public:
+    explicit BookRecordBuilder(int expectedRows = 0);
+    void append(const QSqlRecord &record);
+    BookRecordList finish();
+
+private:
+    QExplicitlySharedDataPointer<BookArena> m_arena;
+};
+
+class UserRecordBuilder
+{
+public:
+    explicit UserRecordBuilder(int expectedRows = 0);
+    void append(const QSqlRecord &record);
+    UserRecordList finish();
+
+private:
+    QExplicitlySharedDataPointer<UserArena> m_arena;
+};
+
+#endif // RECORDS_H
@@ -0,0 +1,121 @@
+// include/recordstream.h
+#ifndef RECORDSTREAM_H
+#define RECORDSTREAM_H
+
+#include <QVector>
+#include <QVariant>
+#include <QSharedPointer>
+#include <functional>
+#include <iterator>
+
+// 惰性分块的查询结果：迭代到当前块末尾时才读下一块，任何时候只持有一块。
+// loader(afterKey, limit, rows, nextKey) 读出 afterKey 之后最多 limit 行，并把续读的键写到 nextKey；
+// 没有更多数据时 nextKey 留空。中途 break 即提前结束，不会再查询数据库。
+// 拷贝共享同一个读取位置，只能遍历一次。
+template<typename T>
+class RecordStream
+{
+public:
+    typedef std::function<bool(const QVariant &afterKey, int limit,
+                               QVector<T> *rows, QVariant *nextKey)> ChunkLoader;
+
+private:
+    struct State {
+        ChunkLoader loader;
+        QVariant key;
+        int fetchSize;
+        QVector<T> rows;
+        int index;
+        bool started;
+        bool exhausted;
+        bool failed;
+        qint64 fetched;
+
+        void fetch() {
+            rows.clear();
+            index = 0;
+            // 一块可能为空但仍有后续（例如按 ISBN 列表取书时整块都已被删除）
+            while(rows.isEmpty() && !exhausted) {
+                QVariant next;
+                if(!loader(key, fetchSize, &rows, &next)) {
+                    failed = true;
+                    exhausted = true;
+                    rows.clear();
+                    return;
+                }
+                fetched += rows.size();
+                exhausted = !next.isValid();
+                key = next;
+            }
+        }
+        void start() {
+            if(started) return;
+            started = true;
+            fetch();
+        }
+        void advance() {
+            if(++index >= rows.size()) fetch();
+        }
+        bool atEnd() const {
+            return index >= rows.size();
+        }
+    };
+
+public:
+    class const_iterator
+    {
+    public:
+        typedef std::input_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T *pointer;
+        typedef const T &reference;
+
+        const T &operator*() const { return m_state->rows.at(m_state->index); }
+        const T *operator->() const { return &m_state->rows.at(m_state->index); }
+        const_iterator &operator++() {
+            m_state->advance();
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return atEnd() == other.atEnd(); }
+        bool operator!=(const const_iterator &other) const { return atEnd() != other.atEnd(); }
+
+    private:
+        friend class RecordStream;
+        explicit const_iterator(State *state) : m_state(state) {}
+        bool atEnd() const { return !m_state || m_state->atEnd(); }
+
+        State *m_state;
+    };
+
+    RecordStream(const ChunkLoader &loader, const QVariant &firstKey, int fetchSize)
+        : d(new State)
+    {
+        d->loader = loader;
+        d->key = firstKey;
+        d->fetchSize = qMax(1, fetchSize);
+        d->index = 0;
+        d->started = false;
+        d->exhausted = false;
+        d->failed = false;
+        d->fetched = 0;
+    }
+
+    const_iterator begin() const {
+        d->start();
+        return const_iterator(d.data());
+    }
+    const_iterator end() const {
+        return const_iterator(nullptr);
+    }
+
+    // 某一块查询失败时遍历提前结束，调用方据此区分"读完了"和"出错了"
+    bool failed() const { return d->failed; }
+    // 到目前为止从数据库读出的行数
+    qint64 fetchedRows() const { return d->fetched; }
+
+private:
+    QSharedPointer<State> d;
+};
+
+#endif // RECORDSTREAM_H
@@ -0,0 +1,425 @@
+// src/reservationqueue.cpp
+#include "reservationqueue.h"
+#include "database.h"
+#include "storagebackend.h"
+#include "entitycache.h"
+#include <QSqlQuery>
+#include <QDebug>
+#include <QtConcurrent>
+
+ReservationQueue::SweepSummary::SweepSummary()
+    : ok(false), expired(0), promoted(0), pending(0), ready(0)
+{
+}
+
+ReservationQueue::Change::Change(Kind kind, int id)
+    : kind(kind), id(id)
+{
+}
+
+ReservationQueue::ReservationQueue() : m_loading(0)
+{
+}
+
+ReservationQueue* ReservationQueue::instance()
+{
+    static ReservationQueue *instance = new ReservationQueue();
+    return instance;
+}
+
+QString ReservationQueue::readerKey(const QString &userId, const QString &isbn)
+{
+    return userId + QLatin1Char('\n') + isbn;
+}
+
+// 在锁外读完全部行再整体换入，加载期间查询照常使用旧镜像
+bool ReservationQueue::load()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_loading++;
+    }
+
+    QSqlQuery q(Database::instance()->connection());
+    q.setForwardOnly(true);
+    if(!q.exec("SELECT ReservationID, UserID, ISBN, Priority, Status, PickupDeadline "
+               "FROM Reservations WHERE Status IN ('Pending', 'Ready')")) {
+        qDebug() << "Load reservations failed";
+        finishLoad();
+        return false;
+    }
+
+    QList<QPair<int, Hold> > rows;
+    while(q.next()) {
+        Hold hold;
+        hold.userId = q.value(1).toString();
+        hold.isbn = q.value(2).toString();
+        hold.priority = q.value(3).toInt();
+        hold.ready = q.value(4).toString() == "Ready";
+        hold.deadline = q.value(5).toDateTime();
+        rows.append(qMakePair(q.value(0).toInt(), hold));
+    }
+    q.finish();
+
+    QMutexLocker lock(&m_mutex);
+    m_holds.clear();
+    m_queues.clear();
+    m_deadlines.clear();
+    m_byReader.clear();
+    for(int i = 0; i < rows.size(); ++i) {
+        insertLocked(rows.at(i).first, rows.at(i).second);
+    }
+    foreach (const Change &change, m_pending) {
+        applyLocked(change);
+    }
+    if(--m_loading == 0) m_pending.clear();
+    return true;
+}
+
+QFuture<bool> ReservationQueue::loadAsync(QThreadPool *pool)
+{
+    return QtConcurrent::run(pool, [this]() { return load(); });
+}
+
+void ReservationQueue::finishLoad()
+{
+    QMutexLocker lock(&m_mutex);
+    if(--m_loading == 0) m_pending.clear();
+}
+
+void ReservationQueue::changeLocked(const Change &change)
+{
+    applyLocked(change);
+    if(m_loading > 0) m_pending.append(change);
+}
+
+void ReservationQueue::applyLocked(const Change &change)
+{
+    switch(change.kind) {
+    case Change::Insert:
+        if(!m_holds.contains(change.id)) insertLocked(change.id, change.hold);
+        break;
+    case Change::Remove:
+        removeLocked(change.id);
+        break;
+    case Change::Ready:
+        markReadyLocked(change.id, change.deadline);
+        break;
+    case Change::Fulfilled: {
+        auto it = m_byReader.constFind(readerKey(change.userId, change.isbn));
+        if(it == m_byReader.constEnd()) break;
+        int id = it.value();
+        if(m_holds.value(id).ready) removeLocked(id);
+        break;
+    }
+    case Change::RemoveTitle: {
+        QList<int> ids;
+        for(auto it = m_holds.constBegin(); it != m_holds.constEnd(); ++it) {
+            if(it.value().isbn == change.isbn) ids << it.key();
+        }
+        foreach (int id, ids) {
+            removeLocked(id);
+        }
+        break;
+    }
+    }
+}
+
+void ReservationQueue::insertLocked(int id, const Hold &hold)
+{
+    m_holds.insert(id, hold);
+    m_byReader.insert(readerKey(hold.userId, hold.isbn), id);
+    if(hold.ready) {
+        m_deadlines.insert(qMakePair(hold.deadline, id), id);
+    } else {
+        m_queues[hold.isbn].insert({hold.priority, id}, id);
+    }
+}
+
+void ReservationQueue::removeLocked(int id)
+{
+    auto it = m_holds.find(id);
+    if(it == m_holds.end()) return;
+    const Hold &hold = it.value();
+    m_byReader.remove(readerKey(hold.userId, hold.isbn));
+    if(hold.ready) {
+        m_deadlines.remove(qMakePair(hold.deadline, id));
+    } else {
+        auto queue = m_queues.find(hold.isbn);
+        if(queue != m_queues.end()) {
+            queue.value().remove({hold.priority, id});
+            if(queue.value().isEmpty()) m_queues.erase(queue);
+        }
+    }
+    m_holds.erase(it);
+}
+
+// 队首出队、进入到期索引，都是 O(log n)；别的客户端新建、内存里还没有的预约跳过，下次加载时补上
+void ReservationQueue::markReadyLocked(int id, const QDateTime &deadline)
+{
+    auto it = m_holds.find(id);
+    if(it == m_holds.end() || it.value().ready) return;
+    Hold hold = it.value();
+    removeLocked(id);
+    hold.ready = true;
+    hold.deadline = deadline;
+    insertLocked(id, hold);
+}
+
+int ReservationQueue::reserve(const QString &userId, const QString &isbn)
+{
+    Database *db = Database::instance();
+    if(!db->transaction()) return -1;
+
+    QSqlRecord existing = db->executePreparedRow("reservation.existing",
+        "SELECT 1 FROM Reservations WHERE UserID = ? AND ISBN = ? AND Status IN ('Pending', 'Ready')",
+        {userId, isbn});
+    QSqlRecord user = db->executePreparedRow("reservation.user",
+        "SELECT Type FROM Users WHERE UserID = ?", {userId});
+    if(!existing.isEmpty() || user.isEmpty()) {
+        db->rollback();
+        return -1;
+    }
+    int priority = user.value(0).toString() == "Super" ? 1 : 0;
+
+    int id = -1;
+    QList<Promotion> promoted;
+    bool ok = db->executePrepared("reservation.insert",
+        "INSERT INTO Reservations (UserID, ISBN, ReserveDate, Status, Priority) VALUES (?, ?, ?, 'Pending', ?)",
+        {userId, isbn, QDateTime::currentDateTime(), priority});
+    if(ok) {
+        QSqlRecord inserted = db->executePreparedRow("reservation.inserted",
+            "SELECT MAX(ReservationID) FROM Reservations WHERE UserID = ? AND ISBN = ?", {userId, isbn});
+        if(!inserted.isEmpty()) id = inserted.value(0).toInt();
+        ok = id > 0 && promoteWaiting(isbn, &promoted);
+    }
+    if(!ok || !db->commit()) {
+        db->rollback();
+        return -1;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        Change change(Change::Insert, id);
+        change.hold = {userId, isbn, priority, false, QDateTime()};
+        changeLocked(change);
+    }
+    applyPromotions(promoted);
+    if(!promoted.isEmpty()) EntityCache::instance()->invalidateBook(isbn);
+    return id;
+}
+
+bool ReservationQueue::cancel(const QString &userId, const QString &isbn)
+{
+    Database *db = Database::instance();
+    if(!db->transaction()) return false;
+
+    QSqlRecord q = db->executePreparedRow("reservation.active",
+        QString("SELECT ReservationID, Status FROM Reservations "
+                "WHERE UserID = ? AND ISBN = ? AND Status IN ('Pending', 'Ready')%1")
+            .arg(db->backend()->forUpdate()),
+        {userId, isbn});
+    if(q.isEmpty()) {
+        db->rollback();
+        return false;
+    }
+    int id = q.value(0).toInt();
+    bool wasReady = q.value(1).toString() == "Ready";
+
+    QList<Promotion> promoted;
+    bool ok = db->executePrepared("reservation.cancel",
+        "UPDATE Reservations SET Status = 'Cancelled' WHERE ReservationID = ?", {id});
+    if(ok && wasReady) ok = allocateReturned(isbn, 1, &promoted);
+    if(!ok || !db->commit()) {
+        db->rollback();
+        return false;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        changeLocked(Change(Change::Remove, id));
+    }
+    applyPromotions(promoted);
+    if(wasReady) EntityCache::instance()->invalidateBook(isbn);
+    return true;
+}
+
+// 按到期时间索引 (Status, PickupDeadline) 取出到期的保留，不扫整张表
+ReservationQueue::SweepSummary ReservationQueue::expireHolds(const QDateTime &now)
+{
+    SweepSummary summary;
+    Database *db = Database::instance();
+    if(!db->transaction()) return summary;
+
+    QSqlQuery due = db->executePreparedQuery("reservation.due",
+        QString("SELECT ReservationID, ISBN FROM Reservations "
+                "WHERE Status = 'Ready' AND PickupDeadline < ? ORDER BY PickupDeadline%1")
+            .arg(db->backend()->forUpdate()),
+        {now});
+    QList<int> expired;
+    QMap<QString, int> freed;   // ISBN -> 空出的副本数
+    while(due.next()) {
+        expired << due.value(0).toInt();
+        freed[due.value(1).toString()]++;
+    }
+
+    bool ok = true;
+    foreach (int id, expired) {
+        ok = ok && db->executePrepared("reservation.expire",
+            "UPDATE Reservations SET Status = 'Expired' WHERE ReservationID = ?", {id});
+    }
+    QList<Promotion> promoted;
+    for(auto it = freed.constBegin(); ok && it != freed.constEnd(); ++it) {
+        ok = allocateReturned(it.key(), it.value(), &promoted);
+    }
+    if(!ok || !db->commit()) {
+        db->rollback();
+        return summary;
+    }
+
+    for(auto it = freed.constBegin(); it != freed.constEnd(); ++it) {
+        EntityCache::instance()->invalidateBook(it.key());
+    }
+    summary.ok = true;
+    summary.expired = expired.size();
+    summary.promoted = promoted.size();
+
+    // 只把这次扫描的变化应用到镜像，不重新加载全部预约
+    QMutexLocker lock(&m_mutex);
+    foreach (int id, expired) {
+        changeLocked(Change(Change::Remove, id));
+    }
+    foreach (const Promotion &promotion, promoted) {
+        Change change(Change::Ready, promotion.reservationId);
+        change.deadline = promotion.deadline;
+        changeLocked(change);
+    }
+    summary.ready = m_deadlines.size();
+    summary.pending = m_holds.size() - summary.ready;
+    return summary;
+}
+
+bool ReservationQueue::promoteWaiting(const QString &isbn, QList<Promotion> *promoted)
+{
+    Database *db = Database::instance();
+    QSqlRecord book = db->executePreparedRow("reservation.available",
+        QString("SELECT AvailableCopies FROM Books WHERE ISBN = ?%1").arg(db->backend()->forUpdate()),
+        {isbn});
+    if(book.isEmpty()) return false;
+    int available = book.value(0).toInt();
+    if(available <= 0) return true;
+
+    int before = promoted->size();
+    if(!promote(isbn, available, promoted)) return false;
+    int taken = promoted->size() - before;
+    if(taken == 0) return true;
+    return db->executePrepared("reservation.take",
+        "UPDATE Books SET AvailableCopies = AvailableCopies - ? WHERE ISBN = ?", {taken, isbn});
+}
+
+bool ReservationQueue::allocateReturned(const QString &isbn, int copies, QList<Promotion> *promoted)
+{
+    int before = promoted->size();
+    if(!promote(isbn, copies, promoted)) return false;
+    int rest = copies - (promoted->size() - before);
+    if(rest == 0) return true;
+    return Database::instance()->executePrepared("reservation.restock",
+        "UPDATE Books SET AvailableCopies = AvailableCopies + ? "
+        "WHERE ISBN = ? AND AvailableCopies + ? <= TotalCopies", {rest, isbn, rest});
+}
+
+// 取队首 copies 条排队中的预约改为 Ready
+bool ReservationQueue::promote(const QString &isbn, int copies, QList<Promotion> *promoted)
+{
+    Database *db = Database::instance();
+    QSqlQuery heads = db->executePreparedQuery("reservation.heads",
+        QString("SELECT ReservationID FROM Reservations WHERE ISBN = ? AND Status = 'Pending' "
+                "ORDER BY Priority DESC, ReservationID LIMIT ?%1").arg(db->backend()->forUpdate()),
+        {isbn, copies});
+    QList<int> ids;
+    while(heads.next()) {
+        ids << heads.value(0).toInt();
+    }
+
+    QDateTime now = QDateTime::currentDateTime();
+    QDateTime deadline = now.addDays(PickupDays);
+    foreach (int id, ids) {
+        if(!db->executePrepared("reservation.ready",
+                "UPDATE Reservations SET Status = 'Ready', ReadyAt = ?, PickupDeadline = ? "
+                "WHERE ReservationID = ?", {now, deadline, id})) {
+            return false;
+        }
+        promoted->append({id, deadline});
+    }
+    return true;
+}
+
+void ReservationQueue::applyPromotions(const QList<Promotion> &promoted)
+{
+    QMutexLocker lock(&m_mutex);
+    foreach (const Promotion &promotion, promoted) {
+        Change change(Change::Ready, promotion.reservationId);
+        change.deadline = promotion.deadline;
+        changeLocked(change);
+    }
+}
+
+void ReservationQueue::fulfilled(const QString &userId, const QString &isbn)
+{
+    QMutexLocker lock(&m_mutex);
+    Change change(Change::Fulfilled);
+    change.userId = userId;
+    change.isbn = isbn;
+    changeLocked(change);
+}
+
+void ReservationQueue::removeTitle(const QString &isbn)
+{
+    QMutexLocker lock(&m_mutex);
+    Change change(Change::RemoveTitle);
+    change.isbn = isbn;
+    changeLocked(change);
+}
+
+int ReservationQueue::position(const QString &userId, const QString &isbn) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_byReader.constFind(readerKey(userId, isbn));
+    if(it == m_byReader.constEnd()) return 0;
+    const Hold hold = m_holds.value(it.value());
+    if(hold.ready) return 0;
+
+    const QMap<QueueKey, int> queue = m_queues.value(isbn);
+    int rank = 1;
+    for(auto q = queue.constBegin(); q != queue.constEnd(); ++q, ++rank) {
+        if(q.value() == it.value()) return rank;
+    }
+    return 0;
+}
+
+QDateTime ReservationQueue::pickupDeadline(const QString &userId, const QString &isbn) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = m_byReader.constFind(readerKey(userId, isbn));
+    if(it == m_byReader.constEnd()) return QDateTime();
+    const Hold hold = m_holds.value(it.value());
+    return hold.ready ? hold.deadline : QDateTime();
+}
+
+int ReservationQueue::pendingCount(const QString &isbn) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_queues.value(isbn).size();
+}
+
+int ReservationQueue::readyCount() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_deadlines.size();
+}
+
+QDateTime ReservationQueue::nextDeadline() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_deadlines.isEmpty() ? QDateTime() : m_deadlines.firstKey().first;
+}
@@ -0,0 +1,126 @@
+// include/reservationqueue.h
+#ifndef RESERVATIONQUEUE_H
+#define RESERVATIONQUEUE_H
+
+#include <QString>
+#include <QDateTime>
+#include <QHash>
+#include <QMap>
+#include <QList>
+#include <QMutex>
+#include <QFuture>
+#include <QThreadPool>
+
+// 预约排队
+// 每本书一个队列：Super 读者优先，同优先级按预约先后（ReservationID）。有副本空出来时
+// （归还、新增副本、保留过期、取消已保留的预约）在同一个事务里分给队首，预约变为 Ready，
+// 副本不计入可借数，读者在取书期限内借书时直接借走这一册（见借阅存储过程）。
+// 数据库是准绳：分配都在事务里按 (ISBN, Status, Priority, ReservationID) 索引取队首。
+// 内存里另有一份镜像用于查询排队位置和到期时间，启动时在后台加载，加载期间本进程的改动先记下，
+// 换入后重放。之后按本进程的预约、取消、分配和到期扫描增量更新：扫描从数据库取出所有到期的保留，
+// 其他客户端的保留到期也会移出；其他客户端新建的预约在下次启动加载时出现。
+class ReservationQueue
+{
+public:
+    static const int PickupDays = 3;    // 保留副本的取书期限
+
+    struct Promotion {
+        int reservationId;
+        QDateTime deadline;
+    };
+
+    struct SweepSummary {
+        bool ok;
+        int expired;    // 过期的保留
+        int promoted;   // 转给下一位的副本
+        int pending;    // 扫描后仍在排队的预约
+        int ready;      // 扫描后保留中的副本
+        SweepSummary();
+    };
+
+    static ReservationQueue* instance();
+
+    // 从数据库加载全部 Pending / Ready 预约
+    bool load();
+    // 在 pool 上后台加载
+    QFuture<bool> loadAsync(QThreadPool *pool);
+
+    // 预约：成功返回预约编号，失败或已在排队返回 -1。有可借副本时立即保留给他
+    int reserve(const QString &userId, const QString &isbn);
+    // 取消排队或已保留的预约；已保留的副本转给下一位
+    bool cancel(const QString &userId, const QString &isbn);
+    // 保留过期：按到期时间索引取出到期的 Ready 预约，副本转给下一位或放回可借；镜像只应用这些变化
+    SweepSummary expireHolds(const QDateTime &now);
+
+    // 以下两个在调用方的事务里执行，只改数据库；提交后调用 applyPromotions 同步内存
+    // 把该书当前的可借副本分给排队读者
+    static bool promoteWaiting(const QString &isbn, QList<Promotion> *promoted);
+    // copies 册副本空出：先分给队首，剩余的放回可借
+    static bool allocateReturned(const QString &isbn, int copies, QList<Promotion> *promoted);
+
+    void applyPromotions(const QList<Promotion> &promoted);
+    // 读者借走了为他保留的副本
+    void fulfilled(const QString &userId, const QString &isbn);
+    // 图书已删除，其预约已在删书事务里取消
+    void removeTitle(const QString &isbn);
+
+    // 排队位置（从1开始），不在排队中返回0
+    int position(const QString &userId, const QString &isbn) const;
+    // 为该读者保留的副本的取书期限，没有时返回无效时间
+    QDateTime pickupDeadline(const QString &userId, const QString &isbn) const;
+    int pendingCount(const QString &isbn) const;
+    int readyCount() const;
+    QDateTime nextDeadline() const;
+
+private:
+    ReservationQueue();
+
+    // 队列顺序：优先级高的在前，同优先级按编号
+    struct QueueKey {
+        int priority;
+        int id;
+        bool operator<(const QueueKey &other) const {
+            return priority != other.priority ? priority > other.priority : id < other.id;
+        }
+    };
+
+    struct Hold {
+        QString userId;
+        QString isbn;
+        int priority;
+        bool ready;
+        QDateTime deadline;
+    };
+
+    // 对镜像的一次改动；加载期间同时记下，换入新镜像后重放。重放加载已读到的改动不会重复生效
+    struct Change {
+        enum Kind { Insert, Remove, Ready, Fulfilled, RemoveTitle };
+        Kind kind;
+        int id;
+        Hold hold;              // Insert
+        QDateTime deadline;     // Ready
+        QString userId;         // Fulfilled
+        QString isbn;           // Fulfilled、RemoveTitle
+        explicit Change(Kind kind, int id = 0);
+    };
+
+    static bool promote(const QString &isbn, int copies, QList<Promotion> *promoted);
+    static QString readerKey(const QString &userId, const QString &isbn);
+
+    void changeLocked(const Change &change);
+    void applyLocked(const Change &change);
+    void finishLoad();
+    void insertLocked(int id, const Hold &hold);
+    void removeLocked(int id);
+    void markReadyLocked(int id, const QDateTime &deadline);
+
+    mutable QMutex m_mutex;
+    QHash<int, Hold> m_holds;
+    QHash<QString, QMap<QueueKey, int> > m_queues;  // ISBN -> 排队中的预约
+    QMap<QPair<QDateTime, int>, int> m_deadlines;   // 保留中的预约，按取书期限排序
+    QHash<QString, int> m_byReader;                 // 读者+ISBN -> 预约编号
+    int m_loading;                                  // 进行中的全量加载数
+    QList<Change> m_pending;                        // 加载期间的改动
+};
+
+#endif // RESERVATIONQUEUE_H
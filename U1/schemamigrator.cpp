@@ -0,0 +1,109 @@
+// src/schemamigrator.cpp
+#include "schemamigrator.h"
+#include "database.h"
+#include "storagebackend.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QElapsedTimer>
+#include <QDebug>
+
+// 这些错误说明语句要做的改动已经存在（旧库或上次迁移中途失败，DDL 已隐式提交）
+static bool isAlreadyApplied(const QSqlError &error)
+{
+    QString code = error.nativeErrorCode();
+    return code == "1050"    // Table already exists
+        || code == "1060"    // Duplicate column name
+        || code == "1061";   // Duplicate key name
+}
+
+SchemaMigrator::SchemaMigrator(Database *db) : m_db(db)
+{
+}
+
+const QVector<SchemaMigrator::Migration> &SchemaMigrator::migrations() const
+{
+    return m_db->backend()->migrations();
+}
+
+bool SchemaMigrator::ensureVersionTable()
+{
+    return m_db->execute(
+        "CREATE TABLE IF NOT EXISTS SchemaVersion ("
+        "   Version INT PRIMARY KEY,"
+        "   Description VARCHAR(100) NOT NULL,"
+        "   AppliedAt DATETIME NOT NULL,"
+        "   DurationMs INT NOT NULL DEFAULT 0"
+        ")");
+}
+
+int SchemaMigrator::currentVersion()
+{
+    QSqlQuery q = m_db->executeQuery("SELECT COALESCE(MAX(Version), 0) FROM SchemaVersion");
+    if(!q.next()) return -1;
+    return q.value(0).toInt();
+}
+
+bool SchemaMigrator::migrate()
+{
+    if(!ensureVersionTable()) return false;
+
+    const QVector<Migration> &list = migrations();
+    int version = currentVersion();
+    if(version < 0) return false;
+    if(version >= list.last().version) return true;
+
+    // 拿到锁后重新读取版本，别的客户端可能刚刚迁移完
+    if(!m_db->backend()->lockSchema()) {
+        qDebug() << "Schema migration: could not acquire migration lock";
+        return false;
+    }
+
+    bool ok = true;
+    version = currentVersion();
+    for(int i = 0; i < list.size() && ok; ++i) {
+        if(list[i].version <= version) continue;
+        ok = apply(list[i]);
+    }
+
+    m_db->backend()->unlockSchema();
+    return ok;
+}
+
+bool SchemaMigrator::apply(const Migration &migration)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    if(!m_db->transaction()) return false;
+
+    QSqlDatabase db = m_db->connection();
+    foreach (const QString &sql, migration.statements) {
+        QSqlQuery q(db);
+        if(q.exec(sql)) continue;
+        if(isAlreadyApplied(q.lastError())) {
+            qDebug() << "Schema migration" << migration.version << "already applied, skipping:" << sql;
+            continue;
+        }
+        qDebug() << "Schema migration" << migration.version << "failed:" << q.lastError().text();
+        qDebug() << "Query:" << sql;
+        m_db->rollback();
+        return false;
+    }
+
+    QSqlQuery record(db);
+    record.prepare(QString("INSERT INTO SchemaVersion (Version, Description, AppliedAt, DurationMs) "
+                           "VALUES (?, ?, %1, ?)").arg(m_db->backend()->now()));
+    record.addBindValue(migration.version);
+    record.addBindValue(migration.description);
+    record.addBindValue(static_cast<int>(timer.elapsed()));
+    if(!record.exec()) {
+        qDebug() << "Schema migration" << migration.version << "could not be recorded:" << record.lastError().text();
+        m_db->rollback();
+        return false;
+    }
+
+    if(!m_db->commit()) return false;
+    qDebug() << "Schema migration" << migration.version << migration.description
+             << "applied in" << timer.elapsed() << "ms";
+    return true;
+}
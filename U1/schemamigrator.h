@@ -0,0 +1,40 @@
+// include/schemamigrator.h
+#ifndef SCHEMAMIGRATOR_H
+#define SCHEMAMIGRATOR_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class Database;
+
+// 版本化的表结构迁移，迁移列表由存储后端提供（各库的 DDL 方言不同）
+// SchemaVersion 表记录已应用的版本；启动时按版本号顺序执行尚未应用的迁移，
+// 每个迁移在一个事务中执行并写入版本行。MySQL 的 DDL 会隐式提交，
+// 因此"表/列/索引已存在"视为该语句已生效，中途失败后重跑同一迁移是安全的。
+// 多个客户端同时启动时由后端加锁串行化，只有一个会真正执行迁移。
+class SchemaMigrator
+{
+public:
+    struct Migration {
+        int version;
+        QString description;
+        QStringList statements;
+    };
+
+    explicit SchemaMigrator(Database *db);
+
+    bool migrate();
+    int currentVersion();
+
+    // 新迁移只能追加在末尾，已发布的迁移不能再修改
+    const QVector<Migration> &migrations() const;
+
+private:
+    bool ensureVersionTable();
+    bool apply(const Migration &migration);
+
+    Database *m_db;
+};
+
+#endif // SCHEMAMIGRATOR_H
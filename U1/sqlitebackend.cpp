@@ -0,0 +1,482 @@
+// src/sqlitebackend.cpp
+#include "sqlitebackend.h"
+#include "database.h"
+#include "reservationqueue.h"
+#include <QLockFile>
+#include <QThread>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDebug>
+
+static QVector<SchemaMigrator::Migration> buildMigrations()
+{
+    QVector<SchemaMigrator::Migration> list;
+
+    // 1. 基础表：与 MySQL 的表结构对应，ENUM 改为 CHECK 约束，自增主键用 AUTOINCREMENT
+    SchemaMigrator::Migration baseline;
+    baseline.version = 1;
+    baseline.description = "baseline tables";
+    baseline.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS Users ("
+        "   UserID VARCHAR(6) PRIMARY KEY,"
+        "   Email VARCHAR(50) UNIQUE NOT NULL,"
+        "   Password VARCHAR(255) NOT NULL,"
+        "   Name VARCHAR(50) NOT NULL,"
+        "   Type VARCHAR(16) DEFAULT 'Normal' CHECK (Type IN ('Normal', 'Super')),"
+        "   TotalReadingHours REAL DEFAULT 0.0,"
+        "   Fines DECIMAL(10,2) DEFAULT 0.0,"
+        "   CreditScore INT DEFAULT 100,"
+        "   HadLowCredit BOOLEAN DEFAULT 0"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS Books ("
+        "   ISBN VARCHAR(20) PRIMARY KEY,"
+        "   Title VARCHAR(255) NOT NULL,"
+        "   Author VARCHAR(100) NOT NULL,"
+        "   Publisher VARCHAR(100),"
+        "   PublishDate DATE,"
+        "   Price DECIMAL(10,2),"
+        "   Introduction TEXT,"
+        "   TotalCopies INT NOT NULL,"
+        "   AvailableCopies INT NOT NULL"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS BorrowRecords ("
+        "   RecordID INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "   UserID VARCHAR(6) NOT NULL REFERENCES Users(UserID),"
+        "   ISBN VARCHAR(20) NOT NULL REFERENCES Books(ISBN),"
+        "   BorrowDate DATE NOT NULL,"
+        "   DueDate DATE NOT NULL,"
+        "   ReturnDate DATE,"
+        "   Fine DECIMAL(10,2) DEFAULT 0.0,"
+        "   CreditDeduction INT DEFAULT 0"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS Comments ("
+        "   CommentID INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "   UserID VARCHAR(6) NOT NULL REFERENCES Users(UserID),"
+        "   ISBN VARCHAR(20) NOT NULL REFERENCES Books(ISBN),"
+        "   Comment TEXT,"
+        "   Rating INT CHECK (Rating BETWEEN 1 AND 5),"
+        "   CommentDate DATETIME NOT NULL"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS BookRatingStats ("
+        "   ISBN VARCHAR(20) PRIMARY KEY REFERENCES Books(ISBN) ON DELETE CASCADE,"
+        "   RatingCount INT NOT NULL DEFAULT 0,"
+        "   RatingSum INT NOT NULL DEFAULT 0,"
+        "   Rating1 INT NOT NULL DEFAULT 0,"
+        "   Rating2 INT NOT NULL DEFAULT 0,"
+        "   Rating3 INT NOT NULL DEFAULT 0,"
+        "   Rating4 INT NOT NULL DEFAULT 0,"
+        "   Rating5 INT NOT NULL DEFAULT 0"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS Reservations ("
+        "   ReservationID INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "   UserID VARCHAR(6) NOT NULL REFERENCES Users(UserID),"
+        "   ISBN VARCHAR(20) NOT NULL REFERENCES Books(ISBN),"
+        "   ReserveDate DATETIME NOT NULL,"
+        "   Status VARCHAR(16) DEFAULT 'Pending' CHECK (Status IN ('Pending', 'Fulfilled', 'Cancelled'))"
+        ")",
+
+        "CREATE TABLE IF NOT EXISTS OverdueRuns ("
+        "   RunDate DATE PRIMARY KEY,"
+        "   StartedAt DATETIME NOT NULL,"
+        "   FinishedAt DATETIME,"
+        "   OverdueLoans INT NOT NULL DEFAULT 0,"
+        "   SevereLoans INT NOT NULL DEFAULT 0,"
+        "   UsersPenalized INT NOT NULL DEFAULT 0,"
+        "   CreditDeducted INT NOT NULL DEFAULT 0,"
+        "   DurationMs BIGINT NOT NULL DEFAULT 0,"
+        "   RowsPerSecond DOUBLE NOT NULL DEFAULT 0"
+        ")",
+
+        "CREATE INDEX IF NOT EXISTS idx_books_title ON Books (Title)",
+        "CREATE INDEX IF NOT EXISTS idx_books_available ON Books (AvailableCopies)"
+    };
+    list.append(baseline);
+
+    // 2. 借还热点查询的索引，与 MySQL 迁移 2 相同
+    SchemaMigrator::Migration circulationIndexes;
+    circulationIndexes.version = 2;
+    circulationIndexes.description = "circulation indexes";
+    circulationIndexes.statements = QStringList{
+        "CREATE INDEX IF NOT EXISTS idx_borrow_user_return ON BorrowRecords (UserID, ReturnDate)",
+        "CREATE INDEX IF NOT EXISTS idx_borrow_isbn_return ON BorrowRecords (ISBN, ReturnDate)",
+        "CREATE INDEX IF NOT EXISTS idx_borrow_return_due ON BorrowRecords (ReturnDate, DueDate)",
+        "CREATE INDEX IF NOT EXISTS idx_comments_isbn_date ON Comments (ISBN, CommentDate)",
+        "CREATE INDEX IF NOT EXISTS idx_reservations_isbn_status ON Reservations (ISBN, Status)"
+    };
+    list.append(circulationIndexes);
+
+    // 3. 副本表；SQLite 库从空库开始，不需要按库存补齐
+    SchemaMigrator::Migration bookCopies;
+    bookCopies.version = 3;
+    bookCopies.description = "book copies";
+    bookCopies.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS BookCopies ("
+        "   CopyID VARCHAR(32) PRIMARY KEY,"
+        "   ISBN VARCHAR(20) NOT NULL REFERENCES Books(ISBN) ON DELETE CASCADE,"
+        "   Status VARCHAR(16) NOT NULL DEFAULT 'Available' CHECK (Status IN ('Available', 'Borrowed', 'Lost'))"
+        ")",
+        "CREATE INDEX IF NOT EXISTS idx_copies_isbn_status ON BookCopies (ISBN, Status)"
+    };
+    list.append(bookCopies);
+
+    // 4. 表结构指纹
+    SchemaMigrator::Migration schemaState;
+    schemaState.version = 4;
+    schemaState.description = "schema fingerprint";
+    schemaState.statements = QStringList{
+        "CREATE TABLE IF NOT EXISTS SchemaState ("
+        "   Id INTEGER PRIMARY KEY,"
+        "   Fingerprint CHAR(40) NOT NULL,"
+        "   UpdatedAt DATETIME NOT NULL"
+        ")"
+    };
+    list.append(schemaState);
+
+    // 5. 预约排队，与 MySQL 迁移 5 相同；SQLite 不能修改 CHECK 约束，按新结构重建表
+    SchemaMigrator::Migration reservationQueue;
+    reservationQueue.version = 5;
+    reservationQueue.description = "reservation queue";
+    reservationQueue.statements = QStringList{
+        "CREATE TABLE Reservations_v5 ("
+        "   ReservationID INTEGER PRIMARY KEY AUTOINCREMENT,"
+        "   UserID VARCHAR(6) NOT NULL REFERENCES Users(UserID),"
+        "   ISBN VARCHAR(20) NOT NULL REFERENCES Books(ISBN),"
+        "   ReserveDate DATETIME NOT NULL,"
+        "   Status VARCHAR(16) NOT NULL DEFAULT 'Pending' "
+        "       CHECK (Status IN ('Pending', 'Ready', 'Fulfilled', 'Cancelled', 'Expired')),"
+        "   Priority INT NOT NULL DEFAULT 0,"
+        "   ReadyAt DATETIME,"
+        "   PickupDeadline DATETIME"
+        ")",
+        "INSERT INTO Reservations_v5 (ReservationID, UserID, ISBN, ReserveDate, Status, Priority) "
+        "SELECT r.ReservationID, r.UserID, r.ISBN, r.ReserveDate, COALESCE(r.Status, 'Pending'), "
+        "       CASE WHEN u.Type = 'Super' THEN 1 ELSE 0 END "
+        "FROM Reservations r LEFT JOIN Users u ON u.UserID = r.UserID",
+        "DROP TABLE Reservations",
+        "ALTER TABLE Reservations_v5 RENAME TO Reservations",
+        "CREATE INDEX IF NOT EXISTS idx_reservations_queue "
+        "ON Reservations (ISBN, Status, Priority DESC, ReservationID)",
+        "CREATE INDEX IF NOT EXISTS idx_reservations_pickup ON Reservations (Status, PickupDeadline)"
+    };
+    list.append(reservationQueue);
+
+    // 6. 副本级流通，与 MySQL 迁移 6 相同；SQLite 的 UPDATE 不能 JOIN，用相关子查询对应在借记录和副本
+    SchemaMigrator::Migration copyCirculation;
+    copyCirculation.version = 6;
+    copyCirculation.description = "copy-level circulation";
+    copyCirculation.statements = QStringList{
+        "ALTER TABLE BorrowRecords ADD COLUMN CopyID VARCHAR(32)",
+        "CREATE INDEX IF NOT EXISTS idx_borrow_copy ON BorrowRecords (CopyID)",
+        "UPDATE BookCopies SET Status = 'Available' WHERE Status = 'Borrowed'",
+        "UPDATE BorrowRecords SET CopyID = ("
+        "   SELECT c.CopyID FROM ("
+        "       SELECT CopyID, ISBN, ROW_NUMBER() OVER (PARTITION BY ISBN ORDER BY CopyID) AS Seq "
+        "       FROM BookCopies WHERE Status = 'Available') c "
+        "   WHERE c.ISBN = BorrowRecords.ISBN AND c.Seq = ("
+        "       SELECT COUNT(*) FROM BorrowRecords o WHERE o.ISBN = BorrowRecords.ISBN "
+        "       AND o.ReturnDate IS NULL AND o.RecordID <= BorrowRecords.RecordID)"
+        ") WHERE ReturnDate IS NULL",
+        "UPDATE BookCopies SET Status = 'Borrowed' WHERE CopyID IN "
+        "(SELECT CopyID FROM BorrowRecords WHERE ReturnDate IS NULL AND CopyID IS NOT NULL)"
+    };
+    list.append(copyCirculation);
+
+    return list;
+}
+
+SqliteBackend::Options::Options()
+    : path("library.db"), mmapSize(256LL * 1024 * 1024), cacheSizeKb(64 * 1024), busyTimeoutMs(5000)
+{
+}
+
+SqliteBackend::SqliteBackend(const Options &options)
+    : m_options(options), m_migrations(buildMigrations())
+{
+}
+
+SqliteBackend::~SqliteBackend()
+{
+}
+
+QString SqliteBackend::name() const {
+    return "sqlite";
+}
+
+ConnectionPool::Config SqliteBackend::connectionConfig() const
+{
+    ConnectionPool::Config config;
+    config.driver = "QSQLITE";
+    config.databaseName = m_options.path;
+    config.connectOptions = QString("QSQLITE_BUSY_TIMEOUT=%1").arg(m_options.busyTimeoutMs);
+    // journal_mode 写入库文件，其余为连接级设置；cache_size 为负数时单位是 KiB
+    config.initStatements = QStringList{
+        "PRAGMA journal_mode = WAL",
+        "PRAGMA synchronous = NORMAL",
+        "PRAGMA foreign_keys = ON",
+        "PRAGMA temp_store = MEMORY",
+        QString("PRAGMA mmap_size = %1").arg(m_options.mmapSize),
+        QString("PRAGMA cache_size = -%1").arg(m_options.cacheSizeKb)
+    };
+    config.minSize = 1;
+    config.maxSize = qMax(4, QThread::idealThreadCount() + 1);
+    return config;
+}
+
+const QVector<SchemaMigrator::Migration> &SqliteBackend::migrations() const {
+    return m_migrations;
+}
+
+QStringList SqliteBackend::routines() const {
+    return QStringList();
+}
+
+// 未复位的语句会一直占着读快照，长期缓存会让别的连接的提交迟迟不可见，每次现 prepare（开销很小）
+bool SqliteBackend::cachesStatements() const {
+    return false;
+}
+
+// 旧版本 SQLite 的 SQLITE_MAX_VARIABLE_NUMBER 默认值
+int SqliteBackend::maxBindValues() const {
+    return 999;
+}
+
+// 与借还相同用 BEGIN IMMEDIATE：开始时就拿写锁，其他写者在 busy_timeout 内排队。
+// 缺省的 BEGIN 先读后写，两个事务都读过之后升级写锁时一方直接 SQLITE_BUSY 失败。
+// QSqlDatabase::commit()/rollback() 在 SQLite 上只是执行 COMMIT/ROLLBACK，可以照常使用
+bool SqliteBackend::beginTransaction(QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+    if(!q.exec("BEGIN IMMEDIATE")) {
+        qDebug() << "SQLite begin error:" << q.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+// 同一台机器上的多个进程用库文件旁的锁文件互斥
+bool SqliteBackend::lockSchema()
+{
+    m_schemaLock.reset(new QLockFile(m_options.path + ".migrate.lock"));
+    if(!m_schemaLock->tryLock(60 * 1000)) {
+        m_schemaLock.reset();
+        return false;
+    }
+    return true;
+}
+
+void SqliteBackend::unlockSchema()
+{
+    m_schemaLock.reset();
+}
+
+// 已在调用方事务中时直接加入，否则开启写事务
+bool SqliteBackend::begin()
+{
+    Database *db = Database::instance();
+    if(db->inTransaction()) return true;
+    return db->executePrepared("sqlite.begin", "BEGIN IMMEDIATE");
+}
+
+bool SqliteBackend::finish(bool commit)
+{
+    Database *db = Database::instance();
+    if(db->inTransaction()) return true;
+    if(commit) return db->executePrepared("sqlite.commit", "COMMIT");
+    db->executePrepared("sqlite.rollback", "ROLLBACK");
+    return true;
+}
+
+// 与存储过程 BorrowBook 相同的步骤；BEGIN IMMEDIATE 期间其他写者排队，检查和扣减之间库存不会被别人改动
+Library::CirculationResult SqliteBackend::borrow(const QString &userId, const QString &isbn,
+                                                 const QDate &today, const QString &copyHint)
+{
+    Library::CirculationResult result;
+    if(!begin()) return result;
+
+    Database *db = Database::instance();
+    Library::CirculationStatus status = Library::CirculationOk;
+    bool ok = true;
+
+    QSqlQuery user = db->executePreparedQuery("sqlite.borrow.user",
+        "SELECT CreditScore, Type FROM Users WHERE UserID = ?", {userId});
+    if(!user.next()) {
+        status = Library::UserNotFound;
+    } else if(user.value(0).toInt() < 90) {
+        status = Library::CreditTooLow;
+    } else {
+        bool super = user.value(1).toString() == "Super";
+        result.borrowLimit = super ? 8 : 5;
+        int days = super ? 28 : 14;
+
+        QSqlQuery open = db->executePreparedQuery("sqlite.borrow.open",
+            "SELECT COUNT(*) FROM BorrowRecords WHERE UserID = ? AND ReturnDate IS NULL", {userId});
+        int openLoans = open.next() ? open.value(0).toInt() : 0;
+
+        if(openLoans >= result.borrowLimit) {
+            status = Library::BorrowLimitReached;
+        } else {
+            // 先用为该读者保留的副本，没有时再从可借数中扣
+            int taken = 0;
+            ok = db->executePrepared("sqlite.borrow.hold",
+                "UPDATE Reservations SET Status = 'Fulfilled' WHERE ReservationID = "
+                "(SELECT ReservationID FROM Reservations WHERE UserID = ? AND ISBN = ? AND Status = 'Ready' "
+                "ORDER BY ReservationID LIMIT 1)", {userId, isbn}, &taken);
+            if(ok && taken == 0) {
+                ok = db->executePrepared("sqlite.borrow.take",
+                    "UPDATE Books SET AvailableCopies = AvailableCopies - 1 "
+                    "WHERE ISBN = ? AND AvailableCopies > 0", {isbn}, &taken);
+            }
+            if(ok && taken == 0) {
+                QSqlQuery book = db->executePreparedQuery("sqlite.borrow.book",
+                    "SELECT 1 FROM Books WHERE ISBN = ?", {isbn});
+                status = book.next() ? Library::NoCopiesAvailable : Library::BookNotFound;
+            } else if(ok) {
+                // 借出具体副本：优先用位图选出的那一册，已不可借时另取一册
+                int marked = 0;
+                ok = db->executePrepared("sqlite.borrow.hint",
+                    "UPDATE BookCopies SET Status = 'Borrowed' "
+                    "WHERE CopyID = ? AND ISBN = ? AND Status = 'Available'", {copyHint, isbn}, &marked);
+                if(ok && marked > 0) {
+                    result.copyId = copyHint;
+                } else if(ok) {
+                    QSqlQuery copy = db->executePreparedQuery("sqlite.borrow.copy",
+                        "SELECT CopyID FROM BookCopies WHERE ISBN = ? AND Status = 'Available' "
+                        "ORDER BY CopyID LIMIT 1", {isbn});
+                    if(copy.next()) {
+                        result.copyId = copy.value(0).toString();
+                        ok = db->executePrepared("sqlite.borrow.mark",
+                            "UPDATE BookCopies SET Status = 'Borrowed' WHERE CopyID = ?", {result.copyId});
+                    }
+                }
+                result.dueDate = today.addDays(days);
+                ok = ok && db->executePrepared("sqlite.borrow.record",
+                    "INSERT INTO BorrowRecords (UserID, ISBN, CopyID, BorrowDate, DueDate) VALUES (?, ?, ?, ?, ?)",
+                    {userId, isbn, result.copyId.isEmpty() ? QVariant(QVariant::String) : QVariant(result.copyId),
+                     today, result.dueDate});
+            }
+        }
+    }
+
+    if(!ok || !finish(status == Library::CirculationOk)) {
+        finish(false);
+        result.dueDate = QDate();
+        result.copyId.clear();
+        return result;
+    }
+    result.status = status;
+    return result;
+}
+
+// 与存储过程 ReturnBook 相同的步骤（队首分配见 ReservationQueue::allocateReturned）；
+// SQLite 的 UPDATE 各列都按旧值计算，HadLowCredit 用扣分后的分数单独判断
+Library::CirculationResult SqliteBackend::giveBack(const QString &userId, const QString &isbn,
+                                                   const QDate &today)
+{
+    Library::CirculationResult result;
+    if(!begin()) return result;
+
+    Database *db = Database::instance();
+    QSqlQuery loan = db->executePreparedQuery("sqlite.return.loan",
+        "SELECT RecordID, DueDate, CopyID FROM BorrowRecords "
+        "WHERE UserID = ? AND ISBN = ? AND ReturnDate IS NULL "
+        "ORDER BY BorrowDate, RecordID LIMIT 1", {userId, isbn});
+    if(!loan.next()) {
+        finish(false);
+        result.status = Library::NoOpenLoan;
+        return result;
+    }
+    int recordId = loan.value(0).toInt();
+    result.copyId = loan.value(2).toString();
+    int overdue = qMax(0, int(loan.value(1).toDate().daysTo(today)));
+    if(overdue > 0) {
+        result.fine = overdue * 0.5;
+        result.creditDeduction = overdue <= 7 ? 2 : 5;
+    }
+
+    bool ok = db->executePrepared("sqlite.return.close",
+        "UPDATE BorrowRecords SET ReturnDate = ?, Fine = ?, CreditDeduction = ? WHERE RecordID = ?",
+        {today, result.fine, result.creditDeduction, recordId});
+    // 副本级流通之前的借阅没有记副本，归还任意一册借出中的副本
+    if(ok && result.copyId.isEmpty()) {
+        QSqlQuery copy = db->executePreparedQuery("sqlite.return.copy",
+            "SELECT CopyID FROM BookCopies WHERE ISBN = ? AND Status = 'Borrowed' "
+            "ORDER BY CopyID LIMIT 1", {isbn});
+        if(copy.next()) result.copyId = copy.value(0).toString();
+    }
+    ok = ok && db->executePrepared("sqlite.return.shelve",
+        "UPDATE BookCopies SET Status = 'Available' WHERE CopyID = ? AND Status = 'Borrowed'",
+        {result.copyId});
+    // 有人排队时副本保留给队首，否则放回可借
+    QList<ReservationQueue::Promotion> promoted;
+    ok = ok && ReservationQueue::allocateReturned(isbn, 1, &promoted);
+    if(ok && !promoted.isEmpty()) {
+        result.heldReservation = promoted.first().reservationId;
+        result.pickupDeadline = promoted.first().deadline;
+    }
+    if(ok && overdue > 0) {
+        ok = db->executePrepared("sqlite.return.penalize",
+            "UPDATE Users SET Fines = Fines + ?, CreditScore = MAX(CreditScore - ?, 0), "
+            "HadLowCredit = HadLowCredit OR MAX(CreditScore - ?, 0) < 90 WHERE UserID = ?",
+            {result.fine, result.creditDeduction, result.creditDeduction, userId});
+        QSqlQuery credit = db->executePreparedQuery("sqlite.return.credit",
+            "SELECT CreditScore FROM Users WHERE UserID = ?", {userId});
+        if(ok && credit.next()) result.creditScore = credit.value(0).toInt();
+    }
+
+    if(!ok || !finish(true)) {
+        finish(false);
+        return Library::CirculationResult();
+    }
+    result.status = Library::CirculationOk;
+    return result;
+}
+
+QString SqliteBackend::insertIgnore() const {
+    return "INSERT OR IGNORE";
+}
+
+QString SqliteBackend::now() const {
+    return "datetime('now', 'localtime')";
+}
+
+QString SqliteBackend::greatest() const {
+    return "MAX";
+}
+
+QString SqliteBackend::daysBetween(const QString &later, const QString &earlier) const
+{
+    return QString("CAST(julianday(%1) - julianday(%2) AS INTEGER)").arg(later, earlier);
+}
+
+// 没有 CRC32，对末尾 HashChars 个字符的码位做多项式哈希（基数31）再取模。
+// 只看末位时 ISBN 最多11种取值，各分片大小悬殊；不足的位置 substr 为空串，按0计
+QString SqliteBackend::hashBucket(const QString &column) const
+{
+    static const int HashChars = 8;
+    QStringList terms;
+    qint64 factor = 1;
+    for(int i = 1; i <= HashChars; ++i) {
+        terms << QString("%1 * COALESCE(unicode(substr(%2, -%3, 1)), 0)").arg(factor).arg(column).arg(i);
+        factor *= 31;
+    }
+    return QString("((%1) % ?)").arg(terms.join(" + "));
+}
+
+QString SqliteBackend::upsertAdding(const QString &keyColumn, const QStringList &columns) const
+{
+    QStringList assignments;
+    foreach (const QString &column, columns) {
+        assignments << QString("%1 = %1 + excluded.%1").arg(column);
+    }
+    return QString("ON CONFLICT(%1) DO UPDATE SET ").arg(keyColumn) + assignments.join(", ");
+}
+
+// 写事务以 BEGIN IMMEDIATE 开始，已经独占写锁
+QString SqliteBackend::forUpdate() const {
+    return QString();
+}
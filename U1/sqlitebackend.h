@@ -0,0 +1,62 @@
+// include/sqlitebackend.h
+#ifndef SQLITEBACKEND_H
+#define SQLITEBACKEND_H
+
+#include "storagebackend.h"
+#include <QScopedPointer>
+
+class QLockFile;
+
+// 嵌入式 SQLite 后端，单机部署时不需要单独的数据库服务器
+// 每个连接打开后设置 WAL 日志、synchronous=NORMAL、内存映射和页缓存：
+// WAL 下读不阻塞写，写事务用 BEGIN IMMEDIATE 一开始就拿写锁，并发写者按 busy_timeout 排队。
+// 没有存储过程，借还在 C++ 中按与 MySQL 存储过程相同的步骤执行。
+class SqliteBackend : public StorageBackend
+{
+public:
+    struct Options {
+        QString path;
+        qint64 mmapSize;    // 字节
+        int cacheSizeKb;    // 每个连接的页缓存
+        int busyTimeoutMs;
+        Options();
+    };
+
+    explicit SqliteBackend(const Options &options);
+    ~SqliteBackend() override;
+
+    QString name() const override;
+    ConnectionPool::Config connectionConfig() const override;
+
+    const QVector<SchemaMigrator::Migration> &migrations() const override;
+    QStringList routines() const override;
+    bool cachesStatements() const override;
+    int maxBindValues() const override;
+    bool beginTransaction(QSqlDatabase &db) override;
+
+    bool lockSchema() override;
+    void unlockSchema() override;
+
+    Library::CirculationResult borrow(const QString &userId, const QString &isbn,
+                                      const QDate &today, const QString &copyHint) override;
+    Library::CirculationResult giveBack(const QString &userId, const QString &isbn,
+                                        const QDate &today) override;
+
+    QString insertIgnore() const override;
+    QString now() const override;
+    QString greatest() const override;
+    QString daysBetween(const QString &later, const QString &earlier) const override;
+    QString hashBucket(const QString &column) const override;
+    QString upsertAdding(const QString &keyColumn, const QStringList &columns) const override;
+    QString forUpdate() const override;
+
+private:
+    bool begin();
+    bool finish(bool commit);
+
+    Options m_options;
+    QVector<SchemaMigrator::Migration> m_migrations;
+    QScopedPointer<QLockFile> m_schemaLock;
+};
+
+#endif // SQLITEBACKEND_H
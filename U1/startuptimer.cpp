@@ -0,0 +1,93 @@
+// src/startuptimer.cpp
+#include "startuptimer.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QList>
+#include <QPair>
+#include <QEvent>
+#include <QTimer>
+#include <QDebug>
+
+static QMutex startupMutex;
+static QElapsedTimer startupClock;
+static QList<QPair<QString, qint64>> startupPhases;
+static bool startupEnabled = false;
+static bool startupReported = false;
+
+// 顶层窗口在处理 UpdateRequest 时绘制整棵控件树并刷新到屏幕，处理完即为首次绘制完成
+class FirstPaintWatcher : public QObject
+{
+public:
+    explicit FirstPaintWatcher(QObject *parent) : QObject(parent) {}
+
+    bool eventFilter(QObject *watched, QEvent *event) override
+    {
+        if(event->type() == QEvent::UpdateRequest) {
+            watched->removeEventFilter(this);
+            QTimer::singleShot(0, []() { StartupTimer::mark("first paint"); });
+            deleteLater();
+        }
+        return false;
+    }
+};
+
+void StartupTimer::start()
+{
+    QMutexLocker lock(&startupMutex);
+    startupClock.start();
+    startupPhases.clear();
+    startupReported = false;
+}
+
+void StartupTimer::setEnabled(bool enabled)
+{
+    QMutexLocker lock(&startupMutex);
+    startupEnabled = enabled;
+}
+
+void StartupTimer::mark(const QString &phase)
+{
+    {
+        QMutexLocker lock(&startupMutex);
+        if(!startupClock.isValid()) return;
+        for(int i = 0; i < startupPhases.size(); ++i) {
+            if(startupPhases[i].first == phase) return;
+        }
+        startupPhases.append(qMakePair(phase, startupClock.elapsed()));
+    }
+    reportIfComplete();
+}
+
+void StartupTimer::watchFirstPaint(QObject *window)
+{
+    window->installEventFilter(new FirstPaintWatcher(window));
+}
+
+void StartupTimer::reportIfComplete()
+{
+    QMutexLocker lock(&startupMutex);
+    if(!startupEnabled || startupReported) return;
+
+    bool painted = false;
+    bool queried = false;
+    for(int i = 0; i < startupPhases.size(); ++i) {
+        painted = painted || startupPhases[i].first == "first paint";
+        queried = queried || startupPhases[i].first == "first query";
+    }
+    if(!painted || !queried) return;
+    startupReported = true;
+
+    qint64 previous = 0;
+    qint64 usable = 0;
+    for(int i = 0; i < startupPhases.size(); ++i) {
+        qint64 at = startupPhases[i].second;
+        qDebug().noquote() << QString("startup %1: %2 ms (total %3 ms)")
+                              .arg(startupPhases[i].first, -12).arg(at - previous, 4).arg(at, 4);
+        previous = at;
+        usable = qMax(usable, at);
+    }
+    if(usable > BudgetMs) {
+        qDebug().noquote() << QString("startup over budget: %1 ms > %2 ms").arg(usable).arg(BudgetMs);
+    }
+}
@@ -0,0 +1,28 @@
+// include/startuptimer.h
+#ifndef STARTUPTIMER_H
+#define STARTUPTIMER_H
+
+#include <QString>
+
+class QObject;
+
+// 启动阶段计时（命令行 --startup-report 开启输出）
+// 各阶段只记第一次到达的时间；"first query" 与 "first paint" 都到达后输出一次报告，
+// 每行给出本阶段耗时和累计耗时，总耗时超出预算时另行提示。
+class StartupTimer
+{
+public:
+    static const int BudgetMs = 300;
+
+    static void start();
+    static void setEnabled(bool enabled);
+    static void mark(const QString &phase);
+
+    // 窗口第一次绘制完成后记 "first paint"
+    static void watchFirstPaint(QObject *window);
+
+private:
+    static void reportIfComplete();
+};
+
+#endif // STARTUPTIMER_H
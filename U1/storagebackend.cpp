@@ -0,0 +1,43 @@
+// src/storagebackend.cpp
+#include "storagebackend.h"
+#include "mysqlbackend.h"
+#include "sqlitebackend.h"
+#include <QSettings>
+#include <QFileInfo>
+#include <QDir>
+#include <QDebug>
+
+StorageBackend::~StorageBackend()
+{
+}
+
+StorageBackend *StorageBackend::create(const QString &configFile)
+{
+    QSettings settings(configFile, QSettings::IniFormat);
+    QString kind = settings.value("storage/backend", "mysql").toString().trimmed().toLower();
+
+    if(kind == "sqlite") {
+        // 相对路径以配置文件所在目录为准
+        QString path = settings.value("sqlite/path", "library.db").toString();
+        if(QFileInfo(path).isRelative()) {
+            path = QFileInfo(configFile).absoluteDir().filePath(path);
+        }
+        SqliteBackend::Options options;
+        options.path = path;
+        options.mmapSize = settings.value("sqlite/mmap_size", options.mmapSize).toLongLong();
+        options.cacheSizeKb = settings.value("sqlite/cache_size_kb", options.cacheSizeKb).toInt();
+        options.busyTimeoutMs = settings.value("sqlite/busy_timeout_ms", options.busyTimeoutMs).toInt();
+        return new SqliteBackend(options);
+    }
+
+    if(kind != "mysql") {
+        qDebug() << "Unknown storage backend" << kind << "in" << configFile << "- using mysql";
+    }
+    ConnectionPool::Config config = MySqlBackend::defaultConfig();
+    config.hostName = settings.value("mysql/host", config.hostName).toString();
+    config.port = settings.value("mysql/port", config.port).toInt();
+    config.databaseName = settings.value("mysql/database", config.databaseName).toString();
+    config.userName = settings.value("mysql/user", config.userName).toString();
+    config.password = settings.value("mysql/password", config.password).toString();
+    return new MySqlBackend(config);
+}
@@ -0,0 +1,65 @@
+// include/storagebackend.h
+#ifndef STORAGEBACKEND_H
+#define STORAGEBACKEND_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QDate>
+#include <QSqlDatabase>
+#include "connectionpool.h"
+#include "schemamigrator.h"
+#include "library.h"
+
+// 存储后端：Database 通过它拿到连接配置、表结构迁移和各库方言
+// 选择哪种后端由配置文件决定（[storage] backend=mysql|sqlite），缺省为 MySQL：
+//   [mysql]  host, port, database, user, password
+//   [sqlite] path, mmap_size, cache_size_kb, busy_timeout_ms
+// 业务代码里只有少数语句用到方言片段，其余 SQL 两种库通用。
+class StorageBackend
+{
+public:
+    virtual ~StorageBackend();
+
+    // 按配置文件创建后端；文件不存在时使用 MySQL 默认配置
+    static StorageBackend *create(const QString &configFile);
+
+    virtual QString name() const = 0;
+    virtual ConnectionPool::Config connectionConfig() const = 0;
+
+    // 表结构迁移和每次表结构变化后重建的例程（存储过程等），都计入表结构指纹
+    virtual const QVector<SchemaMigrator::Migration> &migrations() const = 0;
+    virtual QStringList routines() const = 0;
+
+    // Database 是否按名称长期缓存预编译语句
+    virtual bool cachesStatements() const = 0;
+    // 一条语句最多可绑定的参数个数，多行 INSERT 据此决定每条语句的行数
+    virtual int maxBindValues() const = 0;
+    // 在 db 上开启事务，Database::transaction() 调用
+    virtual bool beginTransaction(QSqlDatabase &db) = 0;
+
+    // 多个客户端同时迁移时的互斥
+    virtual bool lockSchema() = 0;
+    virtual void unlockSchema() = 0;
+
+    // 借还：在一个事务里完成检查、扣减库存和借阅记录，状态码见 Library::CirculationStatus
+    // copyHint 是内存位图选出的空闲副本，已被别人借走时由数据库另选一册；实际借出的副本见 result.copyId
+    virtual Library::CirculationResult borrow(const QString &userId, const QString &isbn,
+                                              const QDate &today, const QString &copyHint) = 0;
+    virtual Library::CirculationResult giveBack(const QString &userId, const QString &isbn,
+                                                const QDate &today) = 0;
+
+    // 方言片段
+    virtual QString insertIgnore() const = 0;       // 主键冲突时忽略的 INSERT
+    virtual QString now() const = 0;                // 当前时间
+    virtual QString greatest() const = 0;           // 多参数取最大值的函数名
+    virtual QString daysBetween(const QString &later, const QString &earlier) const = 0;
+    // 按列值哈希分片的表达式，模数用一个 ? 占位
+    virtual QString hashBucket(const QString &column) const = 0;
+    // 主键冲突时把 columns 累加上新插入的值
+    virtual QString upsertAdding(const QString &keyColumn, const QStringList &columns) const = 0;
+    // 加在 SELECT 末尾，锁定事务内读到的行
+    virtual QString forUpdate() const = 0;
+};
+
+#endif // STORAGEBACKEND_H
@@ -0,0 +1,282 @@
+// src/streamingexporter.cpp
+#include "streamingexporter.h"
+#include "database.h"
+#include <QFile>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <cstdio>
+
+StreamingExporter::Options::Options()
+    : format(Csv), chunkRows(50000), bufferBytes(1 << 20)
+{
+}
+
+StreamingExporter::Summary::Summary()
+    : ok(false), rows(0), bytes(0), durationMs(0), rowsPerSecond(0.0)
+{
+}
+
+StreamingExporter::StreamingExporter(const Options &options)
+    : m_options(options)
+{
+    if(m_options.chunkRows < 1) m_options.chunkRows = 1;
+    if(m_options.bufferBytes < 4096) m_options.bufferBytes = 4096;
+}
+
+bool StreamingExporter::parseDataset(const QString &name, Dataset *dataset)
+{
+    QString key = name.toLower();
+    if(key == "borrows" || key == "borrowrecords") {
+        *dataset = BorrowRecords;
+    } else if(key == "users") {
+        *dataset = Users;
+    } else if(key == "books") {
+        *dataset = Books;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool StreamingExporter::parseFormat(const QString &name, Format *format)
+{
+    QString key = name.toLower();
+    if(key == "csv") {
+        *format = Csv;
+    } else if(key == "jsonl" || key == "ndjson") {
+        *format = JsonLines;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// 不导出 Users.Password
+StreamingExporter::Table StreamingExporter::table(Dataset dataset)
+{
+    static const Column borrowColumns[] = {
+        { "RecordID", Integer }, { "UserID", Text }, { "ISBN", Text }, { "CopyID", Text },
+        { "BorrowDate", Date }, { "DueDate", Date }, { "ReturnDate", Date },
+        { "Fine", Decimal }, { "CreditDeduction", Integer }
+    };
+    static const Column userColumns[] = {
+        { "UserID", Text }, { "Email", Text }, { "Name", Text }, { "Type", Text },
+        { "TotalReadingHours", Real }, { "Fines", Decimal }, { "CreditScore", Integer },
+        { "HadLowCredit", Boolean }
+    };
+    static const Column bookColumns[] = {
+        { "ISBN", Text }, { "Title", Text }, { "Author", Text }, { "Publisher", Text },
+        { "PublishDate", Date }, { "Price", Decimal }, { "TotalCopies", Integer },
+        { "AvailableCopies", Integer }, { "Introduction", Text }
+    };
+
+    switch(dataset) {
+    case BorrowRecords:
+        return { "BorrowRecords", borrowColumns, int(sizeof(borrowColumns) / sizeof(Column)), true };
+    case Users:
+        return { "Users", userColumns, int(sizeof(userColumns) / sizeof(Column)), false };
+    case Books:
+        return { "Books", bookColumns, int(sizeof(bookColumns) / sizeof(Column)), false };
+    }
+    return { "", nullptr, 0, false };
+}
+
+StreamingExporter::Summary StreamingExporter::exportToFile(Dataset dataset, const QString &path)
+{
+    QFile file;
+    bool opened = false;
+    if(path == "-") {
+        opened = file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(path);
+        opened = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if(!opened) {
+        qDebug() << "Cannot open export target:" << path << file.errorString();
+        return Summary();
+    }
+    Summary summary = exportTo(dataset, &file);
+    file.flush();
+    return summary;
+}
+
+StreamingExporter::Summary StreamingExporter::exportTo(Dataset dataset, QIODevice *device)
+{
+    Summary summary;
+    QElapsedTimer timer;
+    timer.start();
+
+    const Table t = table(dataset);
+    QStringList names;
+    for(int i = 0; i < t.columnCount; ++i) names << t.columns[i].name;
+    const QString sql = QString("SELECT %1 FROM %2 WHERE %3 > ? ORDER BY %3 LIMIT ?")
+                            .arg(names.join(", "), t.name, t.columns[0].name);
+
+    m_buffer.clear();
+    m_buffer.reserve(m_options.bufferBytes + 64 * 1024);
+    if(m_options.format == Csv) appendHeader(t);
+
+    // 只进游标，不为向后滚动保留已读过的行
+    QSqlQuery q(Database::instance()->connection());
+    q.setForwardOnly(true);
+    if(!q.prepare(sql)) {
+        qDebug() << "Export prepare error:" << q.lastError().text();
+        return summary;
+    }
+
+    QVariant lastKey = t.integerKey ? QVariant(0) : QVariant(QString(""));
+    while(true) {
+        q.addBindValue(lastKey);
+        q.addBindValue(m_options.chunkRows);
+        if(!q.exec()) {
+            qDebug() << "Export query error:" << q.lastError().text();
+            return summary;
+        }
+        int chunk = 0;
+        while(q.next()) {
+            appendRow(t, q);
+            ++chunk;
+            if(m_buffer.size() >= m_options.bufferBytes && !flush(device, summary)) return summary;
+            if(chunk == m_options.chunkRows) lastKey = q.value(0);
+        }
+        summary.rows += chunk;
+        q.finish();
+        if(chunk < m_options.chunkRows) break;
+    }
+
+    if(!flush(device, summary)) return summary;
+    summary.ok = true;
+    summary.durationMs = timer.elapsed();
+    if(summary.durationMs > 0) {
+        summary.rowsPerSecond = summary.rows * 1000.0 / summary.durationMs;
+    }
+    return summary;
+}
+
+bool StreamingExporter::flush(QIODevice *device, Summary &summary)
+{
+    if(m_buffer.isEmpty()) return true;
+    qint64 written = device->write(m_buffer);
+    if(written != m_buffer.size()) {
+        qDebug() << "Export write error:" << device->errorString();
+        return false;
+    }
+    summary.bytes += written;
+    m_buffer.resize(0); // 保留容量，缓冲区只分配一次
+    return true;
+}
+
+void StreamingExporter::appendHeader(const Table &table)
+{
+    for(int i = 0; i < table.columnCount; ++i) {
+        if(i > 0) m_buffer.append(',');
+        m_buffer.append(table.columns[i].name);
+    }
+    m_buffer.append('\n');
+}
+
+void StreamingExporter::appendRow(const Table &table, const QSqlQuery &query)
+{
+    const bool json = m_options.format == JsonLines;
+    if(json) m_buffer.append('{');
+    for(int i = 0; i < table.columnCount; ++i) {
+        const Column &column = table.columns[i];
+        if(json) {
+            if(i > 0) m_buffer.append(',');
+            m_buffer.append('"').append(column.name).append("\":");
+        } else if(i > 0) {
+            m_buffer.append(',');
+        }
+
+        const QVariant value = query.value(i);
+        if(value.isNull()) {
+            if(json) m_buffer.append("null");
+            continue;
+        }
+        switch(column.kind) {
+        case Text:
+            if(json) {
+                appendJsonText(value.toString());
+            } else {
+                appendCsvText(value.toString());
+            }
+            break;
+        case Integer:
+            m_buffer.append(QByteArray::number(value.toLongLong()));
+            break;
+        case Decimal:
+            m_buffer.append(QByteArray::number(value.toDouble(), 'f', 2));
+            break;
+        case Real:
+            m_buffer.append(QByteArray::number(value.toDouble(), 'g', 7));
+            break;
+        case Date: {
+            // SQLite 以文本存日期，统一转成 yyyy-MM-dd
+            QByteArray date = value.toDate().toString(Qt::ISODate).toLatin1();
+            if(json) {
+                m_buffer.append('"').append(date).append('"');
+            } else {
+                m_buffer.append(date);
+            }
+            break;
+        }
+        case Boolean:
+            if(json) {
+                m_buffer.append(value.toBool() ? "true" : "false");
+            } else {
+                m_buffer.append(value.toBool() ? '1' : '0');
+            }
+            break;
+        }
+    }
+    m_buffer.append(json ? "}\n" : "\n");
+}
+
+// RFC 4180：含逗号、引号或换行时加引号，引号写两次
+void StreamingExporter::appendCsvText(const QString &text)
+{
+    const QByteArray utf8 = text.toUtf8();
+    bool quote = false;
+    for(char c : utf8) {
+        if(c == ',' || c == '"' || c == '\n' || c == '\r') {
+            quote = true;
+            break;
+        }
+    }
+    if(!quote) {
+        m_buffer.append(utf8);
+        return;
+    }
+    m_buffer.append('"');
+    for(char c : utf8) {
+        if(c == '"') m_buffer.append('"');
+        m_buffer.append(c);
+    }
+    m_buffer.append('"');
+}
+
+void StreamingExporter::appendJsonText(const QString &text)
+{
+    static const char hex[] = "0123456789abcdef";
+    const QByteArray utf8 = text.toUtf8();
+    m_buffer.append('"');
+    for(char c : utf8) {
+        switch(c) {
+        case '"':  m_buffer.append("\\\""); break;
+        case '\\': m_buffer.append("\\\\"); break;
+        case '\n': m_buffer.append("\\n"); break;
+        case '\r': m_buffer.append("\\r"); break;
+        case '\t': m_buffer.append("\\t"); break;
+        default:
+            if(uchar(c) < 0x20) {
+                m_buffer.append("\\u00").append(hex[(uchar(c) >> 4) & 0xF]).append(hex[uchar(c) & 0xF]);
+            } else {
+                m_buffer.append(c);
+            }
+        }
+    }
+    m_buffer.append('"');
+}
@@ -0,0 +1,70 @@
+// include/streamingexporter.h
+#ifndef STREAMINGEXPORTER_H
+#define STREAMINGEXPORTER_H
+
+#include <QString>
+#include <QByteArray>
+
+class QIODevice;
+class QSqlQuery;
+
+// 流式导出借阅记录、读者和图书（命令行 --export），格式为 CSV 或 JSON Lines
+// 按主键分块读取（WHERE 主键 > 上一块末行 ORDER BY 主键 LIMIT n），每块用只进游标逐行格式化，
+// 写入固定大小的缓冲区，满了再整块写出。内存占用只取决于块大小和缓冲区大小，与表的行数无关。
+// 不用一条 SELECT 读全表：QMYSQL 驱动总是把整个结果集取到客户端。
+class StreamingExporter
+{
+public:
+    enum Dataset { BorrowRecords, Users, Books };
+    enum Format { Csv, JsonLines };
+
+    struct Options {
+        Format format;
+        int chunkRows;      // 每次查询的行数
+        int bufferBytes;    // 输出缓冲区大小
+        Options();
+    };
+
+    struct Summary {
+        bool ok;
+        qint64 rows;
+        qint64 bytes;
+        qint64 durationMs;
+        double rowsPerSecond;
+        Summary();
+    };
+
+    explicit StreamingExporter(const Options &options = Options());
+
+    // path 为 "-" 时写到标准输出
+    Summary exportToFile(Dataset dataset, const QString &path);
+    Summary exportTo(Dataset dataset, QIODevice *device);
+
+    static bool parseDataset(const QString &name, Dataset *dataset);
+    static bool parseFormat(const QString &name, Format *format);
+
+private:
+    enum Kind { Text, Integer, Decimal, Real, Date, Boolean };
+    struct Column {
+        const char *name;
+        Kind kind;
+    };
+    struct Table {
+        const char *name;
+        const Column *columns;
+        int columnCount;
+        bool integerKey;    // 第一列是主键；整数主键从0开始，字符串主键从空串开始
+    };
+
+    static Table table(Dataset dataset);
+    void appendRow(const Table &table, const QSqlQuery &query);
+    void appendHeader(const Table &table);
+    void appendCsvText(const QString &text);
+    void appendJsonText(const QString &text);
+    bool flush(QIODevice *device, Summary &summary);
+
+    Options m_options;
+    QByteArray m_buffer;
+};
+
+#endif // STREAMINGEXPORTER_H
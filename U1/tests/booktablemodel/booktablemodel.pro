@@ -0,0 +1,12 @@
+# 图书列表模型滚动压测：10万行逐页加载
+TARGET = tst_booktablemodel
+
+include(../tests.pri)
+
+# 模型属于图形界面程序，只依赖 QtCore，直接编进测试
+SOURCES += \
+    ../../booktablemodel.cpp \
+    tst_booktablemodel.cpp
+
+HEADERS += \
+    ../../booktablemodel.h
@@ -0,0 +1,70 @@
+// tests/booktablemodel/tst_booktablemodel.cpp
+#include <QtTest>
+#include "testcatalog.h"
+#include "booktablemodel.h"
+
+// 模拟视图从头滚动到第10万行：每次滚到底部时 fetchMore 取下一页，
+// 等该页加载完，再像视图一样只取新出现的一屏单元格
+class BookTableModelBench : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void scroll_data();
+    void scroll();
+
+private:
+    TestCatalog m_catalog;
+};
+
+static const int ScrollRows = 100000;
+static const int VisibleRows = 30;
+static const int PageTimeoutMs = 10000;
+
+void BookTableModelBench::initTestCase()
+{
+    QVERIFY(m_catalog.open());
+    QVERIFY(m_catalog.seed(ScrollRows));
+}
+
+void BookTableModelBench::cleanupTestCase()
+{
+    m_catalog.close();
+}
+
+void BookTableModelBench::scroll_data()
+{
+    QTest::addColumn<int>("column");
+
+    QTest::newRow("title") << int(BookTableModel::TitleColumn);
+    QTest::newRow("available") << int(BookTableModel::AvailableColumn);
+    QTest::newRow("rating") << int(BookTableModel::RatingColumn);
+}
+
+void BookTableModelBench::scroll()
+{
+    QFETCH(int, column);
+
+    BookTableModel model(m_catalog.library()->workerPool());
+    QBENCHMARK {
+        model.browse(column, Qt::AscendingOrder);
+        while(model.rowCount() < ScrollRows) {
+            QTRY_VERIFY_WITH_TIMEOUT(!model.isLoading(), PageTimeoutMs);
+            int rows = model.rowCount();
+            for(int row = qMax(0, rows - VisibleRows); row < rows; ++row) {
+                for(int c = 0; c < BookTableModel::ColumnCount; ++c) {
+                    model.data(model.index(row, c));
+                }
+            }
+            if(rows >= ScrollRows) break;
+            QVERIFY(model.canFetchMore(QModelIndex()));
+            model.fetchMore(QModelIndex());
+        }
+    }
+    QVERIFY(model.rowCount() >= ScrollRows);
+}
+
+QTEST_GUILESS_MAIN(BookTableModelBench)
+
+#include "tst_booktablemodel.moc"
@@ -0,0 +1,7 @@
+# 馆藏规模 QBENCHMARK 套件：1万/10万/100万册下的检索、借还、入库和逾期批处理
+TARGET = tst_catalogbench
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_catalogbench.cpp
@@ -0,0 +1,149 @@
+// tests/catalogbench/tst_catalogbench.cpp
+#include <QtTest>
+#include "testcatalog.h"
+#include "overdueengine.h"
+
+// 与 corebench 相同的各项操作，改用 QBENCHMARK 计时。
+// 数据行按规模从小到大排列，馆藏只补齐不删除；只跑一行时用 tst_catalogbench catalog:10k/searchBooks。
+// 机器可读的结果用 QtTest 自带的输出格式，例如 tst_catalogbench -o result.csv,csv 或 -o result.xml,xml
+class CatalogBench : public QObject
+{
+    Q_OBJECT
+public:
+    enum Operation {
+        SearchBooks,
+        GetTopRatedBooks,
+        BorrowBook,
+        ReturnBook,
+        AddBook,
+        CheckOverdueBooks
+    };
+
+    CatalogBench();
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void catalog_data();
+    void catalog();
+
+private:
+    void measureCirculation(int size, Operation operation);
+
+    TestCatalog m_catalog;
+    int m_seeded;
+    int m_added;
+};
+
+static const int CirculationMs = 1000;
+
+CatalogBench::CatalogBench()
+    : m_seeded(0), m_added(0)
+{
+}
+
+void CatalogBench::initTestCase()
+{
+    QVERIFY(m_catalog.open());
+    QVERIFY(m_catalog.fixture()->setUp());
+}
+
+void CatalogBench::cleanupTestCase()
+{
+    m_catalog.close();
+}
+
+void CatalogBench::catalog_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("operation");
+
+    const struct { int size; const char *name; } sizes[] = {
+        {10000, "10k"}, {100000, "100k"}, {1000000, "1M"}
+    };
+    const struct { Operation operation; const char *name; } operations[] = {
+        {SearchBooks, "searchBooks"},
+        {GetTopRatedBooks, "getTopRatedBooks"},
+        {BorrowBook, "borrowBook"},
+        {ReturnBook, "returnBook"},
+        {AddBook, "addBook"},
+        {CheckOverdueBooks, "checkOverdueBooks"}
+    };
+    for(const auto &size : sizes) {
+        for(const auto &op : operations) {
+            QTest::newRow(qPrintable(QString("%1/%2").arg(size.name, op.name))) << size.size << int(op.operation);
+        }
+    }
+}
+
+void CatalogBench::catalog()
+{
+    QFETCH(int, size);
+    QFETCH(int, operation);
+
+    if(size > m_seeded) {
+        QVERIFY(m_catalog.seed(size));
+        QVERIFY(m_catalog.fixture()->seedOverdueLoans(size / 20));
+        m_seeded = size;
+    }
+
+    Library *library = m_catalog.library();
+
+    switch(operation) {
+    case SearchBooks: {
+        int query = 0;
+        QBENCHMARK {
+            library->searchBooks(CatalogBenchmark::searchKeyword(query++));
+        }
+        break;
+    }
+    case GetTopRatedBooks:
+        QBENCHMARK {
+            library->getTopRatedBooks(10);
+        }
+        break;
+    case BorrowBook:
+    case ReturnBook:
+        measureCirculation(size, Operation(operation));
+        break;
+    case AddBook:
+        QBENCHMARK {
+            QString isbn = QString("BENCH-ADD-%1").arg(m_added++, 7, 10, QChar('0'));
+            QVERIFY(library->addBook(isbn, "Added Benchmark Book", "Bench Author", 1));
+        }
+        break;
+    case CheckOverdueBooks:
+        // checkOverdueBooks 的工作全部在 OverdueEngine 中；演练模式执行完整批处理后回滚
+        QBENCHMARK {
+            QVERIFY(OverdueEngine::run(QDate::currentDate(), true).ok);
+        }
+        break;
+    }
+}
+
+// 借和还必须成对执行，QBENCHMARK 无法只计其中一半：手工计时后用 setBenchmarkResult 报告单次耗时
+void CatalogBench::measureCirculation(int size, Operation operation)
+{
+    Library *library = m_catalog.library();
+    QString userId = CatalogBenchmark::borrowerId();
+    qint64 nanoseconds = 0;
+    int iterations = 0;
+    QElapsedTimer total;
+    total.start();
+    while(total.elapsed() < CirculationMs) {
+        QString isbn = CatalogBenchmark::catalogIsbn(iterations % size);
+        QElapsedTimer timer;
+        timer.start();
+        QVERIFY(library->borrowBook(userId, isbn));
+        if(operation == BorrowBook) nanoseconds += timer.nsecsElapsed();
+        timer.restart();
+        QVERIFY(library->returnBook(userId, isbn));
+        if(operation == ReturnBook) nanoseconds += timer.nsecsElapsed();
+        iterations++;
+    }
+    QTest::setBenchmarkResult(nanoseconds / 1e6 / iterations, QTest::WalltimeMilliseconds);
+}
+
+QTEST_GUILESS_MAIN(CatalogBench)
+
+#include "tst_catalogbench.moc"
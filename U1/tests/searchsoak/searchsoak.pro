@@ -0,0 +1,7 @@
+# 检索浸泡测试：连续1万次检索，常驻内存不应持续增长
+TARGET = tst_searchsoak
+
+include(../tests.pri)
+
+SOURCES += \
+    tst_searchsoak.cpp
@@ -0,0 +1,70 @@
+// tests/searchsoak/tst_searchsoak.cpp
+#include <QtTest>
+#include <QFile>
+#include "testcatalog.h"
+
+// 检索结果是值类型，随结果列表一起释放。先预热让各级缓存填满，
+// 之后1万次检索的常驻内存增长应在 MaxGrowthKb 以内
+class SearchSoak : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+    void searchBooks();
+
+private:
+    TestCatalog m_catalog;
+};
+
+static const int CatalogSize = 10000;
+static const int WarmUpSearches = 1000;
+static const int SoakSearches = 10000;
+static const qint64 MaxGrowthKb = 8 * 1024;
+
+// 常驻内存（KB），取不到时返回 -1
+static qint64 residentKb()
+{
+    QFile statm("/proc/self/statm");
+    if(!statm.open(QIODevice::ReadOnly)) return -1;
+    QList<QByteArray> fields = statm.readAll().split(' ');
+    if(fields.size() < 2) return -1;
+    return fields.at(1).toLongLong() * 4;   // 页数，按 4KB 页计
+}
+
+void SearchSoak::initTestCase()
+{
+    if(residentKb() < 0) QSKIP("/proc/self/statm is not available on this platform");
+    QVERIFY(m_catalog.open());
+    QVERIFY(m_catalog.seed(CatalogSize));
+}
+
+void SearchSoak::cleanupTestCase()
+{
+    m_catalog.close();
+}
+
+void SearchSoak::searchBooks()
+{
+    Library *library = m_catalog.library();
+    int query = 0;
+    for(int i = 0; i < WarmUpSearches; ++i) {
+        library->searchBooks(CatalogBenchmark::searchKeyword(query++));
+    }
+    qint64 before = residentKb();
+
+    qint64 rows = 0;
+    for(int i = 0; i < SoakSearches; ++i) {
+        rows += library->searchBooks(CatalogBenchmark::searchKeyword(query++)).size();
+    }
+    qint64 after = residentKb();
+
+    QVERIFY(rows > 0);
+    qDebug() << "Resident memory before" << before << "KB, after" << after << "KB";
+    QVERIFY2(after - before <= MaxGrowthKb,
+             qPrintable(QString("resident memory grew by %1 KB").arg(after - before)));
+}
+
+QTEST_GUILESS_MAIN(SearchSoak)
+
+#include "tst_searchsoak.moc"
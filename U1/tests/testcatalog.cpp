@@ -0,0 +1,36 @@
+// tests/testcatalog.cpp
+#include "testcatalog.h"
+#include "testdatabase.h"
+#include <QTextStream>
+
+bool TestCatalog::open()
+{
+    if(!TestDatabase::open()) return false;
+    m_library.reset(new Library());
+    m_fixture.reset(new CatalogBenchmark(m_library.data()));
+    return true;
+}
+
+bool TestCatalog::seed(int size)
+{
+    QString log;
+    QTextStream out(&log);
+    return m_fixture->seedCatalog(size, out);
+}
+
+void TestCatalog::close()
+{
+    if(!m_fixture) return;
+    m_fixture->tearDown();
+    m_fixture->deleteCatalog();
+}
+
+Library* TestCatalog::library() const
+{
+    return m_library.data();
+}
+
+CatalogBenchmark* TestCatalog::fixture() const
+{
+    return m_fixture.data();
+}
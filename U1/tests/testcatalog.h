@@ -0,0 +1,27 @@
+// tests/testcatalog.h
+#ifndef TESTCATALOG_H
+#define TESTCATALOG_H
+
+#include <QScopedPointer>
+#include "library.h"
+#include "catalogbenchmark.h"
+
+// 各测试共用的测试馆藏：打开测试库，创建 Library 和 CatalogBenchmark，按需补齐测试图书。
+// 在 initTestCase 里 open()，cleanupTestCase 里 close() 清理测试读者、借阅和图书
+class TestCatalog
+{
+public:
+    bool open();
+    // 补齐到 size 册，进度输出丢弃
+    bool seed(int size);
+    void close();
+
+    Library* library() const;
+    CatalogBenchmark* fixture() const;
+
+private:
+    QScopedPointer<Library> m_library;
+    QScopedPointer<CatalogBenchmark> m_fixture;
+};
+
+#endif // TESTCATALOG_H
@@ -0,0 +1,25 @@
+// tests/testdatabase.cpp
+#include "testdatabase.h"
+#include "database.h"
+#include <QTemporaryDir>
+#include <QSettings>
+#include <QDebug>
+
+bool TestDatabase::open()
+{
+    QString configFile = qEnvironmentVariable("LIBRARY_TEST_CONFIG");
+    if(configFile.isEmpty()) {
+        static QTemporaryDir dir;
+        if(!dir.isValid()) {
+            qDebug() << "Test database: cannot create temporary directory";
+            return false;
+        }
+        configFile = dir.filePath("library.ini");
+        QSettings settings(configFile, QSettings::IniFormat);
+        settings.setValue("storage/backend", "sqlite");
+        settings.setValue("sqlite/path", "library.db");
+        settings.sync();
+    }
+    Database::setConfigFile(configFile);
+    return Database::instance()->initialize();
+}
@@ -0,0 +1,13 @@
+// tests/testdatabase.h
+#ifndef TESTDATABASE_H
+#define TESTDATABASE_H
+
+// 测试用的数据库：环境变量 LIBRARY_TEST_CONFIG 指定配置文件时用它（例如连 MySQL），
+// 否则在临时目录里新建一个 SQLite 库，进程退出时删除。须在第一次调用 Database::instance() 之前调用
+class TestDatabase
+{
+public:
+    static bool open();
+};
+
+#endif // TESTDATABASE_H
@@ -0,0 +1,18 @@
+# 各测试程序的公共设置；make check 依次运行
+QT = core testlib
+CONFIG += testcase console c++11
+CONFIG -= app_bundle
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../core.pri)
+
+INCLUDEPATH += $$PWD
+
+SOURCES += \
+    $$PWD/testcatalog.cpp \
+    $$PWD/testdatabase.cpp
+
+HEADERS += \
+    $$PWD/testcatalog.h \
+    $$PWD/testdatabase.h
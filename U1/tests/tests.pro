@@ -0,0 +1,7 @@
+# QtTest 测试，都只链接核心库
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    catalogbench \
+    booktablemodel \
+    searchsoak
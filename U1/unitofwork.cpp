@@ -0,0 +1,217 @@
+// src/unitofwork.cpp
+#include "unitofwork.h"
+#include "database.h"
+#include "entitycache.h"
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVariantList>
+#include <QDebug>
+
+static thread_local UnitOfWork *t_currentWork = nullptr;
+
+// 合并后写的阅读时长增量，所有线程共用
+static QMutex s_writeBehindMutex;
+static QHash<QString, double> s_pendingReadingHours;
+
+UnitOfWork::Scope::Scope() : m_work(t_currentWork), m_owner(false)
+{
+    if(!m_work) {
+        m_work = new UnitOfWork;
+        m_owner = true;
+        t_currentWork = m_work;
+    }
+}
+
+UnitOfWork::Scope::~Scope()
+{
+    if(m_owner) {
+        if(!m_work->flush()) {
+            qDebug() << "Unit of work flush failed, pending changes dropped";
+        }
+        t_currentWork = nullptr;
+        delete m_work;
+    }
+}
+
+// 内层作用域不提交，交给最外层
+bool UnitOfWork::Scope::commit()
+{
+    return m_owner ? m_work->flush() : true;
+}
+
+UnitOfWork* UnitOfWork::Scope::unitOfWork() const
+{
+    return m_work;
+}
+
+UnitOfWork::UnitOfWork()
+{
+    m_users.name = "Users";
+    m_users.keyColumn = "UserID";
+    m_books.name = "Books";
+    m_books.keyColumn = "ISBN";
+}
+
+UnitOfWork* UnitOfWork::current()
+{
+    return t_currentWork;
+}
+
+bool UnitOfWork::updateUser(const QString &userId, const QVariantMap &fields)
+{
+    if(fields.isEmpty()) return true;
+    if(UnitOfWork *work = current()) {
+        markDirty(work->m_users, userId, fields);
+        return true;
+    }
+    bool ok = writeRow("Users", "UserID", userId, fields);
+    invalidate("Users", userId);
+    return ok;
+}
+
+bool UnitOfWork::updateBook(const QString &isbn, const QVariantMap &fields)
+{
+    if(fields.isEmpty()) return true;
+    if(UnitOfWork *work = current()) {
+        markDirty(work->m_books, isbn, fields);
+        return true;
+    }
+    bool ok = writeRow("Books", "ISBN", isbn, fields);
+    invalidate("Books", isbn);
+    return ok;
+}
+
+void UnitOfWork::markDirty(Table &table, const QString &key, const QVariantMap &fields)
+{
+    auto it = table.dirty.find(key);
+    if(it == table.dirty.end()) {
+        table.order.append(key);
+        it = table.dirty.insert(key, QVariantMap());
+    }
+    // 同一字段多次修改只保留最后一次
+    for(auto field = fields.constBegin(); field != fields.constEnd(); ++field) {
+        it.value().insert(field.key(), field.value());
+    }
+}
+
+// 列名按字母序拼接，同一组字段复用同一条预编译语句
+bool UnitOfWork::writeRow(const QString &table, const QString &keyColumn,
+                          const QString &key, const QVariantMap &fields)
+{
+    QStringList assignments;
+    QVariantList params;
+    for(auto field = fields.constBegin(); field != fields.constEnd(); ++field) {
+        assignments << field.key() + " = ?";
+        params << field.value();
+    }
+    params << key;
+
+    QString name = QString("uow.%1.%2").arg(table, QStringList(fields.keys()).join('.'));
+    QString sql = QString("UPDATE %1 SET %2 WHERE %3 = ?").arg(table, assignments.join(", "), keyColumn);
+    return Database::instance()->executePrepared(name, sql, params);
+}
+
+void UnitOfWork::invalidate(const QString &table, const QString &key)
+{
+    if(table == "Users") {
+        EntityCache::instance()->invalidateUser(key);
+    } else {
+        EntityCache::instance()->invalidateBook(key);
+    }
+}
+
+bool UnitOfWork::isDirty() const
+{
+    return !m_users.dirty.isEmpty() || !m_books.dirty.isEmpty();
+}
+
+bool UnitOfWork::flush()
+{
+    if(!isDirty()) return true;
+
+    // 调用方已开启事务时并入其中，否则自己开一个
+    Database *db = Database::instance();
+    bool ownTransaction = !db->inTransaction();
+    if(ownTransaction && !db->transaction()) return false;
+
+    bool ok = true;
+    Table *tables[] = { &m_users, &m_books };
+    for(Table *table : tables) {
+        foreach (const QString &key, table->order) {
+            if(!writeRow(table->name, table->keyColumn, key, table->dirty.value(key))) {
+                ok = false;
+                break;
+            }
+        }
+        if(!ok) break;
+    }
+
+    if(ownTransaction) {
+        if(ok) {
+            ok = db->commit();
+        } else {
+            db->rollback();
+        }
+    }
+
+    for(Table *table : tables) {
+        foreach (const QString &key, table->order) {
+            invalidate(table->name, key);
+        }
+        table->dirty.clear();
+        table->order.clear();
+    }
+    return ok;
+}
+
+void UnitOfWork::addReadingHoursLater(const QString &userId, float hours)
+{
+    if(hours == 0.0f) return;
+    QMutexLocker lock(&s_writeBehindMutex);
+    s_pendingReadingHours[userId] += hours;
+}
+
+bool UnitOfWork::flushWriteBehind()
+{
+    QHash<QString, double> pending;
+    {
+        QMutexLocker lock(&s_writeBehindMutex);
+        pending.swap(s_pendingReadingHours);
+    }
+    if(pending.isEmpty()) return true;
+
+    Database *db = Database::instance();
+    if(!db->transaction()) {
+        QMutexLocker lock(&s_writeBehindMutex);
+        for(auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            s_pendingReadingHours[it.key()] += it.value();
+        }
+        return false;
+    }
+
+    bool ok = true;
+    for(auto it = pending.constBegin(); ok && it != pending.constEnd(); ++it) {
+        ok = db->executePrepared("uow.addReadingHours",
+            "UPDATE Users SET TotalReadingHours = TotalReadingHours + ? WHERE UserID = ?",
+            {it.value(), it.key()});
+    }
+    if(ok) {
+        ok = db->commit();
+    } else {
+        db->rollback();
+    }
+
+    if(!ok) {
+        // 写失败放回队列，下次再试
+        QMutexLocker lock(&s_writeBehindMutex);
+        for(auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+            s_pendingReadingHours[it.key()] += it.value();
+        }
+        return false;
+    }
+
+    for(auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        EntityCache::instance()->invalidateUser(it.key());
+    }
+    return true;
+}
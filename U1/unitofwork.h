@@ -0,0 +1,64 @@
+// include/unitofwork.h
+#ifndef UNITOFWORK_H
+#define UNITOFWORK_H
+
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QVariantMap>
+
+// 工作单元：一次业务操作内对 Users/Books 的字段修改只记为脏字段，
+// 结束时每行合成一条 UPDATE 在同一个事务中写入，写完统一让实体缓存失效。
+// 作用域按线程生效，嵌套时复用最外层；没有作用域时修改立即写库（每次调用仍只写一条语句）。
+// 会连续改同一行的操作（用信用分缴罚款）在 User 里开作用域。
+//
+// 阅读时长等低优先级的累加字段走合并后写：先在内存中按用户累加，由 flushWriteBehind() 定期写入。
+class UnitOfWork
+{
+public:
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope(); // 最外层作用域结束时提交
+        bool commit();
+        UnitOfWork* unitOfWork() const;
+
+    private:
+        UnitOfWork *m_work;
+        bool m_owner;
+        Scope(const Scope &);
+        Scope &operator=(const Scope &);
+    };
+
+    // 当前线程活动的工作单元，没有作用域时为 nullptr
+    static UnitOfWork* current();
+
+    static bool updateUser(const QString &userId, const QVariantMap &fields);
+    static bool updateBook(const QString &isbn, const QVariantMap &fields);
+
+    static void addReadingHoursLater(const QString &userId, float hours);
+    static bool flushWriteBehind();
+
+    bool isDirty() const;
+    bool flush();
+
+private:
+    struct Table {
+        QString name;
+        QString keyColumn;
+        QHash<QString, QVariantMap> dirty;
+        QStringList order; // 按首次修改的顺序写，多行时加锁顺序稳定
+    };
+
+    UnitOfWork();
+    static void markDirty(Table &table, const QString &key, const QVariantMap &fields);
+    static bool writeRow(const QString &table, const QString &keyColumn,
+                         const QString &key, const QVariantMap &fields);
+    static void invalidate(const QString &table, const QString &key);
+
+    Table m_users;
+    Table m_books;
+};
+
+#endif // UNITOFWORK_H
@@ -1,6 +1,7 @@
 // src/user.cpp
 #include "user.h"
 #include "database.h"
+#include "unitofwork.h"
 #include <QSqlQuery>
 #include <QDateTime>
 #include <random>
@@ -44,26 +45,29 @@ int User::borrowDays() const {
 bool User::upgradeToSuper()
 {
     if(m_type == Normal && m_readingHours >= 200.0 && canUpgrade()) {
+        int oldCreditScore = m_creditScore;
         m_type = Super;
         m_maxBorrow = 8;
         m_borrowDays = 28;
         m_creditScore = 120; // 升级后信用分设为120
 
-        // 更新数据库
-        QString query = QString(
-            "UPDATE Users SET Type = 'Super', "
-            "MaxBorrow = 8, BorrowDays = 28, "
-            "CreditScore = 120 "
-            "WHERE UserID = '%1'"
-        ).arg(m_id);
-
-        if(Database::instance()->execute(query)) {
-            QMessageBox::information(nullptr, "升级成功",
-                "恭喜您已升级为超级读者！\n"
-                "新的借阅权限：最多可借8本书，借期4周\n"
-                "信用分已提升至120");
+        // 更新数据库；借阅上限和期限由类型决定，表里没有对应的列
+        QVariantMap fields;
+        fields.insert("Type", "Super");
+        fields.insert("CreditScore", 120);
+
+        // 不在工作单元中调用，立即写库，写成功后才算升级
+        if(UnitOfWork::updateUser(m_id, fields)) {
+            emit upgraded();
             return true;
         }
+
+        // 写库失败，恢复为普通读者
+        m_type = Normal;
+        m_maxBorrow = 5;
+        m_borrowDays = 14;
+        m_creditScore = oldCreditScore;
+        qDebug() << "Upgrade to super reader failed:" << m_id;
     }
     return false;
 }
@@ -72,11 +76,8 @@ void User::addReadingHours(float hours)
 {
     m_readingHours += hours;
 
-    // 更新数据库
-    QSqlQuery q = Database::instance()->executeQuery(
-        QString("UPDATE Users SET TotalReadingHours = %1 WHERE UserID = '%2'")
-        .arg(m_readingHours).arg(m_id)
-    );
+    // 阅读时长优先级低，合并后定期写库；达标升级立即写库
+    UnitOfWork::addReadingHoursLater(m_id, hours);
 
     // 检查是否需要升级
     if(m_type == Normal && m_readingHours >= 200.0) {
@@ -89,10 +90,7 @@ void User::addFine(double amount)
     m_fines += amount;
 
     // 更新数据库
-    Database::instance()->execute(
-        QString("UPDATE Users SET Fines = %1 WHERE UserID = '%2'")
-        .arg(m_fines).arg(m_id)
-    );
+    UnitOfWork::updateUser(m_id, {{"Fines", m_fines}});
 }
 
 void User::payFine(double amount)
@@ -101,10 +99,7 @@ void User::payFine(double amount)
     m_fines -= amount;
 
     // 更新数据库
-    Database::instance()->execute(
-        QString("UPDATE Users SET Fines = %1 WHERE UserID = '%2'")
-        .arg(m_fines).arg(m_id)
-    );
+    UnitOfWork::updateUser(m_id, {{"Fines", m_fines}});
 }
 
 void User::payFineWithCredit(double amount)
@@ -112,6 +107,8 @@ void User::payFineWithCredit(double amount)
     // 1元补1信用分
     int creditToAdd = static_cast<int>(amount);
     if(creditToAdd > 0) {
+        // 信用分和罚款是同一行，一条 UPDATE 写入
+        UnitOfWork::Scope work;
         addCreditScore(creditToAdd);
         payFine(amount);
     }
@@ -124,20 +121,17 @@ void User::setCreditScore(int score)
 
     m_creditScore = score;
 
-    // 更新数据库
-    Database::instance()->execute(
-        QString("UPDATE Users SET CreditScore = %1 WHERE UserID = '%2'")
-        .arg(score).arg(m_id)
-    );
+    QVariantMap fields;
+    fields.insert("CreditScore", score);
 
-    // 检查是否首次低于90分
+    // 检查是否首次低于90分，与信用分合并成一条 UPDATE
     if(m_creditScore < 90 && !m_hadLowCredit) {
         m_hadLowCredit = true;
-        Database::instance()->execute(
-            QString("UPDATE Users SET HadLowCredit = TRUE WHERE UserID = '%1'")
-            .arg(m_id)
-        );
+        fields.insert("HadLowCredit", true);
     }
+
+    // 更新数据库
+    UnitOfWork::updateUser(m_id, fields);
 }
 
 void User::setHadLowCredit(bool had)
@@ -4,7 +4,6 @@
 
 #include <QObject>
 #include <QString>
-#include <QMessageBox>
 
 class User : public QObject
 {
@@ -32,7 +31,7 @@ public:
     int maxBorrowCount() const;
     int borrowDays() const;
 
-    // 升级功能
+    // 升级功能；在工作单元作用域外调用，写库成功后才发出 upgraded()
     bool upgradeToSuper();
     void addReadingHours(float hours);
 
@@ -52,6 +51,10 @@ public:
     // 用户ID生成
     static QString generateUserId();
 
+signals:
+    // 升级为超级读者后发出，由界面负责提示
+    void upgraded();
+
 private:
     QString m_id;
     QString m_email;
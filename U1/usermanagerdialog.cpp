@@ -1,5 +1,6 @@
 #include "usermanagerdialog.h"
 #include "ui_usermanagerdialog.h"
+#include <QtConcurrent>
 
 UserManagerDialog::UserManagerDialog(Library *library, QWidget *parent)
     : QDialog(parent), ui(new Ui::UserManagerDialog), m_library(library)
@@ -10,20 +11,50 @@ UserManagerDialog::UserManagerDialog(Library *library, QWidget *parent)
 
 UserManagerDialog::~UserManagerDialog()
 {
+    // 读取还没结束时让它在下一行停下，等它退出后再销毁界面
+    m_cancelled.storeRelease(1);
+    m_loading.waitForFinished();
     delete ui;
 }
 
+static const int AppendBatchRows = 500;
+
 void UserManagerDialog::loadUsers()
 {
-    QList<User*> users = m_library->getAllUsers();
-    ui->tblUsers->setRowCount(users.size());
-    for(int i=0; i<users.size(); ++i) {
-        User *u = users[i];
-        ui->tblUsers->setItem(i, 0, new QTableWidgetItem(u->id()));
-        ui->tblUsers->setItem(i, 1, new QTableWidgetItem(u->name()));
-        ui->tblUsers->setItem(i, 2, new QTableWidgetItem(u->email()));
-        ui->tblUsers->setItem(i, 3, new QTableWidgetItem(u->type() == User::Super ? "管理员" : "读者"));
-        ui->tblUsers->setItem(i, 4, new QTableWidgetItem(QString::number(u->creditScore())));
-        ui->tblUsers->setItem(i, 5, new QTableWidgetItem(QString::number(u->fines(), 'f', 2)));
+    // 在工作线程上分块读取，每攒够一批排队交给界面线程追加，对话框打开后立即可用
+    ui->tblUsers->setRowCount(0);
+    m_loading = QtConcurrent::run(m_library->workerPool(), [this]() {
+        UserRecordList batch;
+        m_library->visitUsers([this, &batch](const UserRecord &u) {
+            if(m_cancelled.loadAcquire()) return false;
+            batch.append(u);
+            if(batch.size() >= AppendBatchRows) {
+                UserRecordList rows;
+                rows.swap(batch);
+                QMetaObject::invokeMethod(this, [this, rows]() { appendUsers(rows); }, Qt::QueuedConnection);
+            }
+            return true;
+        });
+        if(!batch.isEmpty() && !m_cancelled.loadAcquire()) {
+            QMetaObject::invokeMethod(this, [this, batch]() { appendUsers(batch); }, Qt::QueuedConnection);
+        }
+    });
+}
+
+void UserManagerDialog::appendUsers(const UserRecordList &users)
+{
+    int first = ui->tblUsers->rowCount();
+    ui->tblUsers->setUpdatesEnabled(false);
+    ui->tblUsers->setRowCount(first + users.size());
+    for(int k = 0; k < users.size(); ++k) {
+        const UserRecord &u = users.at(k);
+        int i = first + k;
+        ui->tblUsers->setItem(i, 0, new QTableWidgetItem(u.id()));
+        ui->tblUsers->setItem(i, 1, new QTableWidgetItem(u.name()));
+        ui->tblUsers->setItem(i, 2, new QTableWidgetItem(u.email()));
+        ui->tblUsers->setItem(i, 3, new QTableWidgetItem(u.type() == User::Super ? "管理员" : "读者"));
+        ui->tblUsers->setItem(i, 4, new QTableWidgetItem(QString::number(u.creditScore())));
+        ui->tblUsers->setItem(i, 5, new QTableWidgetItem(QString::number(u.fines(), 'f', 2)));
     }
+    ui->tblUsers->setUpdatesEnabled(true);
 }
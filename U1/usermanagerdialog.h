@@ -2,6 +2,8 @@
 #define USERMANAGERDIALOG_H
 
 #include <QDialog>
+#include <QFuture>
+#include <QAtomicInt>
 #include "library.h"
 #include "ui_usermanagerdialog.h"
 
@@ -20,7 +22,10 @@ public:
 private:
     Ui::UserManagerDialog *ui;
     Library *m_library;
+    QFuture<void> m_loading;
+    QAtomicInt m_cancelled;     // 对话框关闭时通知工作线程停止读取
     void loadUsers();
+    void appendUsers(const UserRecordList &users);
 };
 
 #endif // USERMANAGERDIALOG_H